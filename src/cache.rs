@@ -0,0 +1,157 @@
+//! On-disk cache for derived data (symbol outlines, indexes)
+//!
+//! Lives in `$VITA_CACHE_DIR`, else `$XDG_CACHE_HOME/vita`, else
+//! `~/.cache/vita` (`%LOCALAPPDATA%\vita` on Windows). Every operation is
+//! best effort: a missing, unreadable or read-only cache only means the
+//! work is redone.
+
+use std::env;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, SystemTime};
+
+/// Bumped whenever a cached format changes; old entries are then ignored.
+const CACHE_VERSION: &str = "1";
+
+/// A bucket is swept for old entries at most this often
+const PRUNE_INTERVAL: Duration = Duration::from_secs(24 * 60 * 60);
+
+#[cfg(test)]
+thread_local! {
+    /// Cache root of the running test, so tests never touch the shared
+    /// process environment
+    static TEST_ROOT: std::cell::RefCell<Option<PathBuf>> = const { std::cell::RefCell::new(None) };
+}
+
+/// Use `root` in place of `$VITA_CACHE_DIR` on this thread.
+#[cfg(test)]
+pub fn set_test_root(root: Option<PathBuf>) {
+    TEST_ROOT.with(|r| *r.borrow_mut() = root);
+}
+
+/// Root cache directory for this vita version, if one can be determined.
+pub fn dir() -> Option<PathBuf> {
+    #[cfg(test)]
+    if let Some(root) = TEST_ROOT.with(|r| r.borrow().clone()) {
+        return Some(root);
+    }
+    let base = if let Some(dir) = env::var_os("VITA_CACHE_DIR") {
+        PathBuf::from(dir)
+    } else if let Some(dir) = env::var_os("XDG_CACHE_HOME") {
+        PathBuf::from(dir).join("vita")
+    } else if cfg!(windows) {
+        PathBuf::from(env::var_os("LOCALAPPDATA")?).join("vita")
+    } else {
+        PathBuf::from(env::var_os("HOME")?).join(".cache").join("vita")
+    };
+    Some(base.join(format!("v{}-{}", CACHE_VERSION, env!("CARGO_PKG_VERSION"))))
+}
+
+/// 64-bit key for cache entries derived from `parts` (content, language, …).
+///
+/// FNV-1a over each part and its length, so keys stay the same across
+/// Rust releases, unlike `DefaultHasher`.
+pub fn key(parts: &[&[u8]]) -> u64 {
+    let mut h: u64 = 0xcbf2_9ce4_8422_2325;
+    for part in parts {
+        for &b in (part.len() as u64).to_le_bytes().iter().chain(part.iter()) {
+            h = (h ^ b as u64).wrapping_mul(0x0100_0000_01b3);
+        }
+    }
+    h
+}
+
+/// Read entry `name` from `bucket`.
+pub fn read(bucket: &str, name: &str) -> Option<Vec<u8>> {
+    fs::read(dir()?.join(bucket).join(name)).ok()
+}
+
+/// Write entry `name` into `bucket` atomically (temp file + rename), so
+/// concurrent readers never see a partial entry.
+pub fn write(bucket: &str, name: &str, data: &[u8]) {
+    let Some(dir) = dir().map(|d| d.join(bucket)) else {
+        return;
+    };
+    if fs::create_dir_all(&dir).is_err() {
+        return;
+    }
+    let tmp = dir.join(format!(".{}.{}", name, std::process::id()));
+    if fs::write(&tmp, data).is_ok() && fs::rename(&tmp, dir.join(name)).is_err() {
+        let _ = fs::remove_file(&tmp);
+    }
+}
+
+/// Remove the entries of `bucket` not written for `max_age`. The sweep
+/// runs at most once per `PRUNE_INTERVAL`, tracked by a marker file.
+pub fn prune(bucket: &str, max_age: Duration) {
+    let Some(dir) = dir().map(|d| d.join(bucket)) else {
+        return;
+    };
+    let now = SystemTime::now();
+    let age = |path: &Path| {
+        let modified = fs::metadata(path).and_then(|m| m.modified()).ok()?;
+        now.duration_since(modified).ok()
+    };
+    let marker = dir.join(".pruned");
+    if age(&marker).is_some_and(|a| a < PRUNE_INTERVAL) || fs::write(&marker, b"").is_err() {
+        return;
+    }
+    let Ok(entries) = fs::read_dir(&dir) else {
+        return;
+    };
+    for entry in entries.flatten() {
+        let path = entry.path();
+        if path != marker && age(&path).is_some_and(|a| a > max_age) {
+            let _ = fs::remove_file(&path);
+        }
+    }
+}
+
+/// Append `s` with its length, for binary entries read back by `Cursor`.
+pub fn put_str(buf: &mut Vec<u8>, s: &str) {
+    buf.extend_from_slice(&(s.len() as u32).to_le_bytes());
+    buf.extend_from_slice(s.as_bytes());
+}
+
+/// Reads a binary entry front to back; `None` once it runs short.
+pub struct Cursor<'a>(pub &'a [u8]);
+
+impl<'a> Cursor<'a> {
+    pub fn take(&mut self, n: usize) -> Option<&'a [u8]> {
+        if self.0.len() < n {
+            return None;
+        }
+        let (head, tail) = self.0.split_at(n);
+        self.0 = tail;
+        Some(head)
+    }
+
+    pub fn u32(&mut self) -> Option<u32> {
+        Some(u32::from_le_bytes(self.take(4)?.try_into().ok()?))
+    }
+
+    pub fn u64(&mut self) -> Option<u64> {
+        Some(u64::from_le_bytes(self.take(8)?.try_into().ok()?))
+    }
+
+    pub fn str(&mut self) -> Option<String> {
+        let len = self.u32()? as usize;
+        String::from_utf8(self.take(len)?.to_vec()).ok()
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_key_is_fixed() {
+        // Stored entry names must not change between builds
+        assert_eq!(key(&[]), 0xcbf2_9ce4_8422_2325);
+        assert_eq!(key(&[b"ab", b"c"]), key(&[b"ab", b"c"]));
+        assert_ne!(key(&[b"ab", b"c"]), key(&[b"a", b"bc"]));
+        assert_eq!(key(&[b"vita"]), 0x3da5_9003_9ff2_42f3);
+    }
+}
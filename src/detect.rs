@@ -83,7 +83,7 @@ pub fn detect_format(path: &Path) -> FileFormat {
         "md" | "markdown" | "mdown" | "mkd" => FileFormat::Markdown,
 
         // JSON
-        "json" | "jsonc" | "geojson" | "jsonl" => FileFormat::Json,
+        "json" | "jsonc" | "geojson" | "jsonl" | "ndjson" => FileFormat::Json,
 
         // CSV/TSV
         "csv" | "tsv" => FileFormat::Csv,
@@ -226,7 +226,7 @@ pub fn detect_from_content(content: &str) -> FileFormat {
 
     // JSON
     if trimmed.starts_with('{') || trimmed.starts_with('[') {
-        if serde_json::from_str::<serde_json::Value>(content).is_ok() {
+        if crate::jsondoc::Document::parse(content).is_ok() || is_ndjson(trimmed) {
             return FileFormat::Json;
         }
     }
@@ -266,10 +266,14 @@ pub fn detect_from_content(content: &str) -> FileFormat {
         }
     }
 
-    // Diff
+    // Diff, or `git log -p` / `git show` output
+    let commit = trimmed
+        .strip_prefix("commit ")
+        .map_or(false, |rest| rest.len() >= 40 && rest.bytes().take(40).all(|b| b.is_ascii_hexdigit()));
     if trimmed.starts_with("diff --git")
         || trimmed.starts_with("--- ")
         || trimmed.starts_with("+++ ")
+        || commit
     {
         return FileFormat::Code("Diff".into());
     }
@@ -292,3 +296,9 @@ pub fn detect_from_content(content: &str) -> FileFormat {
 
     FileFormat::Plain
 }
+
+/// NDJSON: the first (up to) three non-blank lines each parse as JSON.
+fn is_ndjson(content: &str) -> bool {
+    let mut lines = content.lines().map(str::trim).filter(|l| !l.is_empty()).take(3).peekable();
+    lines.peek().is_some() && lines.all(|l| crate::jsondoc::Document::parse(l).is_ok())
+}
@@ -0,0 +1,622 @@
+//! Line diff (Myers, linear space)
+//!
+//! Finds the longest run of unchanged elements between two sequences with
+//! Myers' O(ND) algorithm in its divide-and-conquer form, which needs only
+//! O(N + M) memory. Common prefixes and suffixes are stripped at every
+//! step, so the typical small edit to a large file costs little more than
+//! one comparison pass. Callers diff hashed or interned lines.
+//!
+//! Where an insertion or deletion could sit in several equally short
+//! places (a blank line next to blank-line-separated items, say), it is
+//! placed the way git places it, including git's indent heuristic for
+//! lines, so results line up with `git diff` and `git blame`.
+
+use std::ops::{Index, IndexMut, Range};
+
+/// Past this many edit steps in one middle-snake search the remaining
+/// region is treated as replaced outright, bounding the worst case.
+const MAX_EDIT_COST: usize = 1 << 14;
+
+/// Index pairs `(i, j)` with `a[i] == b[j]` left unchanged by a shortest
+/// edit script, in ascending order.
+pub fn matches<T: PartialEq>(a: &[T], b: &[T]) -> Vec<(usize, usize)> {
+    compacted(a, b, None).0
+}
+
+/// A line as the diff sees it: compared by hash, with its indentation
+/// kept to place ambiguous hunks the way git's indent heuristic does.
+#[derive(Clone, Copy, Debug)]
+pub struct Line {
+    hash: u64,
+    /// Columns of leading whitespace (tabs to multiples of 8), capped at
+    /// `MAX_INDENT`; -1 for a blank line
+    indent: i32,
+}
+
+impl PartialEq for Line {
+    fn eq(&self, other: &Line) -> bool {
+        self.hash == other.hash
+    }
+}
+
+impl Line {
+    pub fn new(text: &[u8]) -> Line {
+        // Multiply-rotate over 8-byte words, then the length, which tells
+        // apart tails differing only in trailing zero bytes. A collision
+        // would only misalign one line.
+        let mix = |h: u64, word: u64| (h.rotate_left(5) ^ word).wrapping_mul(0x517c_c1b7_2722_0a95);
+        let mut chunks = text.chunks_exact(8);
+        let mut hash = (&mut chunks).fold(0, |h, c| mix(h, u64::from_le_bytes(c.try_into().expect("8 bytes"))));
+        let mut tail = [0u8; 8];
+        tail[..chunks.remainder().len()].copy_from_slice(chunks.remainder());
+        hash = mix(mix(hash, u64::from_le_bytes(tail)), text.len() as u64);
+        let mut indent = 0;
+        let mut blank = true;
+        for &b in text {
+            match b {
+                b' ' => indent += 1,
+                b'\t' => indent += 8 - indent % 8,
+                b'\n' | b'\r' | 0x0b | 0x0c => {}
+                _ => {
+                    blank = false;
+                    break;
+                }
+            }
+            if indent >= MAX_INDENT {
+                blank = false;
+                break;
+            }
+        }
+        Line {
+            hash,
+            indent: if blank { -1 } else { indent.min(MAX_INDENT) },
+        }
+    }
+}
+
+/// `matches` for lines, placing ambiguous hunks by indentation as well.
+pub fn line_matches(a: &[Line], b: &[Line]) -> Vec<(usize, usize)> {
+    let indent = |lines: &[Line], i: usize| lines[i].indent;
+    compacted(a, b, Some(&indent)).0
+}
+
+/// `line_matches` for windows cut from longer sequences, where the lines
+/// cut off before (`cut_start`) and after (`cut_end`) are the same on both
+/// sides. Hunks may slide into unchanged lines, so this is `None` when one
+/// comes near enough a cut edge that its placement could depend on lines
+/// outside the window; the caller then diffs everything.
+pub fn line_matches_window(a: &[Line], b: &[Line], cut_start: bool, cut_end: bool) -> Option<Vec<(usize, usize)>> {
+    let indent = |lines: &[Line], i: usize| lines[i].indent;
+    let (pairs, reach_a, reach_b) = compacted(a, b, Some(&indent));
+    // Placement looks up to MAX_BLANKS lines past where a group can slide
+    let near = MAX_BLANKS as usize + 1;
+    let clear = |reach: Reach, len: usize| {
+        !(cut_start && reach.start <= near) && !(cut_end && reach.end + near >= len)
+    };
+    (clear(reach_a, a.len()) && clear(reach_b, b.len())).then_some(pairs)
+}
+
+/// Indentation of element `i` of a side, -1 when blank
+type IndentOf<'a, T> = &'a dyn Fn(&[T], usize) -> i32;
+
+/// Lowest start and highest end any group of changes took while placed
+#[derive(Clone, Copy)]
+struct Reach {
+    start: usize,
+    end: usize,
+}
+
+fn compacted<T: PartialEq>(a: &[T], b: &[T], indent: Option<IndentOf<T>>) -> (Vec<(usize, usize)>, Reach, Reach) {
+    let max_d = (a.len() + b.len() + 1) / 2 + 1;
+    let mut vf = V::new(max_d);
+    let mut vb = V::new(max_d);
+    let mut out = Vec::new();
+    conquer(a, 0..a.len(), b, 0..b.len(), &mut vf, &mut vb, &mut out);
+
+    let mut side_a = Side::new(a);
+    let mut side_b = Side::new(b);
+    for &(i, j) in &out {
+        side_a.changed[i + 1] = false;
+        side_b.changed[j + 1] = false;
+    }
+    let reach_a = compact(&mut side_a, &mut side_b, indent);
+    let reach_b = compact(&mut side_b, &mut side_a, indent);
+
+    // Unchanged elements pair up in order on both sides
+    let kept_a = (0..a.len()).filter(|&i| !side_a.changed[i + 1]);
+    let kept_b = (0..b.len()).filter(|&j| !side_b.changed[j + 1]);
+    (kept_a.zip(kept_b).collect(), reach_a, reach_b)
+}
+
+// ─── Hunk placement ───
+//
+// A port of git's `xdl_change_compact`. Each run of changed elements
+// (a group) is slid up and down as far as equal elements allow, merging
+// with groups it meets. It is then placed to line up with a change on the
+// other side if it can, or else at the position the indent heuristic
+// scores best, or else as low as possible. Sliding never changes which
+// values are kept or their order, so the result is still a longest
+// common subsequence.
+
+const MAX_INDENT: i32 = 200;
+const MAX_BLANKS: i32 = 20;
+const START_OF_FILE_PENALTY: i32 = 1;
+const END_OF_FILE_PENALTY: i32 = 21;
+const TOTAL_BLANK_WEIGHT: i32 = -30;
+const POST_BLANK_WEIGHT: i32 = 6;
+const RELATIVE_INDENT_PENALTY: i32 = -4;
+const RELATIVE_INDENT_WITH_BLANK_PENALTY: i32 = 10;
+const RELATIVE_OUTDENT_PENALTY: i32 = 24;
+const RELATIVE_OUTDENT_WITH_BLANK_PENALTY: i32 = 17;
+const RELATIVE_DEDENT_PENALTY: i32 = 23;
+const RELATIVE_DEDENT_WITH_BLANK_PENALTY: i32 = 17;
+const INDENT_WEIGHT: i32 = 60;
+const INDENT_HEURISTIC_MAX_SLIDING: usize = 100;
+
+struct Side<'a, T> {
+    items: &'a [T],
+    /// Changed flags shifted by one, with an unchanged sentinel at each end
+    changed: Vec<bool>,
+}
+
+/// A run of changed elements, `start..end` in element indices
+#[derive(Clone, Copy)]
+struct Group {
+    start: usize,
+    end: usize,
+}
+
+impl<'a, T: PartialEq> Side<'a, T> {
+    fn new(items: &'a [T]) -> Self {
+        let mut changed = vec![true; items.len() + 2];
+        changed[0] = false;
+        changed[items.len() + 1] = false;
+        Side { items, changed }
+    }
+
+    fn is_changed(&self, i: usize) -> bool {
+        self.changed[i + 1]
+    }
+
+    fn first_group(&self) -> Group {
+        let mut end = 0;
+        while self.is_changed(end) {
+            end += 1;
+        }
+        Group { start: 0, end }
+    }
+
+    fn next_group(&self, g: &mut Group) -> bool {
+        if g.end == self.items.len() {
+            return false;
+        }
+        g.start = g.end + 1;
+        g.end = g.start;
+        while self.is_changed(g.end) {
+            g.end += 1;
+        }
+        true
+    }
+
+    fn previous_group(&self, g: &mut Group) -> bool {
+        if g.start == 0 {
+            return false;
+        }
+        g.end = g.start - 1;
+        g.start = g.end;
+        while g.start > 0 && self.is_changed(g.start - 1) {
+            g.start -= 1;
+        }
+        true
+    }
+
+    fn slide_down(&mut self, g: &mut Group) -> bool {
+        if g.end < self.items.len() && self.items[g.start] == self.items[g.end] {
+            self.changed[g.start + 1] = false;
+            self.changed[g.end + 1] = true;
+            g.start += 1;
+            g.end += 1;
+            while self.is_changed(g.end) {
+                g.end += 1;
+            }
+            return true;
+        }
+        false
+    }
+
+    fn slide_up(&mut self, g: &mut Group) -> bool {
+        if g.start > 0 && self.items[g.start - 1] == self.items[g.end - 1] {
+            g.start -= 1;
+            g.end -= 1;
+            self.changed[g.start + 1] = true;
+            self.changed[g.end + 1] = false;
+            while g.start > 0 && self.is_changed(g.start - 1) {
+                g.start -= 1;
+            }
+            return true;
+        }
+        false
+    }
+}
+
+fn compact<T: PartialEq>(side: &mut Side<T>, other: &mut Side<T>, indent: Option<IndentOf<T>>) -> Reach {
+    let mut g = side.first_group();
+    let mut go = other.first_group();
+    let mut reach = Reach {
+        start: side.items.len(),
+        end: 0,
+    };
+
+    loop {
+        if g.end != g.start {
+            let mut groupsize;
+            let mut earliest_end;
+            let mut end_matching_other;
+            loop {
+                groupsize = g.end - g.start;
+                end_matching_other = None;
+                while side.slide_up(&mut g) {
+                    other.previous_group(&mut go);
+                }
+                reach.start = reach.start.min(g.start);
+                earliest_end = g.end;
+                if go.end > go.start {
+                    end_matching_other = Some(g.end);
+                }
+                while side.slide_down(&mut g) {
+                    other.next_group(&mut go);
+                    if go.end > go.start {
+                        end_matching_other = Some(g.end);
+                    }
+                }
+                reach.end = reach.end.max(g.end);
+                if groupsize == g.end - g.start {
+                    break;
+                }
+            }
+
+            if g.end == earliest_end {
+                // Nowhere to slide
+            } else if end_matching_other.is_some() {
+                // Line up with the last change on the other side
+                while go.end == go.start {
+                    side.slide_up(&mut g);
+                    other.previous_group(&mut go);
+                }
+            } else if let Some(indent) = indent {
+                let mut shift = earliest_end.max(g.end.saturating_sub(groupsize + 1));
+                shift = shift.max(g.end.saturating_sub(INDENT_HEURISTIC_MAX_SLIDING));
+                let mut best: Option<(usize, Score)> = None;
+                while shift <= g.end {
+                    let mut score = Score::default();
+                    score.add(&measure_split(side.items, shift, indent));
+                    score.add(&measure_split(side.items, shift - groupsize, indent));
+                    if best.as_ref().map_or(true, |(_, b)| score.cmp(b) <= 0) {
+                        best = Some((shift, score));
+                    }
+                    shift += 1;
+                }
+                let best_shift = best.map_or(g.end, |(s, _)| s);
+                while g.end > best_shift {
+                    side.slide_up(&mut g);
+                    other.previous_group(&mut go);
+                }
+            }
+        }
+
+        if !side.next_group(&mut g) {
+            break;
+        }
+        other.next_group(&mut go);
+    }
+    reach
+}
+
+/// Surroundings of a split point (just before element `split`)
+struct Split {
+    end_of_file: bool,
+    indent: i32,
+    pre_blank: i32,
+    pre_indent: i32,
+    post_blank: i32,
+    post_indent: i32,
+}
+
+fn measure_split<T>(items: &[T], split: usize, indent_of: IndentOf<T>) -> Split {
+    let mut m = Split {
+        end_of_file: split >= items.len(),
+        indent: if split >= items.len() { -1 } else { indent_of(items, split) },
+        pre_blank: 0,
+        pre_indent: -1,
+        post_blank: 0,
+        post_indent: -1,
+    };
+    for i in (0..split.min(items.len())).rev() {
+        let indent = indent_of(items, i);
+        if indent != -1 {
+            m.pre_indent = indent;
+            break;
+        }
+        m.pre_blank += 1;
+        if m.pre_blank == MAX_BLANKS {
+            m.pre_indent = 0;
+            break;
+        }
+    }
+    for i in split + 1..items.len() {
+        let indent = indent_of(items, i);
+        if indent != -1 {
+            m.post_indent = indent;
+            break;
+        }
+        m.post_blank += 1;
+        if m.post_blank == MAX_BLANKS {
+            m.post_indent = 0;
+            break;
+        }
+    }
+    m
+}
+
+#[derive(Default)]
+struct Score {
+    effective_indent: i32,
+    penalty: i32,
+}
+
+impl Score {
+    fn add(&mut self, m: &Split) {
+        if m.pre_indent == -1 && m.pre_blank == 0 {
+            self.penalty += START_OF_FILE_PENALTY;
+        }
+        if m.end_of_file {
+            self.penalty += END_OF_FILE_PENALTY;
+        }
+        let post_blank = if m.indent == -1 { 1 + m.post_blank } else { 0 };
+        let total_blank = m.pre_blank + post_blank;
+        self.penalty += TOTAL_BLANK_WEIGHT * total_blank;
+        self.penalty += POST_BLANK_WEIGHT * post_blank;
+
+        let indent = if m.indent != -1 { m.indent } else { m.post_indent };
+        let any_blanks = total_blank != 0;
+        self.effective_indent += indent;
+
+        if indent == -1 || m.pre_indent == -1 || indent == m.pre_indent {
+            // No adjustment
+        } else if indent > m.pre_indent {
+            self.penalty += if any_blanks { RELATIVE_INDENT_WITH_BLANK_PENALTY } else { RELATIVE_INDENT_PENALTY };
+        } else if m.post_indent != -1 && m.post_indent > indent {
+            self.penalty += if any_blanks { RELATIVE_OUTDENT_WITH_BLANK_PENALTY } else { RELATIVE_OUTDENT_PENALTY };
+        } else {
+            self.penalty += if any_blanks { RELATIVE_DEDENT_WITH_BLANK_PENALTY } else { RELATIVE_DEDENT_PENALTY };
+        }
+    }
+
+    /// Negative when `self` is the better split.
+    fn cmp(&self, other: &Score) -> i32 {
+        let indents = (self.effective_indent > other.effective_indent) as i32
+            - (self.effective_indent < other.effective_indent) as i32;
+        INDENT_WEIGHT * indents + (self.penalty - other.penalty)
+    }
+}
+
+/// Diagonal-indexed furthest-reaching x values
+struct V {
+    offset: isize,
+    v: Vec<usize>,
+}
+
+impl V {
+    fn new(max_d: usize) -> V {
+        V {
+            offset: max_d as isize,
+            v: vec![0; 2 * max_d + 2],
+        }
+    }
+}
+
+impl Index<isize> for V {
+    type Output = usize;
+    fn index(&self, k: isize) -> &usize {
+        &self.v[(k + self.offset) as usize]
+    }
+}
+
+impl IndexMut<isize> for V {
+    fn index_mut(&mut self, k: isize) -> &mut usize {
+        &mut self.v[(k + self.offset) as usize]
+    }
+}
+
+fn prefix_len<T: PartialEq>(a: &[T], b: &[T]) -> usize {
+    a.iter().zip(b).take_while(|(x, y)| x == y).count()
+}
+
+fn suffix_len<T: PartialEq>(a: &[T], b: &[T]) -> usize {
+    a.iter().rev().zip(b.iter().rev()).take_while(|(x, y)| x == y).count()
+}
+
+fn conquer<T: PartialEq>(
+    a: &[T],
+    mut ar: Range<usize>,
+    b: &[T],
+    mut br: Range<usize>,
+    vf: &mut V,
+    vb: &mut V,
+    out: &mut Vec<(usize, usize)>,
+) {
+    let prefix = prefix_len(&a[ar.clone()], &b[br.clone()]);
+    out.extend((0..prefix).map(|i| (ar.start + i, br.start + i)));
+    ar.start += prefix;
+    br.start += prefix;
+
+    let suffix = suffix_len(&a[ar.clone()], &b[br.clone()]);
+    ar.end -= suffix;
+    br.end -= suffix;
+
+    if !ar.is_empty() && !br.is_empty() {
+        if let Some((x, y)) = middle_snake(a, ar.clone(), b, br.clone(), vf, vb) {
+            conquer(a, ar.start..x, b, br.start..y, vf, vb, out);
+            conquer(a, x..ar.end, b, y..br.end, vf, vb, out);
+        }
+    }
+
+    out.extend((0..suffix).map(|i| (ar.end + i, br.end + i)));
+}
+
+/// A point on a shortest edit path through the region, splitting it into
+/// two smaller problems; `None` when the search exceeds `MAX_EDIT_COST`.
+fn middle_snake<T: PartialEq>(
+    a: &[T],
+    ar: Range<usize>,
+    b: &[T],
+    br: Range<usize>,
+    vf: &mut V,
+    vb: &mut V,
+) -> Option<(usize, usize)> {
+    let n = ar.len();
+    let m = br.len();
+    let delta = n as isize - m as isize;
+    let odd = delta & 1 == 1;
+    vf[1] = 0;
+    vb[1] = 0;
+
+    let max_d = ((n + m + 1) / 2 + 1).min(MAX_EDIT_COST) as isize;
+    for d in 0..max_d {
+        let mut k = d;
+        while k >= -d {
+            let mut x = if k == -d || (k != d && vf[k - 1] < vf[k + 1]) {
+                vf[k + 1]
+            } else {
+                vf[k - 1] + 1
+            };
+            let y = (x as isize - k) as usize;
+            let (x0, y0) = (x, y);
+            if x < n && y < m {
+                x += prefix_len(&a[ar.start + x..ar.end], &b[br.start + y..br.end]);
+            }
+            vf[k] = x;
+            if odd && (k - delta).abs() <= d - 1 && vf[k] + vb[-(k - delta)] >= n {
+                return Some((ar.start + x0, br.start + y0));
+            }
+            k -= 2;
+        }
+
+        let mut k = d;
+        while k >= -d {
+            let mut x = if k == -d || (k != d && vb[k - 1] < vb[k + 1]) {
+                vb[k + 1]
+            } else {
+                vb[k - 1] + 1
+            };
+            let mut y = (x as isize - k) as usize;
+            if x < n && y < m {
+                let advance = suffix_len(&a[ar.start..ar.end - x], &b[br.start..br.end - y]);
+                x += advance;
+                y += advance;
+            }
+            vb[k] = x;
+            if !odd && (k - delta).abs() <= d && vb[k] + vf[-(k - delta)] >= n {
+                return Some((ar.start + n - x, br.start + m - y));
+            }
+            k -= 2;
+        }
+    }
+    None
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn lcs_len(a: &[char], b: &[char]) -> usize {
+        let mut dp = vec![vec![0; b.len() + 1]; a.len() + 1];
+        for i in 0..a.len() {
+            for j in 0..b.len() {
+                dp[i + 1][j + 1] = if a[i] == b[j] { dp[i][j] + 1 } else { dp[i][j + 1].max(dp[i + 1][j]) };
+            }
+        }
+        dp[a.len()][b.len()]
+    }
+
+    fn check(a: &str, b: &str) {
+        let a: Vec<char> = a.chars().collect();
+        let b: Vec<char> = b.chars().collect();
+        let m = matches(&a, &b);
+        for w in m.windows(2) {
+            assert!(w[0].0 < w[1].0 && w[0].1 < w[1].1, "not ascending: {:?}", m);
+        }
+        for &(i, j) in &m {
+            assert_eq!(a[i], b[j]);
+        }
+        assert_eq!(m.len(), lcs_len(&a, &b), "{:?} vs {:?}", a, b);
+    }
+
+    #[test]
+    fn test_matches_are_a_longest_common_subsequence() {
+        check("", "");
+        check("abc", "");
+        check("", "abc");
+        check("abc", "abc");
+        check("abcabba", "cbabac");
+        check("xaxbxcx", "abc");
+        check("the quick brown fox", "the quack brown box jumps");
+        check("aaaaaaaaab", "baaaaaaaaa");
+    }
+
+    #[test]
+    fn test_pseudo_random_sequences() {
+        let mut seed = 0x2545_f491_u32;
+        let mut next = || {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            seed
+        };
+        for _ in 0..200 {
+            let a: String = (0..next() % 40).map(|_| (b'a' + (next() % 4) as u8) as char).collect();
+            let b: String = (0..next() % 40).map(|_| (b'a' + (next() % 4) as u8) as char).collect();
+            check(&a, &b);
+        }
+    }
+
+    #[test]
+    fn test_insertions_slide_down() {
+        // Inserting "x\n" before or after the existing "x\n" is the same
+        // edit; the later position is reported
+        let a = ["a", "x", "b"];
+        let b = ["a", "x", "x", "b"];
+        assert_eq!(matches(&a, &b), vec![(0, 0), (1, 1), (2, 3)]);
+
+        let a = ["f", "}", "", "g", "}"];
+        let b = ["f", "}", "", "h", "}", "", "g", "}"];
+        assert_eq!(matches(&a, &b), vec![(0, 0), (1, 1), (2, 2), (3, 6), (4, 7)]);
+    }
+
+    #[test]
+    fn test_indent_heuristic() {
+        // A repeated function inserted between two of its lookalikes: the
+        // lowest slide splits it across `fn b() {`; git's indent heuristic
+        // (and so `line_matches`) keeps it whole, blank line included
+        let block = |body: &'static str| ["fn b() {", body, "}", ""];
+        let a: Vec<&str> = [block("    y();"), block("    x();")].concat();
+        let b: Vec<&str> = [block("    y();"), block("    y();"), block("    x();")].concat();
+        let to_lines = |v: &[&str]| v.iter().map(|l| Line::new(l.as_bytes())).collect::<Vec<_>>();
+
+        let expected: Vec<(usize, usize)> = (0..4).map(|i| (i, i)).chain((4..8).map(|i| (i, i + 4))).collect();
+        assert_ne!(matches(&a, &b), expected);
+        assert_eq!(line_matches(&to_lines(&a), &to_lines(&b)), expected);
+    }
+
+    #[test]
+    fn test_small_edit_in_large_input() {
+        let a: Vec<u32> = (0..10_000).collect();
+        let mut b = a.clone();
+        b[5_000] = 99_999;
+        b.insert(7_000, 123_456);
+        let m = matches(&a, &b);
+        assert_eq!(m.len(), 9_999);
+    }
+}
@@ -0,0 +1,410 @@
+//! Fuzzy ranked matching over outline lines (`vita -b -g PAT --fuzzy`)
+//!
+//! A pattern matches any line that contains its characters in order, so
+//! `hrh` finds `HttpReqHandler`. Matches are scored the way fzf does it:
+//! each matched character earns a base score plus a bonus when it starts a
+//! word (after a separator, or a camelCase / letter-to-digit step), runs of
+//! consecutive matches are rewarded, and gaps between matches cost a
+//! little. The best alignment is found by dynamic programming.
+//!
+//! Most lines of a large index cannot match at all, so two cheap filters
+//! run first: a 64-bit bag of the characters present in the line, then an
+//! in-order scan with `memchr` that also narrows the window the dynamic
+//! programming has to cover.
+
+use std::thread;
+
+use memchr::{memchr, memchr2, memrchr, memrchr2};
+
+const SCORE_MATCH: i32 = 16;
+const GAP_START: i32 = -3;
+const GAP_EXTENSION: i32 = -1;
+/// Match right after whitespace or punctuation, or at the start of the line
+const BONUS_BOUNDARY: i32 = 8;
+/// Match at a lower-to-upper or letter-to-digit step
+const BONUS_CAMEL: i32 = 7;
+/// Minimum bonus for each match in an unbroken run
+const BONUS_CONSECUTIVE: i32 = -(GAP_START + GAP_EXTENSION);
+/// The first pattern character's bonus counts this many times
+const FIRST_CHAR_MULTIPLIER: i32 = 2;
+
+/// Above this pattern × window size the best alignment is not searched;
+/// the leftmost in-order match is scored instead.
+const MAX_DP_CELLS: usize = 64 * 1024;
+
+/// Below this many candidates, threads cost more than they save
+const PARALLEL_THRESHOLD: usize = 8_192;
+
+pub struct Pattern {
+    chars: Vec<char>,
+    /// Pattern bytes, folded to lowercase unless case sensitive; `None`
+    /// when the pattern is not ASCII
+    ascii: Option<Vec<u8>>,
+    bag: u64,
+    /// Smart case: only a pattern with an uppercase letter is case sensitive
+    case_sensitive: bool,
+}
+
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct Match {
+    pub score: i32,
+    /// Byte offsets of the matched characters, ascending
+    pub positions: Vec<usize>,
+}
+
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum Class {
+    White,
+    Delimiter,
+    Lower,
+    Upper,
+    Letter,
+    Digit,
+    Other,
+}
+
+fn class_of(c: char) -> Class {
+    match c {
+        'a'..='z' => Class::Lower,
+        'A'..='Z' => Class::Upper,
+        '0'..='9' => Class::Digit,
+        c if c.is_whitespace() => Class::White,
+        '/' | ',' | ':' | ';' | '|' | '_' | '-' | '.' | '(' | ')' | '<' | '>' | '[' | ']' | '{' | '}' => {
+            Class::Delimiter
+        }
+        c if c.is_lowercase() => Class::Lower,
+        c if c.is_uppercase() => Class::Upper,
+        c if c.is_alphabetic() => Class::Letter,
+        _ => Class::Other,
+    }
+}
+
+fn is_word(class: Class) -> bool {
+    matches!(class, Class::Lower | Class::Upper | Class::Letter | Class::Digit)
+}
+
+fn bonus(prev: Class, cur: Class) -> i32 {
+    if !is_word(cur) {
+        return 0;
+    }
+    match (prev, cur) {
+        (p, _) if !is_word(p) => BONUS_BOUNDARY,
+        (Class::Lower, Class::Upper) => BONUS_CAMEL,
+        (Class::Lower | Class::Upper | Class::Letter, Class::Digit) => BONUS_CAMEL,
+        _ => 0,
+    }
+}
+
+/// Bag bit for a byte: one per letter (case folded) and digit, the rest
+/// share the remaining bits. Every byte of a multi-byte character maps to
+/// bit 63, so the bag stays a valid superset test for any text.
+fn bag_bit(b: u8) -> u64 {
+    match b {
+        b'a'..=b'z' => 1 << (b - b'a'),
+        b'A'..=b'Z' => 1 << (b - b'A'),
+        b'0'..=b'9' => 1 << (26 + b - b'0'),
+        0x80..=0xff => 1 << 63,
+        _ => 1 << (36 + b % 27),
+    }
+}
+
+fn bag_of(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0, |bag, &b| bag | bag_bit(b))
+}
+
+fn fold(c: char, case_sensitive: bool) -> char {
+    if case_sensitive {
+        c
+    } else {
+        c.to_lowercase().next().unwrap_or(c)
+    }
+}
+
+impl Pattern {
+    /// Whitespace in `query` is ignored.
+    pub fn new(query: &str) -> Pattern {
+        let case_sensitive = query.chars().any(|c| c.is_uppercase());
+        let chars: Vec<char> = query
+            .chars()
+            .filter(|c| !c.is_whitespace())
+            .map(|c| fold(c, case_sensitive))
+            .collect();
+        let text: String = chars.iter().collect();
+        let ascii = text.is_ascii().then(|| text.as_bytes().to_vec());
+        Pattern {
+            bag: bag_of(text.as_bytes()),
+            chars,
+            ascii,
+            case_sensitive,
+        }
+    }
+
+    /// Score `text` against the pattern, or `None` if it does not match.
+    pub fn score(&self, text: &str) -> Option<Match> {
+        if self.chars.is_empty() {
+            return Some(Match {
+                score: 0,
+                positions: Vec::new(),
+            });
+        }
+        if self.bag & !bag_of(text.as_bytes()) != 0 {
+            return None;
+        }
+        let (start, end) = self.window(text)?;
+
+        // Characters of the window with byte offsets and word bonuses
+        let mut prev = text[..start].chars().next_back().map_or(Class::White, class_of);
+        let mut chars = Vec::with_capacity(end - start);
+        for (offset, c) in text[start..end].char_indices() {
+            let class = class_of(c);
+            chars.push((start + offset, fold(c, self.case_sensitive), bonus(prev, class)));
+            prev = class;
+        }
+
+        if self.chars.len() * chars.len() > MAX_DP_CELLS {
+            return Some(self.greedy(&chars));
+        }
+        Some(self.align(&chars))
+    }
+
+    /// Byte range from the first possible match of the first character to
+    /// the last possible match of the last one, if all occur in order.
+    fn window(&self, text: &str) -> Option<(usize, usize)> {
+        match &self.ascii {
+            Some(pattern) => {
+                let hay = text.as_bytes();
+                let find = |b: u8, hay: &[u8]| match self.case_sensitive || !b.is_ascii_lowercase() {
+                    true => memchr(b, hay),
+                    false => memchr2(b, b.to_ascii_uppercase(), hay),
+                };
+                let rfind = |b: u8, hay: &[u8]| match self.case_sensitive || !b.is_ascii_lowercase() {
+                    true => memrchr(b, hay),
+                    false => memrchr2(b, b.to_ascii_uppercase(), hay),
+                };
+
+                let mut pos = 0;
+                let mut start = None;
+                for &b in pattern {
+                    let at = pos + find(b, &hay[pos..])?;
+                    start.get_or_insert(at);
+                    pos = at + 1;
+                }
+                // The last character matched at `pos - 1`, so this finds one
+                let end = rfind(pattern[pattern.len() - 1], hay).map_or(pos, |i| i + 1);
+                Some((start?, end))
+            }
+            None => {
+                let mut want = self.chars.iter().peekable();
+                let mut start = None;
+                for (i, c) in text.char_indices() {
+                    let Some(&&p) = want.peek() else { break };
+                    if fold(c, self.case_sensitive) == p {
+                        start.get_or_insert(i);
+                        want.next();
+                    }
+                }
+                if want.peek().is_some() {
+                    return None;
+                }
+                let last = self.chars[self.chars.len() - 1];
+                let (i, c) = text
+                    .char_indices()
+                    .rev()
+                    .find(|&(_, c)| fold(c, self.case_sensitive) == last)?;
+                Some((start?, i + c.len_utf8()))
+            }
+        }
+    }
+
+    /// Best-scoring alignment of the pattern within `chars`.
+    fn align(&self, chars: &[(usize, char, i32)]) -> Match {
+        const NONE: i32 = i32::MIN / 2;
+        let m = self.chars.len();
+        let n = chars.len();
+        // score[i * n + j]: best score with pattern[i] matched at chars[j];
+        // from[i * n + j]: where pattern[i - 1] was matched in that alignment
+        let mut score = vec![NONE; m * n];
+        let mut from = vec![0usize; m * n];
+
+        for (j, &(_, c, b)) in chars.iter().enumerate() {
+            if c == self.chars[0] {
+                score[j] = SCORE_MATCH + b * FIRST_CHAR_MULTIPLIER;
+            }
+        }
+        for i in 1..m {
+            let p = self.chars[i];
+            let (above, row) = score.split_at_mut(i * n);
+            let above = &above[(i - 1) * n..];
+            let row = &mut row[..n];
+            // Best `above[k] + gap penalty` over k < j - 1
+            let mut gapped = NONE;
+            let mut gapped_from = 0;
+            for j in 1..n {
+                if j >= 2 {
+                    gapped += GAP_EXTENSION;
+                    if above[j - 2] + GAP_START > gapped {
+                        gapped = above[j - 2] + GAP_START;
+                        gapped_from = j - 2;
+                    }
+                }
+                let (_, c, b) = chars[j];
+                if c != p {
+                    continue;
+                }
+                let run = above[j - 1] + SCORE_MATCH + b.max(BONUS_CONSECUTIVE);
+                let gap = gapped + SCORE_MATCH + b;
+                if run >= gap && above[j - 1] > NONE {
+                    row[j] = run;
+                    from[i * n + j] = j - 1;
+                } else if gapped > NONE {
+                    row[j] = gap;
+                    from[i * n + j] = gapped_from;
+                }
+            }
+        }
+
+        let last = &score[(m - 1) * n..];
+        let (mut j, &best) = last
+            .iter()
+            .enumerate()
+            .max_by_key(|&(j, &s)| (s, std::cmp::Reverse(j)))
+            .expect("window is non-empty");
+        let mut positions = vec![0; m];
+        for i in (0..m).rev() {
+            positions[i] = chars[j].0;
+            if i > 0 {
+                j = from[i * n + j];
+            }
+        }
+        Match {
+            score: best,
+            positions,
+        }
+    }
+
+    /// Leftmost in-order match, scored with the same rules.
+    fn greedy(&self, chars: &[(usize, char, i32)]) -> Match {
+        let mut positions = Vec::with_capacity(self.chars.len());
+        let mut score = 0;
+        let mut last: Option<usize> = None;
+        let mut want = self.chars.iter();
+        let mut p = want.next();
+        for (j, &(offset, c, b)) in chars.iter().enumerate() {
+            let Some(&pc) = p else { break };
+            if c != pc {
+                continue;
+            }
+            score += SCORE_MATCH
+                + match last {
+                    None => b * FIRST_CHAR_MULTIPLIER,
+                    Some(k) if k + 1 == j => b.max(BONUS_CONSECUTIVE),
+                    Some(k) => b + GAP_START + GAP_EXTENSION * (j - k - 2) as i32,
+                };
+            positions.push(offset);
+            last = Some(j);
+            p = want.next();
+        }
+        Match { score, positions }
+    }
+}
+
+/// The `limit` best matches among `candidates` as `(index, match)`, by
+/// descending score, then shorter text, then input order.
+pub fn top_k(pattern: &Pattern, candidates: &[&str], limit: usize) -> Vec<(usize, Match)> {
+    let score_range = |base: usize, part: &[&str]| -> Vec<(usize, Match)> {
+        part.iter()
+            .enumerate()
+            .filter_map(|(i, text)| pattern.score(text).map(|m| (base + i, m)))
+            .collect()
+    };
+
+    let mut matches = if candidates.len() < PARALLEL_THRESHOLD {
+        score_range(0, candidates)
+    } else {
+        let workers = thread::available_parallelism().map_or(1, |n| n.get());
+        let chunk = (candidates.len() + workers - 1) / workers;
+        thread::scope(|scope| {
+            let handles: Vec<_> = candidates
+                .chunks(chunk)
+                .enumerate()
+                .map(|(k, part)| scope.spawn(move || score_range(k * chunk, part)))
+                .collect();
+            handles.into_iter().flat_map(|h| h.join().unwrap_or_default()).collect()
+        })
+    };
+
+    let order = |a: &(usize, Match), b: &(usize, Match)| {
+        b.1.score
+            .cmp(&a.1.score)
+            .then(candidates[a.0].len().cmp(&candidates[b.0].len()))
+            .then(a.0.cmp(&b.0))
+    };
+    if matches.len() > limit && limit > 0 {
+        matches.select_nth_unstable_by(limit - 1, order);
+    }
+    matches.truncate(limit);
+    matches.sort_unstable_by(order);
+    matches
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn positions(pattern: &str, text: &str) -> Option<Vec<usize>> {
+        Pattern::new(pattern).score(text).map(|m| m.positions)
+    }
+
+    #[test]
+    fn test_subsequence_match() {
+        assert_eq!(positions("hrh", "struct HttpReqHandler {"), Some(vec![7, 11, 14]));
+        assert_eq!(positions("hrh", "fn hash()"), None);
+        assert_eq!(positions("", "anything"), Some(vec![]));
+    }
+
+    #[test]
+    fn test_smart_case() {
+        assert!(Pattern::new("handler").score("struct Handler").is_some());
+        assert!(Pattern::new("Handler").score("fn handler()").is_none());
+    }
+
+    #[test]
+    fn test_prefers_word_boundaries() {
+        assert_eq!(positions("rh", "fn render_html()"), Some(vec![3, 10]));
+        assert_eq!(positions("fb", "fn foo_bar() // fab"), Some(vec![3, 7]));
+    }
+
+    #[test]
+    fn test_ranking() {
+        let candidates = [
+            "fn parse_header(line: &str)",
+            "fn handle_request(req: Request)",
+            "struct HttpReqHandler {",
+            "fn main()",
+        ];
+        let ranked = top_k(&Pattern::new("hrh"), &candidates, 10);
+        let order: Vec<usize> = ranked.iter().map(|(i, _)| *i).collect();
+        assert_eq!(order, vec![2]);
+
+        // A word-start match of `req` beats the camelCase one
+        let ranked = top_k(&Pattern::new("req"), &candidates, 1);
+        assert_eq!(ranked.len(), 1);
+        assert_eq!(ranked[0].0, 1);
+    }
+
+    #[test]
+    fn test_non_ascii() {
+        assert_eq!(positions("éb", "## Été bleu"), Some(vec![3, 9]));
+        assert!(Pattern::new("日本").score("# 日本語").is_some());
+    }
+
+    #[test]
+    fn test_greedy_fallback_agrees_on_simple_match() {
+        let p = Pattern::new("ab");
+        let text = "xx ab";
+        let chars: Vec<_> = text.char_indices().map(|(i, c)| (i, c, if i == 3 { BONUS_BOUNDARY } else { 0 })).collect();
+        assert_eq!(p.greedy(&chars[3..]), p.align(&chars[3..]));
+    }
+}
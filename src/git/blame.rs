@@ -0,0 +1,662 @@
+//! Line attribution (blame)
+//!
+//! Every line of the file starts out suspected on HEAD (or on the working
+//! tree, for lines changed since). Commits are visited newest first. A
+//! commit passes each suspected line to a parent that has the same line,
+//! judged by a diff of the two versions of the file. A line no parent has
+//! was introduced by that commit. When a parent holds an identical copy of
+//! the file, everything passes to it without diffing, so commits that do
+//! not touch the file cost one tree lookup.
+//!
+//! Only the changed middle of two versions is diffed line by line: the
+//! common leading and trailing bytes are found by plain comparison, and
+//! lines there map across by position. Blaming a few lines of a big file
+//! (`Blame::only`) then costs little more than reading each version.
+//!
+//! The attribution of HEAD's version is cached per path, with the commit
+//! and blob it belongs to. Viewing the file again at that commit needs no
+//! walk at all; after HEAD moves on, the walk covers only the new commits
+//! and takes lines that reach the cached commit from the record.
+//!
+//! Like `git blame` without `-M`/`-C`, lines are followed through edits of
+//! one path, not through renames or copies.
+
+use std::collections::hash_map::Entry;
+use std::collections::{BinaryHeap, HashMap};
+use std::fs;
+use std::io;
+use std::ops::Range;
+use std::path::Path;
+use std::rc::Rc;
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use super::{Kind, Oid, Repo, MODE_TREE, ZERO_OID};
+use crate::cache::{self, put_str, Cursor};
+use crate::diff;
+
+const CACHE_BUCKET: &str = "blame";
+const MAGIC: &[u8] = b"VBLM1\n";
+
+/// Author shown for lines that differ from HEAD
+const NOT_COMMITTED: &str = "Not Committed Yet";
+
+/// Unchanged lines diffed along either side of a changed region, so
+/// hunks can slide into them as they would in a diff of everything
+const DIFF_MARGIN: usize = 64;
+
+/// Working-file lines one commit turned out to have introduced
+pub struct Hunk {
+    /// `ZERO_OID` when not committed yet
+    pub commit: Oid,
+    pub author: String,
+    pub time: i64,
+    /// Working-file line indices, ascending
+    pub lines: Vec<u32>,
+}
+
+/// One version of the file: its bytes and where each line starts
+struct Version {
+    data: Vec<u8>,
+    /// Start of each line, then the end of the data
+    starts: Vec<u32>,
+}
+
+/// Lines of a commit's version of the file still looking for their origin
+struct Suspect {
+    blob: Oid,
+    version: Rc<Version>,
+    /// `(line in this version, line at HEAD)`
+    lines: Vec<(u32, u32)>,
+}
+
+struct Walk {
+    repo: Repo,
+    path: Vec<Vec<u8>>,
+    /// Resolved `(tree, depth)` → entry for the path component at `depth`
+    trees: HashMap<(Oid, usize), Option<Oid>>,
+    pending: HashMap<Oid, Suspect>,
+    /// Pending commits by committer time, newest first
+    queue: BinaryHeap<(i64, Oid)>,
+}
+
+/// A blame in progress. Iterating yields one hunk per commit that
+/// introduced lines, newest first (uncommitted lines before all), so
+/// callers can show results while older history is still being walked.
+pub struct Blame {
+    walk: Walk,
+    /// The working file; its lines, split at `\n`, are those blamed
+    pub text: String,
+    /// Lines that differ from HEAD, until reported
+    uncommitted: Vec<u32>,
+    /// Working-file line of each line at HEAD, unless since deleted
+    work_line: Vec<Option<u32>>,
+    /// Attributed lines at HEAD, in HEAD coordinates, until reported
+    ready: Vec<Hunk>,
+    /// What this blame found so far; `None` after `only`
+    record: Option<Record>,
+    /// An earlier result for this path
+    cached: Option<Record>,
+    cache_name: String,
+}
+
+/// Attribution of every line of one commit's version of the file
+struct Record {
+    commit: Oid,
+    blob: Oid,
+    /// `(commit, author, time)` of each commit lines are attributed to
+    commits: Vec<(Oid, String, i64)>,
+    ids: HashMap<Oid, u32>,
+    /// Index into `commits` of each line, `u32::MAX` until known
+    origin: Vec<u32>,
+}
+
+impl Blame {
+    /// Start blaming the working-tree file at `path`.
+    pub fn start(path: &Path) -> io::Result<Blame> {
+        let repo = Repo::discover(path)?;
+        let components = repo.relative(path)?;
+
+        let work = Version::new(fs::read(path)?);
+        let head = repo.head()?;
+        let head_commit = repo.commit(&head)?;
+        let cache_name = format!(
+            "{:016x}",
+            cache::key(&[repo.common_dir.to_string_lossy().as_bytes(), &components.join(&b"/"[..])])
+        );
+
+        let mut walk = Walk {
+            repo,
+            path: components,
+            trees: HashMap::new(),
+            pending: HashMap::new(),
+            queue: BinaryHeap::new(),
+        };
+
+        let head_blob = walk.blob_at(&head_commit.tree)?.ok_or_else(|| {
+            io::Error::new(
+                io::ErrorKind::NotFound,
+                format!("no such path '{}' in HEAD", String::from_utf8_lossy(&walk.path.join(&b"/"[..]))),
+            )
+        })?;
+
+        // Every line at HEAD is blamed, so the result can be cached; lines
+        // changed since stay uncommitted
+        let head_version = Rc::new(walk.version(&head_blob)?);
+        let map = line_map(&work, &head_version);
+        let mut work_line = vec![None; head_version.len()];
+        let mut uncommitted = Vec::new();
+        for w in 0..work.len() as u32 {
+            match map.get(w) {
+                Some(h) => work_line[h as usize] = Some(w),
+                None => uncommitted.push(w),
+            }
+        }
+        let record = Record::new(head, head_blob, head_version.len());
+        let lines = (0..head_version.len() as u32).map(|h| (h, h)).collect();
+        walk.suspect(head, head_commit.time, head_blob, head_version, lines);
+
+        Ok(Blame {
+            walk,
+            text: String::from_utf8(work.data).unwrap_or_else(|e| String::from_utf8_lossy(e.as_bytes()).into_owned()),
+            uncommitted,
+            work_line,
+            ready: Vec::new(),
+            record: Some(record),
+            cached: cache::read(CACHE_BUCKET, &cache_name).and_then(|bytes| Record::decode(&bytes)),
+            cache_name,
+        })
+    }
+
+    /// Attribute only the working-file lines in `lines`; the walk ends as
+    /// soon as they are all explained. Call before iterating.
+    pub fn only(&mut self, lines: Range<usize>) {
+        let work_len = self.uncommitted.len() + self.work_line.iter().flatten().count();
+        if lines.start == 0 && lines.end >= work_len {
+            return;
+        }
+        let keep = |w: Option<u32>| w.map_or(false, |w| lines.contains(&(w as usize)));
+        self.uncommitted.retain(|&w| keep(Some(w)));
+        let work_line = &self.work_line;
+        for suspect in self.walk.pending.values_mut() {
+            suspect.lines.retain(|&(_, h)| keep(work_line[h as usize]));
+        }
+        let pending = &self.walk.pending;
+        self.walk.queue.retain(|(_, commit)| !pending[commit].lines.is_empty());
+        self.walk.pending.retain(|_, suspect| !suspect.lines.is_empty());
+        self.record = None;
+    }
+
+    /// Walk whatever is left, such as lines deleted since HEAD, and cache
+    /// the result for the next blame of this file. Skipped after `only`.
+    pub fn finish(mut self) {
+        if self.record.is_none() {
+            return;
+        }
+        while let Some(hunk) = self.next() {
+            if hunk.is_err() {
+                return;
+            }
+        }
+        let Some(record) = self.record.take() else { return };
+        let known = self.cached.as_ref().map_or(false, |c| c.commit == record.commit);
+        if !known && record.origin.iter().all(|&id| id != u32::MAX) {
+            cache::write(CACHE_BUCKET, &self.cache_name, &record.encode());
+        }
+    }
+}
+
+impl Iterator for Blame {
+    type Item = io::Result<Hunk>;
+
+    fn next(&mut self) -> Option<io::Result<Hunk>> {
+        if !self.uncommitted.is_empty() {
+            let now = SystemTime::now()
+                .duration_since(UNIX_EPOCH)
+                .map_or(0, |d| d.as_secs() as i64);
+            return Some(Ok(Hunk {
+                commit: ZERO_OID,
+                author: NOT_COMMITTED.to_string(),
+                time: now,
+                lines: std::mem::take(&mut self.uncommitted),
+            }));
+        }
+
+        loop {
+            if let Some(hunk) = self.ready.pop() {
+                if let Some(record) = &mut self.record {
+                    record.add(&hunk);
+                }
+                let mut lines: Vec<u32> = hunk.lines.iter().filter_map(|&h| self.work_line[h as usize]).collect();
+                if lines.is_empty() {
+                    continue;
+                }
+                lines.sort_unstable();
+                return Some(Ok(Hunk { lines, ..hunk }));
+            }
+
+            let (_, commit) = self.walk.queue.pop()?;
+            let suspect = self.walk.pending.remove(&commit).expect("queued commits are pending");
+            if let Some(cached) = &self.cached {
+                if cached.commit == commit && cached.blob == suspect.blob {
+                    self.ready = cached.hunks(&suspect.lines);
+                    continue;
+                }
+            }
+            let lines = match self.walk.step(commit, suspect) {
+                Ok(lines) if lines.is_empty() => continue,
+                Ok(lines) => lines,
+                Err(e) => return Some(Err(e)),
+            };
+            match self.walk.repo.author(&commit) {
+                Ok((author, time)) => self.ready.push(Hunk {
+                    commit,
+                    author,
+                    time,
+                    lines,
+                }),
+                Err(e) => return Some(Err(e)),
+            }
+        }
+    }
+}
+
+impl Record {
+    fn new(commit: Oid, blob: Oid, len: usize) -> Record {
+        Record {
+            commit,
+            blob,
+            commits: Vec::new(),
+            ids: HashMap::new(),
+            origin: vec![u32::MAX; len],
+        }
+    }
+
+    fn add(&mut self, hunk: &Hunk) {
+        let commits = &mut self.commits;
+        let id = *self.ids.entry(hunk.commit).or_insert_with(|| {
+            commits.push((hunk.commit, hunk.author.clone(), hunk.time));
+            commits.len() as u32 - 1
+        });
+        for &line in &hunk.lines {
+            self.origin[line as usize] = id;
+        }
+    }
+
+    /// Hunks for `lines` of this version, `(line here, line at HEAD)`,
+    /// oldest first.
+    fn hunks(&self, lines: &[(u32, u32)]) -> Vec<Hunk> {
+        let mut by_commit: HashMap<u32, Vec<u32>> = HashMap::new();
+        for &(line, head) in lines {
+            by_commit.entry(self.origin[line as usize]).or_default().push(head);
+        }
+        let mut hunks: Vec<Hunk> = by_commit
+            .into_iter()
+            .map(|(id, lines)| {
+                let (commit, author, time) = self.commits[id as usize].clone();
+                Hunk {
+                    commit,
+                    author,
+                    time,
+                    lines,
+                }
+            })
+            .collect();
+        hunks.sort_by_key(|h| h.time);
+        hunks
+    }
+
+    fn encode(&self) -> Vec<u8> {
+        let mut buf = Vec::with_capacity(64 + 48 * self.commits.len() + 4 * self.origin.len());
+        buf.extend_from_slice(MAGIC);
+        buf.extend_from_slice(&self.commit);
+        buf.extend_from_slice(&self.blob);
+        buf.extend_from_slice(&(self.commits.len() as u32).to_le_bytes());
+        for (commit, author, time) in &self.commits {
+            buf.extend_from_slice(commit);
+            buf.extend_from_slice(&time.to_le_bytes());
+            put_str(&mut buf, author);
+        }
+        buf.extend_from_slice(&(self.origin.len() as u32).to_le_bytes());
+        for id in &self.origin {
+            buf.extend_from_slice(&id.to_le_bytes());
+        }
+        buf
+    }
+
+    /// `None` for a malformed or incomplete record.
+    fn decode(bytes: &[u8]) -> Option<Record> {
+        let mut r = Cursor(bytes.strip_prefix(MAGIC)?);
+        let oid = |r: &mut Cursor| -> Option<Oid> { r.take(20)?.try_into().ok() };
+        let mut record = Record::new(oid(&mut r)?, oid(&mut r)?, 0);
+        for _ in 0..r.u32()? {
+            let commit = oid(&mut r)?;
+            let time = r.u64()? as i64;
+            record.commits.push((commit, r.str()?, time));
+        }
+        let n = r.u32()?;
+        record.origin = (0..n).map(|_| r.u32()).collect::<Option<_>>()?;
+        let valid = record.origin.iter().all(|&id| (id as usize) < record.commits.len());
+        valid.then_some(record)
+    }
+}
+
+impl Walk {
+    /// Queue `lines` of `blob` as suspected on `commit`.
+    fn suspect(&mut self, commit: Oid, time: i64, blob: Oid, version: Rc<Version>, lines: Vec<(u32, u32)>) {
+        if lines.is_empty() {
+            return;
+        }
+        match self.pending.entry(commit) {
+            Entry::Occupied(mut e) => e.get_mut().lines.extend(lines),
+            Entry::Vacant(e) => {
+                e.insert(Suspect { blob, version, lines });
+                self.queue.push((time, commit));
+            }
+        }
+    }
+
+    /// Pass what parents of `commit` explain to them. Returns the
+    /// working-file lines `commit` is blamed for.
+    fn step(&mut self, commit: Oid, suspect: Suspect) -> io::Result<Vec<u32>> {
+        let info = self.repo.commit(&commit)?;
+
+        // Parents missing from the object store (shallow clone) end the walk
+        let mut parents = Vec::with_capacity(info.parents.len());
+        for parent in &info.parents {
+            if let Ok(p) = self.repo.commit(parent) {
+                if let Some(blob) = self.blob_at(&p.tree)? {
+                    parents.push((*parent, p.time, blob));
+                }
+            }
+        }
+
+        let Suspect { blob, version: ours, mut lines } = suspect;
+        if let Some(&(parent, time, blob)) = parents.iter().find(|p| p.2 == blob) {
+            self.suspect(parent, time, blob, ours, lines);
+            return Ok(Vec::new());
+        }
+
+        for (parent, time, blob) in parents {
+            if lines.is_empty() {
+                break;
+            }
+            let theirs = Rc::new(self.version(&blob)?);
+            let map = line_map(&ours, &theirs);
+            let mut passed = Vec::new();
+            lines.retain(|&(o, w)| match map.get(o) {
+                Some(t) => {
+                    passed.push((t, w));
+                    false
+                }
+                None => true,
+            });
+            self.suspect(parent, time, blob, theirs, passed);
+        }
+
+        Ok(lines.into_iter().map(|(_, w)| w).collect())
+    }
+
+    /// Blob of the blamed path in `tree`, if it is a file there.
+    fn blob_at(&mut self, tree: &Oid) -> io::Result<Option<Oid>> {
+        let mut current = *tree;
+        for depth in 0..self.path.len() {
+            let next = match self.trees.get(&(current, depth)) {
+                Some(next) => *next,
+                None => {
+                    let last = depth + 1 == self.path.len();
+                    let next = self
+                        .repo
+                        .tree_entry(&current, &self.path[depth])?
+                        .filter(|&(mode, _)| (mode == MODE_TREE) != last)
+                        .map(|(_, oid)| oid);
+                    self.trees.insert((current, depth), next);
+                    next
+                }
+            };
+            match next {
+                Some(oid) => current = oid,
+                None => return Ok(None),
+            }
+        }
+        Ok(Some(current))
+    }
+
+    fn version(&self, blob: &Oid) -> io::Result<Version> {
+        match self.repo.read(blob)? {
+            (Kind::Blob, data) => Ok(Version::new(data)),
+            _ => Err(super::invalid("blamed path is not a file")),
+        }
+    }
+}
+
+impl Version {
+    fn new(data: Vec<u8>) -> Version {
+        let mut starts = Vec::with_capacity(data.len() / 32 + 2);
+        starts.push(0);
+        starts.extend(memchr::memchr_iter(b'\n', &data).map(|i| i as u32 + 1));
+        if data.last().map_or(false, |&b| b != b'\n') {
+            starts.push(data.len() as u32);
+        }
+        Version { data, starts }
+    }
+
+    /// Number of lines, counting a last line without `\n`
+    fn len(&self) -> usize {
+        self.starts.len() - 1
+    }
+
+    /// Line `i` with its `\n`, as git compares lines
+    fn line(&self, i: usize) -> &[u8] {
+        &self.data[self.starts[i] as usize..self.starts[i + 1] as usize]
+    }
+
+    fn diff_lines(&self, lines: Range<usize>) -> Vec<diff::Line> {
+        lines.map(|i| diff::Line::new(self.line(i))).collect()
+    }
+}
+
+/// Where lines of one version are in another. Lines before `lo` and from
+/// `hi` on lie in unchanged stretches at the start and end of the file.
+struct LineMap {
+    lo: u32,
+    hi: u32,
+    /// Where line `hi` is in the other version
+    hi_theirs: u32,
+    /// Lines `lo..hi` in the other version, `u32::MAX` for changed lines
+    window: Vec<u32>,
+}
+
+impl LineMap {
+    fn get(&self, line: u32) -> Option<u32> {
+        if line < self.lo {
+            Some(line)
+        } else if line >= self.hi {
+            Some(line - self.hi + self.hi_theirs)
+        } else {
+            Some(self.window[(line - self.lo) as usize]).filter(|&t| t != u32::MAX)
+        }
+    }
+}
+
+/// Map lines of `ours` to `theirs`, its parent's version, as a diff of the
+/// whole of both would.
+fn line_map(ours: &Version, theirs: &Version) -> LineMap {
+    let (a, b) = (&ours.data, &theirs.data);
+
+    // Whole lines, newline included, inside the common leading bytes
+    let prefix_bytes = common_prefix(a, b);
+    let mut prefix = ours.starts.partition_point(|&s| s as usize <= prefix_bytes) - 1;
+    if prefix > 0 && !ours.line(prefix - 1).ends_with(b"\n") {
+        prefix -= 1;
+    }
+
+    // Whole lines inside the common trailing bytes, after those
+    let floor = ours.starts[prefix] as usize;
+    let suffix_bytes = common_suffix(a, b).min(a.len() - floor).min(b.len() - floor);
+    let suffix_at = a.len() - suffix_bytes;
+    let theirs_at = b.len() - suffix_bytes;
+    let mut suffix = ours.starts[..ours.len()].partition_point(|&s| (s as usize) < suffix_at);
+    if suffix < ours.len() && ours.starts[suffix] as usize == suffix_at && theirs_at > 0 && b[theirs_at - 1] != b'\n' {
+        suffix += 1;
+    }
+    let suffix_theirs = theirs.len() - (ours.len() - suffix);
+
+    let margin = (ours.len() - suffix).min(DIFF_MARGIN);
+    let lo = prefix - prefix.min(DIFF_MARGIN);
+    let (hi, hi_theirs) = (suffix + margin, suffix_theirs + margin);
+    let cut = (lo > 0, hi < ours.len());
+    diff_window(ours, theirs, lo, hi, hi_theirs, cut).unwrap_or_else(|| {
+        // A hunk slid to the edge of the window; diff everything
+        diff_window(ours, theirs, 0, ours.len(), theirs.len(), (false, false)).expect("nothing cut")
+    })
+}
+
+fn diff_window(
+    ours: &Version,
+    theirs: &Version,
+    lo: usize,
+    hi: usize,
+    hi_theirs: usize,
+    (cut_start, cut_end): (bool, bool),
+) -> Option<LineMap> {
+    // The parent is the old side, as in `git diff parent child`
+    let old = theirs.diff_lines(lo..hi_theirs);
+    let new = ours.diff_lines(lo..hi);
+    let pairs = if cut_start || cut_end {
+        diff::line_matches_window(&old, &new, cut_start, cut_end)?
+    } else {
+        diff::line_matches(&old, &new)
+    };
+    let mut window = vec![u32::MAX; hi - lo];
+    for (t, o) in pairs {
+        window[o] = (lo + t) as u32;
+    }
+    Some(LineMap {
+        lo: lo as u32,
+        hi: hi as u32,
+        hi_theirs: hi_theirs as u32,
+        window,
+    })
+}
+
+fn common_prefix(a: &[u8], b: &[u8]) -> usize {
+    let n = a.len().min(b.len());
+    let mut i = 0;
+    while i + 16 <= n && a[i..i + 16] == b[i..i + 16] {
+        i += 16;
+    }
+    while i < n && a[i] == b[i] {
+        i += 1;
+    }
+    i
+}
+
+fn common_suffix(a: &[u8], b: &[u8]) -> usize {
+    let n = a.len().min(b.len());
+    let (a, b) = (&a[a.len() - n..], &b[b.len() - n..]);
+    let mut i = 0;
+    while i + 16 <= n && a[n - i - 16..n - i] == b[n - i - 16..n - i] {
+        i += 16;
+    }
+    while i < n && a[n - i - 1] == b[n - i - 1] {
+        i += 1;
+    }
+    i
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_version_lines() {
+        let v = Version::new(b"a\n\nb".to_vec());
+        assert_eq!(v.len(), 3);
+        assert_eq!((v.line(0), v.line(1), v.line(2)), (&b"a\n"[..], &b"\n"[..], &b"b"[..]));
+        assert_eq!(Version::new(Vec::new()).len(), 0);
+        assert_eq!(Version::new(b"a\nb\n".to_vec()).len(), 2);
+    }
+
+    #[test]
+    fn test_line_map_matches_whole_diff() {
+        // Runs of repeated and blank lines make hunks slide, some through
+        // long blank stretches that reach past the margins
+        let mut seed = 7u32;
+        let mut rand = |n: usize| {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            seed as usize % n
+        };
+        let pieces = ["fn f() {\n", "    x();\n", "}\n", "\n", "\n", "    y();\n"];
+        for round in 0..200 {
+            let len = 20 + rand(400);
+            let mut lines: Vec<&str> = (0..len).map(|_| pieces[rand(pieces.len())]).collect();
+            if round % 4 == 0 {
+                let at = rand(len);
+                lines.splice(at..at, std::iter::repeat("\n").take(150));
+            }
+            let mut edited = lines.clone();
+            for _ in 0..1 + rand(3) {
+                let at = rand(edited.len());
+                match rand(3) {
+                    0 => edited[at] = pieces[rand(pieces.len())],
+                    1 => edited.insert(at, pieces[rand(pieces.len())]),
+                    _ => {
+                        edited.remove(at);
+                    }
+                }
+            }
+            let ours = Version::new(edited.concat().into_bytes());
+            let theirs = Version::new(lines.concat().into_bytes());
+
+            let mut expected = vec![None; ours.len()];
+            let whole = diff::line_matches(&theirs.diff_lines(0..theirs.len()), &ours.diff_lines(0..ours.len()));
+            for (t, o) in whole {
+                expected[o] = Some(t as u32);
+            }
+            let map = line_map(&ours, &theirs);
+            let got: Vec<_> = (0..ours.len() as u32).map(|o| map.get(o)).collect();
+            assert_eq!(got, expected, "round {}", round);
+        }
+    }
+
+    #[test]
+    fn test_record_round_trip() {
+        let hunk = |commit: u8, time: i64, lines: Vec<u32>| Hunk {
+            commit: [commit; 20],
+            author: format!("author {}", commit),
+            time,
+            lines,
+        };
+        let mut record = Record::new([9; 20], [8; 20], 4);
+        record.add(&hunk(1, 100, vec![0, 3]));
+        record.add(&hunk(2, 200, vec![1, 2]));
+
+        let decoded = Record::decode(&record.encode()).unwrap();
+        assert_eq!((decoded.commit, decoded.blob), ([9; 20], [8; 20]));
+        assert_eq!(decoded.origin, [0, 1, 1, 0]);
+
+        // Lines reaching the recorded version come back as hunks at their
+        // lines at HEAD, oldest commit first
+        let hunks = decoded.hunks(&[(3, 10), (1, 11), (0, 12)]);
+        let got: Vec<_> = hunks.iter().map(|h| (h.commit[0], h.author.as_str(), h.lines.clone())).collect();
+        assert_eq!(got, [(1, "author 1", vec![10, 12]), (2, "author 2", vec![11])]);
+
+        // Incomplete records are not stored, but never trusted either
+        let encoded = Record::new([9; 20], [8; 20], 1).encode();
+        assert!(Record::decode(&encoded).is_none());
+        assert!(Record::decode(&record.encode()[..50]).is_none());
+    }
+
+    #[test]
+    fn test_common_ends() {
+        assert_eq!(common_prefix(b"abcdefghijklmnopqrstuvwxyz", b"abcdefghijklmnopqrsTUV"), 19);
+        assert_eq!(common_prefix(b"abc", b"abc"), 3);
+        assert_eq!(common_suffix(b"0123456789abcdefghij", b"x123456789abcdefghij"), 19);
+        assert_eq!(common_suffix(b"ab", b"b"), 1);
+        assert_eq!(common_suffix(b"", b"b"), 0);
+    }
+}
@@ -0,0 +1,74 @@
+//! Lines of a working file changed since HEAD, for the diff gutter
+//!
+//! One line diff of the working file against its HEAD version, read
+//! in-process like blame. Each changed stretch marks its new lines as
+//! modified where they replace old lines and as added beyond that. A
+//! stretch that only removes lines marks the line above it, or the first
+//! line when the removal is at the top.
+
+use std::io;
+use std::path::Path;
+
+use crate::diff;
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum Change {
+    Added,
+    Modified,
+    /// Lines were removed after this one
+    RemovedBelow,
+    /// Lines were removed before this one, the first
+    RemovedAbove,
+}
+
+/// Marks for each line of `text`, the working-tree file at `path`, against
+/// HEAD. A file HEAD does not have is all added.
+pub fn against_head(path: &Path, text: &[u8]) -> io::Result<Vec<Option<Change>>> {
+    let head = super::head_file(path)?.unwrap_or_default();
+    Ok(marks(&head, text))
+}
+
+fn marks(old: &[u8], new: &[u8]) -> Vec<Option<Change>> {
+    let lines = |data: &[u8]| -> Vec<diff::Line> { data.split_inclusive(|&b| b == b'\n').map(diff::Line::new).collect() };
+    let (old, new) = (lines(old), lines(new));
+    let mut marks = vec![None; new.len()];
+
+    let (mut i, mut j) = (0, 0);
+    for (oi, nj) in diff::line_matches(&old, &new).into_iter().chain([(old.len(), new.len())]) {
+        let removed = oi - i;
+        for k in j..nj {
+            marks[k] = Some(if k - j < removed { Change::Modified } else { Change::Added });
+        }
+        if removed > 0 && nj == j {
+            if j > 0 {
+                marks[j - 1] = Some(Change::RemovedBelow);
+            } else if let Some(first) = marks.first_mut() {
+                *first = Some(Change::RemovedAbove);
+            }
+        }
+        (i, j) = (oi + 1, nj + 1);
+    }
+    marks
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_marks() {
+        use Change::*;
+        let old = b"a\nb\nc\nd\ne\n";
+        // b modified, x added after it, d removed
+        assert_eq!(
+            marks(old, b"a\nB\nx\nc\ne\n"),
+            [None, Some(Modified), Some(Added), Some(RemovedBelow), None]
+        );
+        assert_eq!(marks(old, b"b\nc\nd\ne\n"), [Some(RemovedAbove), None, None, None]);
+        assert_eq!(marks(b"", b"a\nb"), [Some(Added), Some(Added)]);
+        assert_eq!(marks(old, old), [None; 5]);
+        assert!(marks(old, b"").is_empty());
+    }
+}
@@ -0,0 +1,286 @@
+//! Commit-graph reader
+//!
+//! `objects/info/commit-graph`, or a split chain under
+//! `objects/info/commit-graphs/`, stores each commit's root tree, parents
+//! and date in fixed-size records. A history walk can then step through
+//! thousands of commits without inflating a single commit object.
+//!
+//! Offsets read from the file are bounds-checked; a corrupt graph yields
+//! `None`, and callers read the commit object instead.
+
+use std::fs;
+use std::path::Path;
+
+use super::{Commit, Oid};
+
+const SIGNATURE: &[u8] = b"CGPH";
+const CHUNK_OIDF: u32 = 0x4f49_4446;
+const CHUNK_OIDL: u32 = 0x4f49_444c;
+const CHUNK_CDAT: u32 = 0x4344_4154;
+const CHUNK_EDGE: u32 = 0x4544_4745;
+
+const PARENT_NONE: u32 = 0x7000_0000;
+const PARENT_EXTRA: u32 = 0x8000_0000;
+
+/// Tree id, two parent positions, generation and date
+const CDAT_WIDTH: usize = 20 + 16;
+
+pub struct Graph {
+    /// Base layer first; positions count on from the layers below
+    layers: Vec<Layer>,
+}
+
+struct Layer {
+    data: Vec<u8>,
+    /// Commits in all lower layers
+    base: u32,
+    count: u32,
+    oidf: usize,
+    oidl: usize,
+    cdat: usize,
+    edge: Option<usize>,
+}
+
+fn be32(b: &[u8], at: usize) -> Option<u32> {
+    Some(u32::from_be_bytes(b.get(at..at.checked_add(4)?)?.try_into().ok()?))
+}
+
+fn be64(b: &[u8], at: usize) -> Option<u64> {
+    Some(u64::from_be_bytes(b.get(at..at.checked_add(8)?)?.try_into().ok()?))
+}
+
+impl Graph {
+    /// Load the commit-graph of an objects directory, if it has a usable one.
+    pub fn open(objects: &Path) -> Option<Graph> {
+        let info = objects.join("info");
+        let files: Vec<_> = match fs::read_to_string(info.join("commit-graphs/commit-graph-chain")) {
+            Ok(chain) => chain
+                .lines()
+                .map(str::trim)
+                .filter(|l| !l.is_empty())
+                .map(|hash| info.join("commit-graphs").join(format!("graph-{}.graph", hash)))
+                .collect(),
+            Err(_) => vec![info.join("commit-graph")],
+        };
+
+        let mut layers = Vec::new();
+        let mut base = 0;
+        for file in files {
+            let layer = Layer::parse(fs::read(file).ok()?, base)?;
+            base += layer.count;
+            layers.push(layer);
+        }
+        (!layers.is_empty()).then_some(Graph { layers })
+    }
+
+    fn position(&self, oid: &Oid) -> Option<u32> {
+        self.layers.iter().find_map(|layer| layer.find(oid).map(|i| layer.base + i))
+    }
+
+    fn layer_of(&self, pos: u32) -> Option<(&Layer, usize)> {
+        self.layers
+            .iter()
+            .find(|l| pos >= l.base && pos < l.base + l.count)
+            .map(|l| (l, (pos - l.base) as usize))
+    }
+
+    fn oid(&self, pos: u32) -> Option<Oid> {
+        let (layer, i) = self.layer_of(pos)?;
+        Some(layer.data[layer.oidl + i * 20..layer.oidl + i * 20 + 20].try_into().expect("20 bytes"))
+    }
+
+    /// Tree, parents and committer date of `oid`, if the graph has it.
+    pub fn commit(&self, oid: &Oid) -> Option<Commit> {
+        let (layer, i) = self.layer_of(self.position(oid)?)?;
+        let record = layer.cdat + i * CDAT_WIDTH;
+        let d = &layer.data;
+        let tree: Oid = d[record..record + 20].try_into().expect("20 bytes");
+        let p1 = be32(d, record + 20)?;
+        let p2 = be32(d, record + 24)?;
+        // Low 34 bits: seconds; the rest is the generation number
+        let time = (be64(d, record + 28)? & 0x3_ffff_ffff) as i64;
+
+        let mut parents = Vec::new();
+        if p1 != PARENT_NONE {
+            parents.push(self.oid(p1)?);
+        }
+        if p2 & PARENT_EXTRA != 0 {
+            // Octopus merge: the rest of the parents are in the edge list
+            let edge = layer.edge?;
+            let mut at = edge + (p2 & !PARENT_EXTRA) as usize * 4;
+            loop {
+                let p = be32(d, at)?;
+                parents.push(self.oid(p & !PARENT_EXTRA)?);
+                if p & PARENT_EXTRA != 0 {
+                    break;
+                }
+                at += 4;
+            }
+        } else if p2 != PARENT_NONE {
+            parents.push(self.oid(p2)?);
+        }
+        Some(Commit { tree, parents, time })
+    }
+}
+
+impl Layer {
+    fn parse(data: Vec<u8>, base: u32) -> Option<Layer> {
+        // Version 1, SHA-1
+        if data.len() < 8 || &data[..4] != SIGNATURE || data[4] != 1 || data[5] != 1 {
+            return None;
+        }
+        let chunks = data[6] as usize;
+        let mut oidf = None;
+        let mut oidl = None;
+        let mut cdat = None;
+        let mut edge = None;
+        for i in 0..chunks {
+            let at = 8 + i * 12;
+            if at + 12 > data.len() {
+                return None;
+            }
+            let offset = usize::try_from(be64(&data, at + 4)?).ok().filter(|&o| o <= data.len())?;
+            match be32(&data, at)? {
+                CHUNK_OIDF => oidf = Some(offset),
+                CHUNK_OIDL => oidl = Some(offset),
+                CHUNK_CDAT => cdat = Some(offset),
+                CHUNK_EDGE => edge = Some(offset),
+                _ => {}
+            }
+        }
+        let (oidf, oidl, cdat) = (oidf?, oidl?, cdat?);
+        let count = be32(&data, oidf + 255 * 4)?;
+        let n = count as usize;
+        if oidl + n * 20 > data.len() || cdat + n * CDAT_WIDTH > data.len() {
+            return None;
+        }
+        Some(Layer {
+            data,
+            base,
+            count,
+            oidf,
+            oidl,
+            cdat,
+            edge,
+        })
+    }
+
+    fn find(&self, oid: &Oid) -> Option<u32> {
+        let first = oid[0] as usize;
+        let mut lo = if first == 0 { 0 } else { be32(&self.data, self.oidf + (first - 1) * 4)? };
+        let mut hi = be32(&self.data, self.oidf + first * 4)?.min(self.count);
+        while lo < hi {
+            let mid = (lo + hi) / 2;
+            let at = self.oidl + mid as usize * 20;
+            match self.data[at..at + 20].cmp(&oid[..]) {
+                std::cmp::Ordering::Less => lo = mid + 1,
+                std::cmp::Ordering::Greater => hi = mid,
+                std::cmp::Ordering::Equal => return Some(mid),
+            }
+        }
+        None
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// A commit-graph file holding `commits` (id, parent positions, date),
+    /// which must be sorted by id, with `edges` as its EDGE chunk.
+    fn graph_file(commits: &[(Oid, [u32; 2], u64)], edges: &[u32]) -> Vec<u8> {
+        let chunks = if edges.is_empty() { 3 } else { 4 };
+        let mut offset = 8 + (chunks + 1) * 12;
+        let mut table = Vec::new();
+        let mut body = Vec::new();
+
+        let mut oidf = vec![0u32; 256];
+        for (oid, _, _) in commits {
+            for count in &mut oidf[oid[0] as usize..] {
+                *count += 1;
+            }
+        }
+        let oidl: Vec<u8> = commits.iter().flat_map(|(oid, _, _)| *oid).collect();
+        let mut cdat = Vec::new();
+        for (_, parents, time) in commits {
+            cdat.extend_from_slice(&[0; 20]);
+            cdat.extend_from_slice(&parents[0].to_be_bytes());
+            cdat.extend_from_slice(&parents[1].to_be_bytes());
+            cdat.extend_from_slice(&time.to_be_bytes());
+        }
+        let edge: Vec<u8> = edges.iter().flat_map(|e| e.to_be_bytes()).collect();
+        let oidf: Vec<u8> = oidf.iter().flat_map(|c| c.to_be_bytes()).collect();
+
+        for (id, chunk) in [(CHUNK_OIDF, oidf), (CHUNK_OIDL, oidl), (CHUNK_CDAT, cdat), (CHUNK_EDGE, edge)]
+            .into_iter()
+            .take(chunks)
+        {
+            table.extend_from_slice(&id.to_be_bytes());
+            table.extend_from_slice(&(offset as u64).to_be_bytes());
+            offset += chunk.len();
+            body.extend(chunk);
+        }
+        table.extend_from_slice(&[0; 4]);
+        table.extend_from_slice(&(offset as u64).to_be_bytes());
+
+        let mut file = vec![b'C', b'G', b'P', b'H', 1, 1, chunks as u8, 0];
+        file.extend(table);
+        file.extend(body);
+        file
+    }
+
+    fn oid(first: u8) -> Oid {
+        [first; 20]
+    }
+
+    #[test]
+    fn test_split_chain() {
+        let objects = std::env::temp_dir().join(format!("vita-graph-chain-{}", std::process::id()));
+        let dir = objects.join("info/commit-graphs");
+        let _ = fs::remove_dir_all(&objects);
+        fs::create_dir_all(&dir).unwrap();
+
+        // Base layer: a root commit and its child; top layer: a merge of both
+        let base = graph_file(&[(oid(1), [PARENT_NONE; 2], 100), (oid(2), [0, PARENT_NONE], 200)], &[]);
+        let top = graph_file(&[(oid(3), [1, 0], 300)], &[]);
+        fs::write(dir.join("graph-base.graph"), base).unwrap();
+        fs::write(dir.join("graph-top.graph"), top).unwrap();
+        fs::write(dir.join("commit-graph-chain"), "base\ntop\n").unwrap();
+
+        let graph = Graph::open(&objects).unwrap();
+        let merge = graph.commit(&oid(3)).unwrap();
+        assert_eq!(merge.parents, vec![oid(2), oid(1)]);
+        assert_eq!(merge.time, 300);
+        assert!(graph.commit(&oid(1)).unwrap().parents.is_empty());
+        assert!(graph.commit(&oid(4)).is_none());
+
+        fs::remove_dir_all(&objects).unwrap();
+    }
+
+    #[test]
+    fn test_edge_parents() {
+        let commits = [
+            (oid(1), [PARENT_NONE; 2], 1),
+            (oid(2), [PARENT_NONE; 2], 2),
+            (oid(3), [PARENT_NONE; 2], 3),
+            // Octopus: first parent inline, the others from EDGE index 0
+            (oid(4), [0, PARENT_EXTRA], 4),
+            // Edge list index far past the chunk
+            (oid(5), [0, PARENT_EXTRA | 1000], 5),
+        ];
+        let layer = Layer::parse(graph_file(&commits, &[1, 2 | PARENT_EXTRA]), 0).unwrap();
+        let graph = Graph { layers: vec![layer] };
+        assert_eq!(graph.commit(&oid(4)).unwrap().parents, vec![oid(1), oid(2), oid(3)]);
+        assert!(graph.commit(&oid(5)).is_none());
+    }
+
+    #[test]
+    fn test_corrupt_chunk_offsets() {
+        let mut file = graph_file(&[(oid(1), [PARENT_NONE; 2], 1)], &[]);
+        // Point OIDF past the end of the file
+        file[12..20].copy_from_slice(&u64::MAX.to_be_bytes());
+        assert!(Layer::parse(file, 0).is_none());
+    }
+}
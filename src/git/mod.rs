@@ -0,0 +1,547 @@
+//! Read-only git repository access
+//!
+//! Just enough of git's on-disk format for blame, `REV:path` arguments and
+//! the diff gutter without a `git` binary. Covers repository discovery
+//! (including linked worktrees and alternates), HEAD, ref and revision
+//! (`main~2`, `v1.0^2`, `1a2b3c`) resolution, and loose objects. Packed
+//! objects are read from idx v2 / packfiles, resolving offset and ref
+//! deltas, and the commit-graph provides parents and dates without
+//! inflating commits. Nothing is ever written.
+//!
+//! SHA-256 repositories and the reftable ref format report
+//! `ErrorKind::Unsupported`, so callers can fall back to the git CLI.
+//!
+//! Architecture:
+//!   mod.rs   - Repository discovery, refs, object lookup and parsing
+//!   pack.rs  - Pack index lookup, pack entry decoding, delta application
+//!   graph.rs - Commit-graph files (single file or split chain)
+//!   blame.rs - Line attribution over the history walk
+//!   changes.rs - Working-file lines changed since HEAD (diff gutter)
+
+pub mod blame;
+pub mod changes;
+mod graph;
+mod pack;
+
+pub use blame::Blame;
+
+use std::env;
+use std::fs;
+use std::io::{self, Read};
+use std::path::{Path, PathBuf};
+
+use flate2::read::ZlibDecoder;
+
+pub type Oid = [u8; 20];
+
+/// The all-zero id, used for lines not committed yet
+pub const ZERO_OID: Oid = [0; 20];
+
+/// Git's mode bits for a subdirectory entry
+const MODE_TREE: u32 = 0o040000;
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Kind {
+    Commit,
+    Tree,
+    Blob,
+    Tag,
+}
+
+impl Kind {
+    fn from_name(name: &[u8]) -> Option<Kind> {
+        match name {
+            b"commit" => Some(Kind::Commit),
+            b"tree" => Some(Kind::Tree),
+            b"blob" => Some(Kind::Blob),
+            b"tag" => Some(Kind::Tag),
+            _ => None,
+        }
+    }
+}
+
+/// What a history walk needs from a commit
+pub struct Commit {
+    pub tree: Oid,
+    pub parents: Vec<Oid>,
+    /// Committer time, seconds since the epoch
+    pub time: i64,
+}
+
+fn invalid(msg: impl Into<String>) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.into())
+}
+
+fn unsupported(msg: impl Into<String>) -> io::Error {
+    io::Error::new(io::ErrorKind::Unsupported, msg.into())
+}
+
+pub fn parse_hex(hex: &[u8]) -> Option<Oid> {
+    if hex.len() != 40 {
+        return None;
+    }
+    let mut oid = [0u8; 20];
+    for (i, pair) in hex.chunks(2).enumerate() {
+        let digit = |c: u8| (c as char).to_digit(16);
+        oid[i] = (digit(pair[0])? * 16 + digit(pair[1])?) as u8;
+    }
+    Some(oid)
+}
+
+pub fn to_hex(oid: &Oid) -> String {
+    oid.iter().map(|b| format!("{:02x}", b)).collect()
+}
+
+pub struct Repo {
+    git_dir: PathBuf,
+    /// Shared part of a linked worktree's git dir (the git dir otherwise)
+    common_dir: PathBuf,
+    pub work_dir: PathBuf,
+    object_dirs: Vec<PathBuf>,
+    packs: Vec<pack::Pack>,
+    graph: Option<graph::Graph>,
+}
+
+impl Repo {
+    /// Open the repository containing `path` (a file or directory).
+    pub fn discover(path: &Path) -> io::Result<Repo> {
+        let path = path.canonicalize()?;
+        let start = if path.is_dir() { path.as_path() } else { path.parent().unwrap_or(&path) };
+
+        for dir in start.ancestors() {
+            let dot_git = dir.join(".git");
+            let git_dir = if dot_git.is_dir() {
+                dot_git
+            } else if dot_git.is_file() {
+                let text = fs::read_to_string(&dot_git)?;
+                let target = text
+                    .strip_prefix("gitdir:")
+                    .map(str::trim)
+                    .ok_or_else(|| invalid("malformed .git file"))?;
+                dir.join(target)
+            } else {
+                continue;
+            };
+            return Repo::open(git_dir, dir.to_path_buf());
+        }
+        Err(io::Error::new(io::ErrorKind::NotFound, "not a git repository"))
+    }
+
+    fn open(git_dir: PathBuf, work_dir: PathBuf) -> io::Result<Repo> {
+        let common_dir = match fs::read_to_string(git_dir.join("commondir")) {
+            Ok(rel) => git_dir.join(rel.trim()),
+            Err(_) => git_dir.clone(),
+        };
+
+        let config = fs::read_to_string(common_dir.join("config"))
+            .unwrap_or_default()
+            .to_lowercase()
+            .replace([' ', '\t'], "");
+        if config.contains("objectformat=sha256") {
+            return Err(unsupported("SHA-256 repositories are not supported"));
+        }
+        if config.contains("refstorage=reftable") {
+            return Err(unsupported("reftable repositories are not supported"));
+        }
+
+        let objects = common_dir.join("objects");
+        let mut object_dirs = vec![objects.clone()];
+        if let Ok(alternates) = fs::read_to_string(objects.join("info/alternates")) {
+            for line in alternates.lines().map(str::trim) {
+                if !line.is_empty() && !line.starts_with('#') {
+                    object_dirs.push(objects.join(line));
+                }
+            }
+        }
+
+        let mut packs = Vec::new();
+        for dir in &object_dirs {
+            let Ok(entries) = fs::read_dir(dir.join("pack")) else { continue };
+            for entry in entries.flatten() {
+                let path = entry.path();
+                if path.extension().map_or(false, |e| e == "idx") && path.with_extension("pack").exists() {
+                    packs.push(pack::Pack::open(&path)?);
+                }
+            }
+        }
+
+        Ok(Repo {
+            graph: graph::Graph::open(&objects),
+            git_dir,
+            common_dir,
+            work_dir,
+            object_dirs,
+            packs,
+        })
+    }
+
+    /// The commit HEAD points at.
+    pub fn head(&self) -> io::Result<Oid> {
+        self.ref_target("HEAD")
+    }
+
+    /// Object ref `name` points at, following symbolic refs.
+    fn ref_target(&self, name: &str) -> io::Result<Oid> {
+        let mut target = self.read_ref(name)?;
+        // Symbolic refs may chain; git caps the depth at 5
+        for _ in 0..5 {
+            let Some(name) = target.strip_prefix("ref:").map(str::trim) else {
+                let hex = target.split_whitespace().next().unwrap_or("");
+                return parse_hex(hex.as_bytes()).ok_or_else(|| invalid(format!("malformed ref '{}'", name)));
+            };
+            target = self.read_ref(name)?;
+        }
+        Err(invalid("symbolic ref loop"))
+    }
+
+    /// Object named by `rev`: a full or abbreviated id, HEAD, or a ref,
+    /// branch, tag or remote name, followed by any `~N` / `^N` steps.
+    pub fn resolve(&self, rev: &str) -> io::Result<Oid> {
+        let unknown = || io::Error::new(io::ErrorKind::NotFound, format!("unknown revision '{}'", rev));
+        let (name, steps) = rev_steps(rev).ok_or_else(unknown)?;
+        let mut oid = self.resolve_name(name)?.ok_or_else(unknown)?;
+        for (op, n) in steps {
+            oid = self.peel(oid, Kind::Commit)?;
+            let parents = |oid: &Oid| self.commit(oid).map(|c| c.parents);
+            match (op, n) {
+                ('~', n) => {
+                    for _ in 0..n {
+                        oid = *parents(&oid)?.first().ok_or_else(unknown)?;
+                    }
+                }
+                (_, 0) => {}
+                (_, n) => oid = *parents(&oid)?.get(n - 1).ok_or_else(unknown)?,
+            }
+        }
+        Ok(oid)
+    }
+
+    /// `rev` without steps, in git's order: HEAD-like names and full refs,
+    /// then tags, branches and remotes, then abbreviated ids.
+    fn resolve_name(&self, name: &str) -> io::Result<Option<Oid>> {
+        if let Some(oid) = parse_hex(name.as_bytes()) {
+            return Ok(Some(oid));
+        }
+        let name = if name == "@" { "HEAD" } else { name };
+        // Only all-caps names (HEAD, ORIG_HEAD) live directly in the git dir
+        let direct = name.starts_with("refs/") || name.bytes().all(|b| b.is_ascii_uppercase() || b == b'_');
+        let candidates = [
+            direct.then(|| name.to_string()),
+            Some(format!("refs/{}", name)),
+            Some(format!("refs/tags/{}", name)),
+            Some(format!("refs/heads/{}", name)),
+            Some(format!("refs/remotes/{}", name)),
+            Some(format!("refs/remotes/{}/HEAD", name)),
+        ];
+        for candidate in candidates.iter().flatten() {
+            match self.ref_target(candidate) {
+                Ok(oid) => return Ok(Some(oid)),
+                Err(e) if e.kind() == io::ErrorKind::NotFound => {}
+                Err(e) => return Err(e),
+            }
+        }
+
+        if name.len() < 4 || !name.bytes().all(|b| b.is_ascii_hexdigit()) {
+            return Ok(None);
+        }
+        let prefix = name.to_ascii_lowercase();
+        let mut found = Vec::new();
+        for pack in &self.packs {
+            pack.find_prefix(&prefix, &mut found);
+        }
+        for dir in &self.object_dirs {
+            let Ok(entries) = fs::read_dir(dir.join(&prefix[..2])) else { continue };
+            for entry in entries.flatten() {
+                let hex = format!("{}{}", &prefix[..2], entry.file_name().to_string_lossy());
+                if hex.starts_with(&prefix) {
+                    found.extend(parse_hex(hex.as_bytes()));
+                }
+            }
+        }
+        found.sort_unstable();
+        found.dedup();
+        match found[..] {
+            [] => Ok(None),
+            [oid] => Ok(Some(oid)),
+            _ => Err(invalid(format!("short id '{}' is ambiguous", name))),
+        }
+    }
+
+    /// Follow tags, and a commit to its tree, from `oid` to a `want`.
+    fn peel(&self, mut oid: Oid, want: Kind) -> io::Result<Oid> {
+        // Bounded, as a tag may point at a tag
+        for _ in 0..16 {
+            let (kind, data) = self.read(&oid)?;
+            if kind == want {
+                return Ok(oid);
+            }
+            oid = match kind {
+                Kind::Tag => header_lines(&data)
+                    .find_map(|line| line.strip_prefix(b"object "))
+                    .and_then(parse_hex)
+                    .ok_or_else(|| invalid("malformed tag"))?,
+                Kind::Commit if want == Kind::Tree => self.commit(&oid)?.tree,
+                _ => return Err(invalid(format!("object {} is a {:?}, not a {:?}", to_hex(&oid), kind, want))),
+            };
+        }
+        Err(invalid("tag chain too long"))
+    }
+
+    /// Contents of `path` at revision `rev`, as `git show REV:path` prints
+    /// them. The path is from the top of the work tree, or from the current
+    /// directory when it starts with `./` or `../`.
+    pub fn show(&self, rev: &str, path: &str) -> io::Result<Vec<u8>> {
+        let tree = self.peel(self.resolve(rev)?, Kind::Tree)?;
+        let base = if path.starts_with("./") || path.starts_with("../") {
+            self.relative(&env::current_dir()?)?
+        } else {
+            Vec::new()
+        };
+        let missing = || io::Error::new(io::ErrorKind::NotFound, format!("path '{}' does not exist in '{}'", path, rev));
+        let components = tree_path(base, path).ok_or_else(missing)?;
+        let blob = self.blob_at(&tree, &components)?.ok_or_else(missing)?;
+        self.read_kind(&blob, Kind::Blob)
+    }
+
+    /// Contents of ref `name`: loose ref file first, then packed-refs.
+    fn read_ref(&self, name: &str) -> io::Result<String> {
+        for dir in [&self.git_dir, &self.common_dir] {
+            if let Ok(text) = fs::read_to_string(dir.join(name)) {
+                return Ok(text.trim().to_string());
+            }
+        }
+        let packed = fs::read_to_string(self.common_dir.join("packed-refs")).unwrap_or_default();
+        packed
+            .lines()
+            .filter(|l| !l.starts_with('#') && !l.starts_with('^'))
+            .find_map(|l| {
+                let (oid, refname) = l.split_once(' ')?;
+                (refname == name).then(|| oid.to_string())
+            })
+            .ok_or_else(|| io::Error::new(io::ErrorKind::NotFound, format!("ref '{}' not found", name)))
+    }
+
+    /// Kind and contents of object `oid`.
+    pub fn read(&self, oid: &Oid) -> io::Result<(Kind, Vec<u8>)> {
+        for pack in &self.packs {
+            if let Some(offset) = pack.find(oid) {
+                return pack.read_at(offset?, self);
+            }
+        }
+        let hex = to_hex(oid);
+        for dir in &self.object_dirs {
+            let Ok(file) = fs::File::open(dir.join(&hex[..2]).join(&hex[2..])) else { continue };
+            let mut data = Vec::new();
+            ZlibDecoder::new(file).read_to_end(&mut data)?;
+            let nul = data.iter().position(|&b| b == 0).ok_or_else(|| invalid("malformed loose object"))?;
+            let kind = data[..nul]
+                .split(|&b| b == b' ')
+                .next()
+                .and_then(Kind::from_name)
+                .ok_or_else(|| invalid("malformed loose object"))?;
+            data.drain(..=nul);
+            return Ok((kind, data));
+        }
+        // Not `NotFound`: a missing object (partial clone) is a reason to
+        // let the git CLI try, not a user error
+        Err(invalid(format!("object {} not found", hex)))
+    }
+
+    fn read_kind(&self, oid: &Oid, want: Kind) -> io::Result<Vec<u8>> {
+        match self.read(oid)? {
+            (kind, data) if kind == want => Ok(data),
+            (kind, _) => Err(invalid(format!("object {} is a {:?}, not a {:?}", to_hex(oid), kind, want))),
+        }
+    }
+
+    /// Components of `path` relative to the working tree.
+    pub fn relative(&self, path: &Path) -> io::Result<Vec<Vec<u8>>> {
+        let abs = path.canonicalize()?;
+        let work_dir = self.work_dir.canonicalize()?;
+        let rel = abs
+            .strip_prefix(&work_dir)
+            .map_err(|_| io::Error::new(io::ErrorKind::NotFound, "file is outside the repository"))?;
+        Ok(rel
+            .components()
+            .map(|c| c.as_os_str().to_string_lossy().into_owned().into_bytes())
+            .collect())
+    }
+
+    /// Blob at `path` (as from `relative`) in `tree`, if a file is there.
+    pub fn blob_at(&self, tree: &Oid, path: &[Vec<u8>]) -> io::Result<Option<Oid>> {
+        let mut current = *tree;
+        for (depth, name) in path.iter().enumerate() {
+            let last = depth + 1 == path.len();
+            match self.tree_entry(&current, name)? {
+                Some((mode, oid)) if (mode == MODE_TREE) != last => current = oid,
+                _ => return Ok(None),
+            }
+        }
+        Ok(Some(current))
+    }
+
+    /// Tree, parents and date of a commit, from the commit-graph when it
+    /// covers `oid`.
+    pub fn commit(&self, oid: &Oid) -> io::Result<Commit> {
+        if let Some(commit) = self.graph.as_ref().and_then(|g| g.commit(oid)) {
+            return Ok(commit);
+        }
+        let data = self.read_kind(oid, Kind::Commit)?;
+        let mut commit = Commit {
+            tree: ZERO_OID,
+            parents: Vec::new(),
+            time: 0,
+        };
+        for line in header_lines(&data) {
+            if let Some(hex) = line.strip_prefix(b"tree ") {
+                commit.tree = parse_hex(hex).ok_or_else(|| invalid("malformed commit"))?;
+            } else if let Some(hex) = line.strip_prefix(b"parent ") {
+                commit.parents.push(parse_hex(hex).ok_or_else(|| invalid("malformed commit"))?);
+            } else if let Some(sig) = line.strip_prefix(b"committer ") {
+                commit.time = signature(sig).1;
+            }
+        }
+        Ok(commit)
+    }
+
+    /// Author name and time of a commit.
+    pub fn author(&self, oid: &Oid) -> io::Result<(String, i64)> {
+        let data = self.read_kind(oid, Kind::Commit)?;
+        let author = header_lines(&data)
+            .find_map(|line| line.strip_prefix(b"author "))
+            .map(signature);
+        author.ok_or_else(|| invalid("commit without author"))
+    }
+
+    /// Entry `name` of a tree: its mode and object id.
+    pub fn tree_entry(&self, tree: &Oid, name: &[u8]) -> io::Result<Option<(u32, Oid)>> {
+        let data = self.read_kind(tree, Kind::Tree)?;
+        let mut rest = &data[..];
+        while !rest.is_empty() {
+            let space = rest.iter().position(|&b| b == b' ').ok_or_else(|| invalid("malformed tree"))?;
+            let nul = rest.iter().position(|&b| b == 0).ok_or_else(|| invalid("malformed tree"))?;
+            if nul + 21 > rest.len() || space > nul {
+                return Err(invalid("malformed tree"));
+            }
+            if &rest[space + 1..nul] == name {
+                let mode = std::str::from_utf8(&rest[..space])
+                    .ok()
+                    .and_then(|m| u32::from_str_radix(m, 8).ok())
+                    .ok_or_else(|| invalid("malformed tree"))?;
+                let oid: Oid = rest[nul + 1..nul + 21].try_into().expect("20 bytes");
+                return Ok(Some((mode, oid)));
+            }
+            rest = &rest[nul + 21..];
+        }
+        Ok(None)
+    }
+}
+
+/// Split `rev` into its name and `~N` / `^N` steps (`N` defaults to 1).
+fn rev_steps(rev: &str) -> Option<(&str, Vec<(char, usize)>)> {
+    let at = rev.find(['~', '^']).unwrap_or(rev.len());
+    let (name, mut rest) = rev.split_at(at);
+    let mut steps = Vec::new();
+    while let Some(op) = rest.chars().next().filter(|&c| c == '~' || c == '^') {
+        rest = &rest[1..];
+        let digits = rest.find(|c: char| !c.is_ascii_digit()).unwrap_or(rest.len());
+        let n = if digits == 0 { 1 } else { rest[..digits].parse().ok()? };
+        steps.push((op, n));
+        rest = &rest[digits..];
+    }
+    (rest.is_empty() && !name.is_empty()).then_some((name, steps))
+}
+
+/// `path` appended to the components `base`, with `.` and `..` resolved;
+/// `None` when it climbs above the top.
+fn tree_path(mut base: Vec<Vec<u8>>, path: &str) -> Option<Vec<Vec<u8>>> {
+    for part in path.split('/') {
+        match part {
+            "" | "." => {}
+            ".." => {
+                base.pop()?;
+            }
+            name => base.push(name.as_bytes().to_vec()),
+        }
+    }
+    Some(base)
+}
+
+/// Contents of the working-tree file `path` as committed at HEAD; `None`
+/// when HEAD has no such file or there is no commit yet.
+pub fn head_file(path: &Path) -> io::Result<Option<Vec<u8>>> {
+    let repo = Repo::discover(path)?;
+    let rel = repo.relative(path)?;
+    let head = match repo.head() {
+        Ok(head) => head,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+        Err(e) => return Err(e),
+    };
+    let tree = repo.commit(&head)?.tree;
+    match repo.blob_at(&tree, &rel)? {
+        Some(blob) => repo.read_kind(&blob, Kind::Blob).map(Some),
+        None => Ok(None),
+    }
+}
+
+/// Header lines of a commit (up to the blank line before the message).
+fn header_lines(data: &[u8]) -> impl Iterator<Item = &[u8]> {
+    data.split(|&b| b == b'\n').take_while(|l| !l.is_empty())
+}
+
+/// Name and time from `Name <email> 1700000000 +0100`.
+fn signature(sig: &[u8]) -> (String, i64) {
+    let text = String::from_utf8_lossy(sig);
+    let (name, rest) = match text.find('<') {
+        Some(lt) => (text[..lt].trim(), text[lt..].split_once('>').map_or("", |(_, r)| r)),
+        None => (text.trim(), ""),
+    };
+    let time = rest.split_whitespace().next().and_then(|t| t.parse().ok()).unwrap_or(0);
+    (name.to_string(), time)
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_hex_round_trip() {
+        let hex = "0123456789abcdef0123456789abcdef01234567";
+        let oid = parse_hex(hex.as_bytes()).unwrap();
+        assert_eq!(to_hex(&oid), hex);
+        assert_eq!(parse_hex(b"0123"), None);
+        assert_eq!(parse_hex(&[b'g'; 40]), None);
+    }
+
+    #[test]
+    fn test_rev_steps() {
+        assert_eq!(rev_steps("main"), Some(("main", vec![])));
+        assert_eq!(rev_steps("HEAD~3^2"), Some(("HEAD", vec![('~', 3), ('^', 2)])));
+        assert_eq!(rev_steps("v1.0^^"), Some(("v1.0", vec![('^', 1), ('^', 1)])));
+        assert_eq!(rev_steps("HEAD^0"), Some(("HEAD", vec![('^', 0)])));
+        assert_eq!(rev_steps("~1"), None);
+        assert_eq!(rev_steps("HEAD~x"), None);
+    }
+
+    #[test]
+    fn test_tree_path() {
+        let base = vec![b"src".to_vec(), b"git".to_vec()];
+        let joined = |p: Option<Vec<Vec<u8>>>| p.map(|c| String::from_utf8(c.join(&b'/')).unwrap());
+        assert_eq!(joined(tree_path(base.clone(), "./mod.rs")), Some("src/git/mod.rs".into()));
+        assert_eq!(joined(tree_path(base.clone(), "../main.rs")), Some("src/main.rs".into()));
+        assert_eq!(joined(tree_path(Vec::new(), "src//lib.rs")), Some("src/lib.rs".into()));
+        assert_eq!(tree_path(base, "../../../x"), None);
+    }
+
+    #[test]
+    fn test_signature() {
+        assert_eq!(
+            signature(b"Alice Example <alice@example.com> 1700000000 +0100"),
+            ("Alice Example".to_string(), 1_700_000_000)
+        );
+        assert_eq!(signature(b"Bob <> 5 -0000"), ("Bob".to_string(), 5));
+        assert_eq!(signature(b"broken"), ("broken".to_string(), 0));
+    }
+}
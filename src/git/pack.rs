@@ -0,0 +1,343 @@
+//! Pack index (v2) lookup and packfile entry decoding
+//!
+//! The `.idx` file is loaded whole and searched through its fan-out table.
+//! Entries are read from the `.pack` file on demand and inflated with
+//! flate2. Delta bases are cached, since a chain's bases are shared by many
+//! neighbouring objects (successive versions of a tree or file).
+
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::fs::{self, File};
+use std::io::{self, BufReader, Read, Seek, SeekFrom};
+use std::path::Path;
+use std::rc::Rc;
+
+use flate2::read::ZlibDecoder;
+
+use super::{invalid, Kind, Oid, Repo};
+
+const IDX_MAGIC: &[u8] = b"\xfftOc";
+const FANOUT: usize = 8;
+const OIDS: usize = FANOUT + 256 * 4;
+
+/// Inflated delta bases kept, in bytes, before the cache is cleared
+const BASE_CACHE_BYTES: usize = 64 << 20;
+
+/// Most bytes reserved up front for an entry on the word of its header;
+/// larger entries grow as they inflate
+const PREALLOC_LIMIT: u64 = 16 << 20;
+
+pub struct Pack {
+    idx: Vec<u8>,
+    count: usize,
+    file: RefCell<File>,
+    bases: RefCell<BaseCache>,
+}
+
+#[derive(Default)]
+struct BaseCache {
+    entries: HashMap<u64, (Kind, Rc<Vec<u8>>)>,
+    bytes: usize,
+}
+
+fn be32(b: &[u8], at: usize) -> u32 {
+    u32::from_be_bytes(b[at..at + 4].try_into().expect("4 bytes"))
+}
+
+impl Pack {
+    pub fn open(idx_path: &Path) -> io::Result<Pack> {
+        let idx = fs::read(idx_path)?;
+        if idx.len() < OIDS || &idx[..4] != IDX_MAGIC || be32(&idx, 4) != 2 {
+            return Err(invalid(format!("{}: unsupported pack index", idx_path.display())));
+        }
+        let count = be32(&idx, FANOUT + 255 * 4) as usize;
+        // oids, crc32s, 32-bit offsets, trailer (two hashes)
+        if idx.len() < OIDS + count * 28 + 40 {
+            return Err(invalid(format!("{}: truncated pack index", idx_path.display())));
+        }
+        Ok(Pack {
+            idx,
+            count,
+            file: RefCell::new(File::open(idx_path.with_extension("pack"))?),
+            bases: RefCell::default(),
+        })
+    }
+
+    /// Offset of `oid` in the packfile, or an error when the index entry
+    /// is corrupt.
+    pub fn find(&self, oid: &Oid) -> Option<io::Result<u64>> {
+        let first = oid[0] as usize;
+        let lo = if first == 0 { 0 } else { be32(&self.idx, FANOUT + (first - 1) * 4) as usize };
+        let hi = be32(&self.idx, FANOUT + first * 4) as usize;
+        let oid_at = |i: usize| &self.idx[OIDS + i * 20..OIDS + i * 20 + 20];
+
+        let (mut lo, mut hi) = (lo, hi.min(self.count));
+        while lo < hi {
+            let mid = (lo + hi) / 2;
+            match oid_at(mid).cmp(&oid[..]) {
+                std::cmp::Ordering::Less => lo = mid + 1,
+                std::cmp::Ordering::Greater => hi = mid,
+                std::cmp::Ordering::Equal => return Some(self.offset(mid)),
+            }
+        }
+        None
+    }
+
+    /// Append the ids in this pack that start with the lowercase hex digits
+    /// `prefix` (at least two).
+    pub fn find_prefix(&self, prefix: &str, found: &mut Vec<Oid>) {
+        let Some(lowest) = super::parse_hex(format!("{:0<40}", prefix).as_bytes()) else { return };
+        let first = lowest[0] as usize;
+        let lo = if first == 0 { 0 } else { be32(&self.idx, FANOUT + (first - 1) * 4) as usize };
+        let hi = (be32(&self.idx, FANOUT + first * 4) as usize).min(self.count);
+        let oid_at = |i: usize| -> Oid { self.idx[OIDS + i * 20..OIDS + i * 20 + 20].try_into().expect("20 bytes") };
+
+        let (mut lo, mut end) = (lo, hi);
+        while lo < end {
+            let mid = (lo + end) / 2;
+            if oid_at(mid) < lowest {
+                lo = mid + 1;
+            } else {
+                end = mid;
+            }
+        }
+        for i in lo..hi {
+            let oid = oid_at(i);
+            if !super::to_hex(&oid).starts_with(prefix) {
+                break;
+            }
+            found.push(oid);
+        }
+    }
+
+    fn offset(&self, i: usize) -> io::Result<u64> {
+        let offsets = OIDS + self.count * 24;
+        let small = be32(&self.idx, offsets + i * 4);
+        if small & 0x8000_0000 == 0 {
+            return Ok(small as u64);
+        }
+        let large = offsets + self.count * 4 + (small & 0x7fff_ffff) as usize * 8;
+        self.idx
+            .get(large..large + 8)
+            .map(|b| u64::from_be_bytes(b.try_into().expect("8 bytes")))
+            .ok_or_else(|| invalid("pack index large offset out of range"))
+    }
+
+    /// Decode the entry at `offset`, resolving deltas. Ref-delta bases may
+    /// live in other packs or loose, hence `repo`.
+    pub fn read_at(&self, offset: u64, repo: &Repo) -> io::Result<(Kind, Vec<u8>)> {
+        let (kind, data) = self.entry(offset, repo)?;
+        Ok((kind, Rc::try_unwrap(data).unwrap_or_else(|rc| (*rc).clone())))
+    }
+
+    fn entry(&self, offset: u64, repo: &Repo) -> io::Result<(Kind, Rc<Vec<u8>>)> {
+        if let Some((kind, data)) = self.bases.borrow().entries.get(&offset) {
+            return Ok((*kind, Rc::clone(data)));
+        }
+
+        let (type_id, base, delta) = {
+            let mut file = self.file.borrow_mut();
+            file.seek(SeekFrom::Start(offset))?;
+            let mut r = BufReader::with_capacity(16 * 1024, &*file);
+
+            let mut c = byte(&mut r)?;
+            let type_id = (c >> 4) & 7;
+            let mut size = (c & 15) as u64;
+            let mut shift = 4;
+            while c & 0x80 != 0 {
+                c = byte(&mut r)?;
+                size |= ((c & 0x7f) as u64) << shift;
+                shift += 7;
+            }
+
+            let base = match type_id {
+                6 => {
+                    let mut c = byte(&mut r)?;
+                    let mut back = (c & 0x7f) as u64;
+                    while c & 0x80 != 0 {
+                        c = byte(&mut r)?;
+                        back = ((back + 1) << 7) | (c & 0x7f) as u64;
+                    }
+                    Some(Base::Offset(offset.checked_sub(back).ok_or_else(|| invalid("bad delta offset"))?))
+                }
+                7 => {
+                    let mut oid = [0u8; 20];
+                    r.read_exact(&mut oid)?;
+                    Some(Base::Ref(oid))
+                }
+                _ => None,
+            };
+
+            let mut data = Vec::with_capacity(size.min(PREALLOC_LIMIT) as usize);
+            ZlibDecoder::new(r).take(size).read_to_end(&mut data)?;
+            if data.len() as u64 != size {
+                return Err(invalid("truncated pack entry"));
+            }
+            (type_id, base, data)
+        };
+
+        let (kind, data) = match base {
+            None => {
+                let kind = match type_id {
+                    1 => Kind::Commit,
+                    2 => Kind::Tree,
+                    3 => Kind::Blob,
+                    4 => Kind::Tag,
+                    _ => return Err(invalid(format!("bad pack entry type {}", type_id))),
+                };
+                return Ok((kind, Rc::new(delta)));
+            }
+            Some(Base::Offset(at)) => {
+                let (kind, base) = self.entry(at, repo)?;
+                self.remember(at, kind, &base);
+                (kind, apply_delta(&base, &delta)?)
+            }
+            Some(Base::Ref(oid)) => {
+                let (kind, base) = repo.read(&oid)?;
+                (kind, apply_delta(&base, &delta)?)
+            }
+        };
+        Ok((kind, Rc::new(data)))
+    }
+
+    fn remember(&self, offset: u64, kind: Kind, data: &Rc<Vec<u8>>) {
+        let mut cache = self.bases.borrow_mut();
+        if cache.entries.contains_key(&offset) {
+            return;
+        }
+        if cache.bytes + data.len() > BASE_CACHE_BYTES {
+            cache.entries.clear();
+            cache.bytes = 0;
+        }
+        cache.bytes += data.len();
+        cache.entries.insert(offset, (kind, Rc::clone(data)));
+    }
+}
+
+enum Base {
+    Offset(u64),
+    Ref(Oid),
+}
+
+fn byte(r: &mut impl Read) -> io::Result<u8> {
+    let mut b = [0u8; 1];
+    r.read_exact(&mut b)?;
+    Ok(b[0])
+}
+
+/// Rebuild an object from its delta `base` and `delta` instructions.
+fn apply_delta(base: &[u8], delta: &[u8]) -> io::Result<Vec<u8>> {
+    let mut pos = 0;
+    let varint = |pos: &mut usize| -> io::Result<usize> {
+        let mut value = 0usize;
+        let mut shift = 0;
+        loop {
+            let c = *delta.get(*pos).ok_or_else(|| invalid("truncated delta"))?;
+            *pos += 1;
+            value |= ((c & 0x7f) as usize) << shift;
+            shift += 7;
+            if c & 0x80 == 0 {
+                return Ok(value);
+            }
+        }
+    };
+    let base_size = varint(&mut pos)?;
+    let result_size = varint(&mut pos)?;
+    if base_size != base.len() {
+        return Err(invalid("delta base size mismatch"));
+    }
+
+    // The size is only a claim; copies mostly come from the base
+    let mut out = Vec::with_capacity(result_size.min(base.len() + delta.len()));
+    while pos < delta.len() {
+        let op = delta[pos];
+        pos += 1;
+        if op & 0x80 != 0 {
+            // Copy from base: offset and size bytes present per flag bit
+            let mut field = |bits: std::ops::Range<u8>| -> io::Result<usize> {
+                let mut value = 0usize;
+                for (i, bit) in bits.enumerate() {
+                    if op & (1 << bit) != 0 {
+                        let b = *delta.get(pos).ok_or_else(|| invalid("truncated delta"))?;
+                        pos += 1;
+                        value |= (b as usize) << (8 * i);
+                    }
+                }
+                Ok(value)
+            };
+            let offset = field(0..4)?;
+            let size = match field(4..7)? {
+                0 => 0x10000,
+                n => n,
+            };
+            let chunk = base
+                .get(offset..offset + size)
+                .ok_or_else(|| invalid("delta copy out of range"))?;
+            out.extend_from_slice(chunk);
+        } else if op != 0 {
+            let chunk = delta
+                .get(pos..pos + op as usize)
+                .ok_or_else(|| invalid("truncated delta"))?;
+            out.extend_from_slice(chunk);
+            pos += op as usize;
+        } else {
+            return Err(invalid("reserved delta opcode"));
+        }
+    }
+    if out.len() != result_size {
+        return Err(invalid("delta result size mismatch"));
+    }
+    Ok(out)
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_apply_delta() {
+        let base = b"hello, world";
+        // sizes 12 -> 12; copy "hello" (offset 0, size 5); insert ", vita!"
+        let delta = [12, 12, 0x90, 5, 7, b',', b' ', b'v', b'i', b't', b'a', b'!'];
+        assert_eq!(apply_delta(base, &delta).unwrap(), b"hello, vita!");
+
+        // copy with an offset: "world" at 7
+        let delta = [12, 5, 0x91, 7, 5];
+        assert_eq!(apply_delta(base, &delta).unwrap(), b"world");
+
+        assert!(apply_delta(base, &[11, 1, 1, b'x']).is_err());
+        assert!(apply_delta(base, &[12, 5, 0x91, 10, 5]).is_err());
+
+        // A claimed result of 2^56 bytes is rejected, not allocated
+        let delta = [12, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 1, 0x90, 5];
+        assert!(apply_delta(base, &delta).is_err());
+    }
+
+    #[test]
+    fn test_large_offset_out_of_range() {
+        let dir = std::env::temp_dir().join(format!("vita-pack-{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let idx_path = dir.join("test.idx");
+
+        // One object whose offset points at entry 5 of an empty large table
+        let mut idx = IDX_MAGIC.to_vec();
+        idx.extend_from_slice(&2u32.to_be_bytes());
+        for _ in 0..256 {
+            idx.extend_from_slice(&1u32.to_be_bytes());
+        }
+        idx.extend_from_slice(&[0; 20]);
+        idx.extend_from_slice(&[0; 4]);
+        idx.extend_from_slice(&0x8000_0005u32.to_be_bytes());
+        idx.extend_from_slice(&[0; 40]);
+        fs::write(&idx_path, idx).unwrap();
+        fs::write(idx_path.with_extension("pack"), b"PACK").unwrap();
+
+        let pack = Pack::open(&idx_path).unwrap();
+        assert!(pack.find(&[0; 20]).unwrap().is_err());
+        assert!(pack.find(&[1; 20]).is_none());
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+}
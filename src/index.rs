@@ -0,0 +1,370 @@
+//! Persistent project symbol index (`vita -b DIR`)
+//!
+//! Stores the brief-mode structural lines of every outlinable file under a
+//! directory, keyed by relative path with the file's mtime and size. On each
+//! use the tree is walked in parallel, and only new or changed files are
+//! re-read and re-outlined, also in parallel. The index is then saved back
+//! to the cache, so repeated outlines and symbol searches over a large,
+//! unchanged repository cost one directory walk and one file read.
+
+use std::collections::HashMap;
+use std::fs;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+use std::thread;
+use std::time::UNIX_EPOCH;
+
+use crate::cache::{self, put_str, Cursor};
+use crate::detect::{detect_format, FileFormat};
+use crate::render::brief::structural_lines;
+
+const CACHE_BUCKET: &str = "index";
+const MAGIC: &[u8] = b"VIDX1\n";
+
+/// Directories never descended into (besides hidden ones)
+const SKIP_DIRS: &[&str] = &["target", "node_modules", "__pycache__", "vendor"];
+
+/// Stored structural lines are cut to this many bytes
+const MAX_LINE_TEXT: usize = 300;
+
+/// Files larger than this are listed but not outlined
+const MAX_FILE_SIZE: u64 = 16 << 20;
+
+#[derive(Clone, Debug, PartialEq)]
+pub struct FileEntry {
+    /// Path relative to the indexed root, `/`-separated
+    pub path: String,
+    mtime: u64,
+    size: u64,
+    /// `(1-based line number, text)` of each structural line
+    pub lines: Vec<(u32, String)>,
+}
+
+pub struct Index {
+    /// Entries sorted by path
+    pub files: Vec<FileEntry>,
+}
+
+/// A file found by the walk
+struct Found {
+    path: String,
+    abs: PathBuf,
+    mtime: u64,
+    size: u64,
+}
+
+impl Index {
+    /// Load the cached index for `root` and bring it up to date.
+    pub fn open(root: &Path) -> io::Result<Index> {
+        let root = root.canonicalize()?;
+        let cache_name = cache_name(&root);
+        let mut previous: HashMap<String, FileEntry> = cache::read(CACHE_BUCKET, &cache_name)
+            .and_then(|bytes| decode(&bytes))
+            .unwrap_or_default()
+            .into_iter()
+            .map(|e| (e.path.clone(), e))
+            .collect();
+
+        let mut files = Vec::new();
+        let mut stale = Vec::new();
+        for found in walk(&root) {
+            match previous.remove(&found.path) {
+                Some(entry) if entry.mtime == found.mtime && entry.size == found.size => files.push(entry),
+                _ => stale.push(found),
+            }
+        }
+        // Whatever is left in `previous` was deleted
+        let changed = !stale.is_empty() || !previous.is_empty();
+
+        files.extend(outline_all(stale));
+        files.sort_by(|a, b| a.path.cmp(&b.path));
+
+        let index = Index { files };
+        if changed {
+            cache::write(CACHE_BUCKET, &cache_name, &encode(&index.files));
+        }
+        Ok(index)
+    }
+}
+
+/// Cache entry name for the index of the canonical path `root`.
+fn cache_name(root: &Path) -> String {
+    format!("{:016x}", cache::key(&[root.to_string_lossy().as_bytes()]))
+}
+
+/// Whether brief mode has line-mapped structure for this format.
+fn is_outlinable(format: &FileFormat) -> bool {
+    matches!(
+        format,
+        FileFormat::Markdown | FileFormat::Toml | FileFormat::Yaml | FileFormat::Code(_)
+    )
+}
+
+/// List every outlinable file under `root`, walking directories on all cores.
+fn walk(root: &Path) -> Vec<Found> {
+    let queue = Mutex::new(vec![root.to_path_buf()]);
+    // Directories popped but not finished; the walk ends when this is zero
+    // and the queue is empty.
+    let active = AtomicUsize::new(0);
+    let found = Mutex::new(Vec::new());
+    let workers = thread::available_parallelism().map_or(1, |n| n.get()).min(16);
+
+    thread::scope(|scope| {
+        for _ in 0..workers {
+            scope.spawn(|| {
+                let mut local = Vec::new();
+                loop {
+                    let dir = {
+                        let mut q = queue.lock().unwrap();
+                        let dir = q.pop();
+                        if dir.is_some() {
+                            active.fetch_add(1, Ordering::SeqCst);
+                        }
+                        dir
+                    };
+                    let Some(dir) = dir else {
+                        if active.load(Ordering::SeqCst) == 0 {
+                            break;
+                        }
+                        thread::yield_now();
+                        continue;
+                    };
+                    if let Ok(entries) = fs::read_dir(&dir) {
+                        for entry in entries.flatten() {
+                            let name = entry.file_name();
+                            let name = name.to_string_lossy();
+                            if name.starts_with('.') {
+                                continue;
+                            }
+                            let Ok(kind) = entry.file_type() else { continue };
+                            let abs = entry.path();
+                            if kind.is_dir() {
+                                if !SKIP_DIRS.contains(&name.as_ref()) {
+                                    queue.lock().unwrap().push(abs);
+                                }
+                            } else if kind.is_file() && is_outlinable(&detect_format(&abs)) {
+                                if let Ok(meta) = entry.metadata() {
+                                    let mtime = meta
+                                        .modified()
+                                        .ok()
+                                        .and_then(|t| t.duration_since(UNIX_EPOCH).ok())
+                                        .map_or(0, |d| d.as_nanos() as u64);
+                                    local.push(Found {
+                                        path: relative(root, &abs),
+                                        abs,
+                                        mtime,
+                                        size: meta.len(),
+                                    });
+                                }
+                            }
+                        }
+                    }
+                    active.fetch_sub(1, Ordering::SeqCst);
+                }
+                found.lock().unwrap().extend(local);
+            });
+        }
+    });
+
+    found.into_inner().unwrap()
+}
+
+fn relative(root: &Path, abs: &Path) -> String {
+    let rel = abs.strip_prefix(root).unwrap_or(abs);
+    let parts: Vec<_> = rel.components().map(|c| c.as_os_str().to_string_lossy()).collect();
+    parts.join("/")
+}
+
+/// Read and outline `files` in parallel chunks.
+fn outline_all(files: Vec<Found>) -> Vec<FileEntry> {
+    if files.is_empty() {
+        return Vec::new();
+    }
+    let workers = thread::available_parallelism().map_or(1, |n| n.get());
+    let chunk = (files.len() + workers - 1) / workers;
+    thread::scope(|scope| {
+        let handles: Vec<_> = files
+            .chunks(chunk)
+            .map(|part| scope.spawn(move || part.iter().map(outline_one).collect::<Vec<_>>()))
+            .collect();
+        handles.into_iter().flat_map(|h| h.join().unwrap_or_default()).collect()
+    })
+}
+
+fn outline_one(found: &Found) -> FileEntry {
+    let lines = if found.size > MAX_FILE_SIZE {
+        Vec::new()
+    } else {
+        match fs::read_to_string(&found.abs) {
+            // The index is its own cache; no per-file symbol entries
+            Ok(content) => structural_lines(&content, &detect_format(&found.abs), None)
+                .into_iter()
+                .map(|(n, text)| (n as u32, clip(text).to_string()))
+                .collect(),
+            Err(_) => Vec::new(),
+        }
+    };
+    FileEntry {
+        path: found.path.clone(),
+        mtime: found.mtime,
+        size: found.size,
+        lines,
+    }
+}
+
+fn clip(text: &str) -> &str {
+    if text.len() <= MAX_LINE_TEXT {
+        return text;
+    }
+    let mut end = MAX_LINE_TEXT;
+    while !text.is_char_boundary(end) {
+        end -= 1;
+    }
+    &text[..end]
+}
+
+// ─── Storage format ───
+//
+// MAGIC, u32 file count, then per file: path, u64 mtime, u64 size,
+// u32 line count, and per line u32 number + text. Strings are a u32 byte
+// length followed by UTF-8. All integers are little-endian.
+
+fn encode(files: &[FileEntry]) -> Vec<u8> {
+    let mut buf = Vec::with_capacity(64 * files.len());
+    buf.extend_from_slice(MAGIC);
+    buf.extend_from_slice(&(files.len() as u32).to_le_bytes());
+    for f in files {
+        put_str(&mut buf, &f.path);
+        buf.extend_from_slice(&f.mtime.to_le_bytes());
+        buf.extend_from_slice(&f.size.to_le_bytes());
+        buf.extend_from_slice(&(f.lines.len() as u32).to_le_bytes());
+        for (n, text) in &f.lines {
+            buf.extend_from_slice(&n.to_le_bytes());
+            put_str(&mut buf, text);
+        }
+    }
+    buf
+}
+
+fn decode(bytes: &[u8]) -> Option<Vec<FileEntry>> {
+    let mut r = Cursor(bytes.strip_prefix(MAGIC)?);
+    let count = r.u32()?;
+    let mut files = Vec::with_capacity(count as usize);
+    for _ in 0..count {
+        let path = r.str()?;
+        let mtime = r.u64()?;
+        let size = r.u64()?;
+        let n = r.u32()?;
+        let mut lines = Vec::with_capacity(n as usize);
+        for _ in 0..n {
+            lines.push((r.u32()?, r.str()?));
+        }
+        files.push(FileEntry {
+            path,
+            mtime,
+            size,
+            lines,
+        });
+    }
+    Some(files)
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_encode_round_trip() {
+        let files = vec![
+            FileEntry {
+                path: "src/main.rs".into(),
+                mtime: 1_700_000_000_123_456_789,
+                size: 4096,
+                lines: vec![(1, "fn main() {".into()), (40, "struct Cli {".into())],
+            },
+            FileEntry {
+                path: "README.md".into(),
+                mtime: 0,
+                size: 0,
+                lines: Vec::new(),
+            },
+        ];
+        assert_eq!(decode(&encode(&files)), Some(files.clone()));
+        let truncated = encode(&files);
+        assert_eq!(decode(&truncated[..truncated.len() - 3]), None);
+        assert_eq!(decode(b"nope"), None);
+    }
+
+    #[test]
+    fn test_walk_and_outline() {
+        let root = std::env::temp_dir().join(format!("vita-index-test-{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(root.join("src")).unwrap();
+        fs::create_dir_all(root.join(".git")).unwrap();
+        fs::create_dir_all(root.join("target")).unwrap();
+        fs::write(root.join("src/a.toml"), "[package]\nname = \"x\"\n").unwrap();
+        fs::write(root.join("README.md"), "# Title\ntext\n## Usage\n").unwrap();
+        fs::write(root.join(".git/config.toml"), "[core]\n").unwrap();
+        fs::write(root.join("target/out.toml"), "[x]\n").unwrap();
+        fs::write(root.join("photo.png"), [0u8; 4]).unwrap();
+
+        let mut paths: Vec<String> = walk(&root).into_iter().map(|f| f.path).collect();
+        paths.sort();
+        assert_eq!(paths, vec!["README.md", "src/a.toml"]);
+
+        let found: Vec<FileEntry> = outline_all(walk(&root));
+        let readme = found.iter().find(|f| f.path == "README.md").unwrap();
+        assert_eq!(readme.lines, vec![(1, "# Title".to_string()), (3, "## Usage".to_string())]);
+
+        fs::remove_dir_all(&root).unwrap();
+    }
+
+    #[test]
+    fn test_open_reoutlines_only_changed_files() {
+        let root = std::env::temp_dir().join(format!("vita-index-open-{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(&root).unwrap();
+        cache::set_test_root(Some(root.join(".cache")));
+        fs::write(root.join("a.md"), "# A\n").unwrap();
+        fs::write(root.join("b.md"), "# B\n").unwrap();
+        fs::write(root.join("c.toml"), "[c]\n").unwrap();
+
+        let first = Index::open(&root).unwrap();
+        assert_eq!(first.files.len(), 3);
+
+        // Tag every cached entry, so entries taken from the cache are told
+        // apart from freshly outlined ones
+        let name = cache_name(&root.canonicalize().unwrap());
+        let mut cached = decode(&cache::read(CACHE_BUCKET, &name).unwrap()).unwrap();
+        for entry in &mut cached {
+            entry.lines = vec![(0, "cached".to_string())];
+        }
+        cache::write(CACHE_BUCKET, &name, &encode(&cached));
+
+        fs::write(root.join("b.md"), "# B\n## Changed\n").unwrap();
+        let second = Index::open(&root).unwrap();
+        let lines: Vec<(&str, &[(u32, String)])> =
+            second.files.iter().map(|f| (f.path.as_str(), f.lines.as_slice())).collect();
+        let cached = vec![(0, "cached".to_string())];
+        let fresh = vec![(1, "# B".to_string()), (2, "## Changed".to_string())];
+        assert_eq!(
+            lines,
+            vec![("a.md", &cached[..]), ("b.md", &fresh[..]), ("c.toml", &cached[..])]
+        );
+
+        cache::set_test_root(None);
+        fs::remove_dir_all(&root).unwrap();
+    }
+
+    #[test]
+    fn test_clip_respects_char_boundaries() {
+        let long = "é".repeat(MAX_LINE_TEXT);
+        let clipped = clip(&long);
+        assert!(clipped.len() <= MAX_LINE_TEXT);
+        assert!(clipped.chars().all(|c| c == 'é'));
+    }
+}
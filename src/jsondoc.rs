@@ -0,0 +1,550 @@
+//! On-demand JSON documents backed by a structural index
+//!
+//! Two stages, in the style of simdjson:
+//!   1. `Document::parse` runs the SIMD structural scanner once, validating
+//!      the grammar and recording the offset of every bracket, `:`, `,` and
+//!      string opening quote in a flat `Vec<u32>`. Each bracket also stores
+//!      its partner (openers) or its child count (closers).
+//!   2. `Value` handles walk that index lazily. Nothing is allocated per node;
+//!      strings are decoded only when asked for, and containers report their
+//!      length in O(1).
+//!
+//! Documents larger than 4 GiB are rejected (offsets are `u32`).
+
+use std::borrow::Cow;
+
+use crate::structural::{scan, skip_string, skip_whitespace};
+
+pub struct Document<'a> {
+    src: &'a str,
+    /// Byte offsets of structural characters, in document order
+    pos: Vec<u32>,
+    /// Openers: index of the matching closer. Closers: number of children.
+    aux: Vec<u32>,
+    root: Node,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Kind {
+    Object,
+    Array,
+    String,
+    Number,
+    Bool,
+    Null,
+}
+
+#[derive(Clone, Copy, Debug)]
+enum Node {
+    /// Container or string starting at this index entry
+    Entry(usize),
+    /// Bare scalar spanning these bytes
+    Scalar(usize, usize),
+}
+
+#[derive(Clone, Copy)]
+pub struct Value<'d, 'a> {
+    doc: &'d Document<'a>,
+    node: Node,
+}
+
+// ─── Stage 1: structural index + validation ───
+
+#[derive(Clone, Copy, PartialEq)]
+enum Expect {
+    Value,
+    ValueOrClose,
+    Key,
+    KeyOrClose,
+    Colon,
+    CommaOrClose,
+    Done,
+}
+
+struct Frame {
+    entry: usize,
+    object: bool,
+    children: u32,
+}
+
+impl<'a> Document<'a> {
+    pub fn parse(src: &'a str) -> Result<Document<'a>, String> {
+        if src.len() > u32::MAX as usize {
+            return Err("document too large".into());
+        }
+        let bytes = src.as_bytes();
+        let mut pos: Vec<u32> = Vec::with_capacity(src.len() / 8);
+        let mut aux: Vec<u32> = Vec::with_capacity(src.len() / 8);
+        let mut stack: Vec<Frame> = Vec::new();
+        let mut expect = Expect::Value;
+        let mut in_key = false;
+        let mut in_string = false;
+        let mut gap_start = 0usize;
+        let mut root_scalar: Option<(usize, usize)> = None;
+        let mut error: Option<String> = None;
+
+        let fail = |error: &mut Option<String>, at: usize, what: &str| {
+            *error = Some(format!("{} at byte {}", what, at));
+            false
+        };
+
+        scan(bytes, 0, |at, b| {
+            if in_string {
+                // Closing quote
+                in_string = false;
+                let open = *pos.last().unwrap() as usize;
+                if !is_valid_string(&bytes[open + 1..at]) {
+                    return fail(&mut error, open, "invalid string");
+                }
+                expect = if in_key {
+                    Expect::Colon
+                } else if stack.is_empty() {
+                    Expect::Done
+                } else {
+                    Expect::CommaOrClose
+                };
+                gap_start = at + 1;
+                return true;
+            }
+
+            // Text between the previous token and this one
+            let gap = src[gap_start..at].trim();
+            if !gap.is_empty() {
+                if !matches!(expect, Expect::Value | Expect::ValueOrClose) {
+                    return fail(&mut error, gap_start, "unexpected token");
+                }
+                if !is_scalar(gap) {
+                    return fail(&mut error, gap_start, "invalid literal");
+                }
+                match stack.last_mut() {
+                    Some(f) => f.children += (expect == Expect::ValueOrClose) as u32,
+                    // A root scalar cannot be followed by anything
+                    None => return fail(&mut error, at, "trailing characters"),
+                }
+                expect = Expect::CommaOrClose;
+            }
+            gap_start = at + 1;
+
+            match (expect, b) {
+                (Expect::Value | Expect::ValueOrClose, b'{' | b'[') => {
+                    if let Some(f) = stack.last_mut() {
+                        f.children += (expect == Expect::ValueOrClose) as u32;
+                    }
+                    stack.push(Frame {
+                        entry: pos.len(),
+                        object: b == b'{',
+                        children: 0,
+                    });
+                    pos.push(at as u32);
+                    aux.push(0);
+                    expect = if b == b'{' { Expect::KeyOrClose } else { Expect::ValueOrClose };
+                }
+                (Expect::Value | Expect::ValueOrClose, b'"') => {
+                    if let Some(f) = stack.last_mut() {
+                        f.children += (expect == Expect::ValueOrClose) as u32;
+                    }
+                    pos.push(at as u32);
+                    aux.push(0);
+                    in_string = true;
+                    in_key = false;
+                }
+                (Expect::Key | Expect::KeyOrClose, b'"') => {
+                    if let Some(f) = stack.last_mut() {
+                        f.children += 1;
+                    }
+                    pos.push(at as u32);
+                    aux.push(0);
+                    in_string = true;
+                    in_key = true;
+                }
+                (Expect::Colon, b':') => {
+                    pos.push(at as u32);
+                    aux.push(0);
+                    expect = Expect::Value;
+                }
+                (Expect::CommaOrClose, b',') => {
+                    let object = match stack.last_mut() {
+                        Some(f) => {
+                            f.children += (!f.object) as u32;
+                            f.object
+                        }
+                        None => return fail(&mut error, at, "unexpected ','"),
+                    };
+                    pos.push(at as u32);
+                    aux.push(0);
+                    expect = if object { Expect::Key } else { Expect::Value };
+                }
+                (Expect::CommaOrClose | Expect::KeyOrClose | Expect::ValueOrClose, b'}' | b']') => {
+                    let frame = match stack.pop() {
+                        Some(f) if f.object == (b == b'}') => f,
+                        _ => return fail(&mut error, at, "mismatched bracket"),
+                    };
+                    // `[1,]` and `{"a":1,}` end in Value/Key states and never get here
+                    aux[frame.entry] = pos.len() as u32;
+                    pos.push(at as u32);
+                    aux.push(frame.children);
+                    expect = if stack.is_empty() { Expect::Done } else { Expect::CommaOrClose };
+                }
+                _ => return fail(&mut error, at, "unexpected character"),
+            }
+            true
+        });
+
+        if let Some(e) = error {
+            return Err(e);
+        }
+        if in_string {
+            return Err("unterminated string".into());
+        }
+
+        let tail = src[gap_start.min(src.len())..].trim();
+        if !tail.is_empty() {
+            if expect != Expect::Value || !stack.is_empty() || !is_scalar(tail) {
+                return Err(format!("trailing characters at byte {}", gap_start));
+            }
+            let start = skip_whitespace(bytes, gap_start);
+            root_scalar = Some((start, start + tail.len()));
+            expect = Expect::Done;
+        }
+        if expect != Expect::Done {
+            return Err("unexpected end of input".into());
+        }
+
+        let root = match root_scalar {
+            Some((s, e)) if pos.is_empty() => Node::Scalar(s, e),
+            _ => Node::Entry(0),
+        };
+        Ok(Document { src, pos, aux, root })
+    }
+
+    pub fn root(&self) -> Value<'_, 'a> {
+        Value {
+            doc: self,
+            node: self.root,
+        }
+    }
+
+    fn byte_at(&self, entry: usize) -> u8 {
+        self.src.as_bytes()[self.pos[entry] as usize]
+    }
+
+    /// The value that starts right after index entry `prev` (an opener,
+    /// `:` or `,`), and the index entry following it.
+    fn value_after(&self, prev: usize) -> (Node, usize) {
+        let bytes = self.src.as_bytes();
+        let start = skip_whitespace(bytes, self.pos[prev] as usize + 1);
+        let next = prev + 1;
+        match bytes.get(start) {
+            Some(b'{') | Some(b'[') => (Node::Entry(next), self.aux[next] as usize + 1),
+            Some(b'"') => (Node::Entry(next), next + 1),
+            _ => {
+                let end = self.pos[next] as usize;
+                let text = self.src[start..end].trim_end();
+                (Node::Scalar(start, start + text.len()), next)
+            }
+        }
+    }
+}
+
+/// Reject raw control characters and unknown escapes inside a string body.
+fn is_valid_string(body: &[u8]) -> bool {
+    if !body.iter().any(|&b| b < 0x20 || b == b'\\') {
+        return true;
+    }
+    let mut i = 0;
+    while i < body.len() {
+        match body[i] {
+            b if b < 0x20 => return false,
+            b'\\' => match body.get(i + 1) {
+                Some(b'"' | b'\\' | b'/' | b'b' | b'f' | b'n' | b'r' | b't') => i += 2,
+                Some(b'u') => {
+                    let hex = body.get(i + 2..i + 6);
+                    if !hex.map_or(false, |h| h.iter().all(u8::is_ascii_hexdigit)) {
+                        return false;
+                    }
+                    i += 6;
+                }
+                _ => return false,
+            },
+            _ => i += 1,
+        }
+    }
+    true
+}
+
+fn is_scalar(text: &str) -> bool {
+    matches!(text, "true" | "false" | "null") || is_number(text.as_bytes())
+}
+
+/// JSON number grammar: -?(0|[1-9]\d*)(\.\d+)?([eE][+-]?\d+)?
+fn is_number(b: &[u8]) -> bool {
+    let mut i = 0;
+    let digits = |i: &mut usize| {
+        let start = *i;
+        while *i < b.len() && b[*i].is_ascii_digit() {
+            *i += 1;
+        }
+        *i > start
+    };
+    if b.get(i) == Some(&b'-') {
+        i += 1;
+    }
+    if b.get(i) == Some(&b'0') {
+        i += 1;
+    } else if !digits(&mut i) {
+        return false;
+    }
+    if b.get(i) == Some(&b'.') {
+        i += 1;
+        if !digits(&mut i) {
+            return false;
+        }
+    }
+    if matches!(b.get(i), Some(b'e') | Some(b'E')) {
+        i += 1;
+        if matches!(b.get(i), Some(b'+') | Some(b'-')) {
+            i += 1;
+        }
+        if !digits(&mut i) {
+            return false;
+        }
+    }
+    i == b.len()
+}
+
+// ─── Stage 2: lazy value access ───
+
+impl<'d, 'a> Value<'d, 'a> {
+    pub fn kind(&self) -> Kind {
+        match self.node {
+            Node::Entry(e) => match self.doc.byte_at(e) {
+                b'{' => Kind::Object,
+                b'[' => Kind::Array,
+                _ => Kind::String,
+            },
+            Node::Scalar(s, _) => match self.doc.src.as_bytes()[s] {
+                b't' | b'f' => Kind::Bool,
+                b'n' => Kind::Null,
+                _ => Kind::Number,
+            },
+        }
+    }
+
+    /// Number of keys or items; 0 for scalars.
+    pub fn len(&self) -> usize {
+        match (self.kind(), self.node) {
+            (Kind::Object | Kind::Array, Node::Entry(e)) => {
+                self.doc.aux[self.doc.aux[e] as usize] as usize
+            }
+            _ => 0,
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Source text of the value: scalars as written, strings with quotes,
+    /// containers with their full extent.
+    pub fn raw(&self) -> &'a str {
+        let src = self.doc.src;
+        match self.node {
+            Node::Scalar(s, e) => &src[s..e],
+            Node::Entry(e) => {
+                let start = self.doc.pos[e] as usize;
+                let end = match self.kind() {
+                    Kind::String => skip_string(src.as_bytes(), start),
+                    _ => self.doc.pos[self.doc.aux[e] as usize] as usize + 1,
+                };
+                &src[start..end]
+            }
+        }
+    }
+
+    /// Decoded string contents, borrowing from the source when there are no
+    /// escapes. `None` for non-strings.
+    pub fn as_str(&self) -> Option<Cow<'a, str>> {
+        if self.kind() != Kind::String {
+            return None;
+        }
+        Some(decode_string(self.raw()))
+    }
+
+    /// Items of an array (empty for anything else).
+    pub fn items(&self) -> Items<'d, 'a> {
+        let entry = match (self.kind(), self.node) {
+            (Kind::Array, Node::Entry(e)) => Some(e),
+            _ => None,
+        };
+        Items {
+            doc: self.doc,
+            cursor: entry.map_or(0, |e| e),
+            end: entry.map_or(0, |e| self.doc.aux[e] as usize),
+        }
+    }
+
+    /// Members of an object (empty for anything else).
+    pub fn entries(&self) -> Entries<'d, 'a> {
+        let entry = match (self.kind(), self.node) {
+            (Kind::Object, Node::Entry(e)) => Some(e),
+            _ => None,
+        };
+        Entries {
+            doc: self.doc,
+            cursor: entry.map_or(0, |e| e + 1),
+            end: entry.map_or(0, |e| self.doc.aux[e] as usize),
+        }
+    }
+}
+
+pub struct Items<'d, 'a> {
+    doc: &'d Document<'a>,
+    /// Index entry preceding the next item (`[` or `,`)
+    cursor: usize,
+    end: usize,
+}
+
+impl<'d, 'a> Iterator for Items<'d, 'a> {
+    type Item = Value<'d, 'a>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.cursor >= self.end {
+            return None;
+        }
+        // Empty array: `[` directly followed by `]` with nothing between
+        if self.cursor + 1 == self.end && self.doc.byte_at(self.cursor) == b'[' {
+            let bytes = self.doc.src.as_bytes();
+            let after = skip_whitespace(bytes, self.doc.pos[self.cursor] as usize + 1);
+            if after == self.doc.pos[self.end] as usize {
+                self.cursor = self.end;
+                return None;
+            }
+        }
+        let (node, next) = self.doc.value_after(self.cursor);
+        // `next` is the `,` or the closing `]`
+        self.cursor = next;
+        if self.cursor >= self.end {
+            self.cursor = self.end;
+        }
+        Some(Value { doc: self.doc, node })
+    }
+}
+
+pub struct Entries<'d, 'a> {
+    doc: &'d Document<'a>,
+    /// Index entry of the next key's opening quote
+    cursor: usize,
+    end: usize,
+}
+
+impl<'d, 'a> Iterator for Entries<'d, 'a> {
+    type Item = (Cow<'a, str>, Value<'d, 'a>);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.cursor >= self.end {
+            return None;
+        }
+        let src = self.doc.src;
+        let key_start = self.doc.pos[self.cursor] as usize;
+        let key = decode_string(&src[key_start..skip_string(src.as_bytes(), key_start)]);
+        // cursor + 1 is the `:`
+        let (node, next) = self.doc.value_after(self.cursor + 1);
+        // `next` is the `,` (key follows) or the closing `}`
+        self.cursor = next + 1;
+        if next >= self.end {
+            self.cursor = self.end;
+        }
+        Some((key, Value { doc: self.doc, node }))
+    }
+}
+
+/// Decode a quoted JSON string, borrowing when it has no escapes.
+fn decode_string(raw: &str) -> Cow<'_, str> {
+    let inner = if raw.len() >= 2 { &raw[1..raw.len() - 1] } else { "" };
+    if !inner.contains('\\') {
+        return Cow::Borrowed(inner);
+    }
+    serde_json::from_str::<String>(raw)
+        .map(Cow::Owned)
+        .unwrap_or(Cow::Borrowed(inner))
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_validation_agrees_with_serde() {
+        let cases = [
+            r#"{"a": [1, 2.5, -3e4, true, null], "b": {"c": "d\"e"}}"#,
+            "[]",
+            "{}",
+            " [ {} , [ ] ] ",
+            "42",
+            r#""str""#,
+            "[1,]",
+            r#"{"a" 1}"#,
+            r#"{"a": 1,}"#,
+            "[1 2]",
+            "[01]",
+            "[1.]",
+            "{]",
+            "[tru]",
+            r#"{"a": "unterminated}"#,
+            "[1]]",
+            "[1] x",
+            "",
+            r#"{"k": nul}"#,
+        ];
+        for case in cases {
+            let ours = Document::parse(case).is_ok();
+            let serde = serde_json::from_str::<serde_json::Value>(case).is_ok();
+            assert_eq!(ours, serde, "disagreement on {:?}", case);
+        }
+    }
+
+    #[test]
+    fn test_lazy_access() {
+        let json = r#"{"name": "vita", "tags": ["a", "b\n", 3], "nested": {"x": {}}, "n": -1.5e2, "ok": false, "none": null}"#;
+        let doc = Document::parse(json).unwrap();
+        let root = doc.root();
+        assert_eq!(root.kind(), Kind::Object);
+        assert_eq!(root.len(), 6);
+
+        let entries: Vec<_> = root.entries().collect();
+        let keys: Vec<&str> = entries.iter().map(|(k, _)| k.as_ref()).collect();
+        assert_eq!(keys, vec!["name", "tags", "nested", "n", "ok", "none"]);
+        assert_eq!(entries[0].1.as_str().unwrap(), "vita");
+
+        let tags = entries[1].1;
+        assert_eq!(tags.len(), 3);
+        let items: Vec<_> = tags.items().collect();
+        assert_eq!(items.len(), 3);
+        assert_eq!(items[1].as_str().unwrap(), "b\n");
+        assert_eq!(items[2].kind(), Kind::Number);
+        assert_eq!(items[2].raw(), "3");
+
+        assert_eq!(entries[2].1.raw(), r#"{"x": {}}"#);
+        assert_eq!(entries[2].1.len(), 1);
+        assert_eq!(entries[3].1.raw(), "-1.5e2");
+        assert_eq!(entries[4].1.kind(), Kind::Bool);
+        assert_eq!(entries[5].1.kind(), Kind::Null);
+    }
+
+    #[test]
+    fn test_empty_containers_and_scalar_root() {
+        let doc = Document::parse("[ ]").unwrap();
+        assert_eq!(doc.root().items().count(), 0);
+        assert!(doc.root().is_empty());
+
+        let doc = Document::parse("[[], {}, [1]]").unwrap();
+        let lens: Vec<usize> = doc.root().items().map(|v| v.len()).collect();
+        assert_eq!(lens, vec![0, 0, 1]);
+
+        let doc = Document::parse(" 12 ").unwrap();
+        assert_eq!(doc.root().kind(), Kind::Number);
+        assert_eq!(doc.root().raw(), "12");
+    }
+}
@@ -0,0 +1,62 @@
+//! Fast line iteration
+//!
+//! `memchr`-driven equivalents of `str::lines()` and `lines().count()` for
+//! code paths that walk whole files line by line (brief outlines), without
+//! collecting the lines into a vector first.
+
+use memchr::{memchr, memchr_iter};
+
+/// Lines of `text` with their `\n` / `\r\n` terminators removed, exactly
+/// like `str::lines`.
+pub fn lines(text: &str) -> Lines<'_> {
+    Lines { text, pos: 0 }
+}
+
+/// Same as `text.lines().count()`, counting newlines with SIMD.
+pub fn count(text: &str) -> usize {
+    let newlines = memchr_iter(b'\n', text.as_bytes()).count();
+    newlines + usize::from(!text.is_empty() && !text.ends_with('\n'))
+}
+
+pub struct Lines<'a> {
+    text: &'a str,
+    pos: usize,
+}
+
+impl<'a> Iterator for Lines<'a> {
+    type Item = &'a str;
+
+    #[inline]
+    fn next(&mut self) -> Option<&'a str> {
+        if self.pos >= self.text.len() {
+            return None;
+        }
+        let rest = &self.text[self.pos..];
+        match memchr(b'\n', rest.as_bytes()) {
+            Some(i) => {
+                self.pos += i + 1;
+                let line = &rest[..i];
+                Some(line.strip_suffix('\r').unwrap_or(line))
+            }
+            None => {
+                self.pos = self.text.len();
+                Some(rest)
+            }
+        }
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_matches_std_lines() {
+        for text in ["", "a", "a\n", "a\nb", "a\r\nb\r\n", "\n\n", "x\r", "a\n\nb\n\r"] {
+            assert_eq!(lines(text).collect::<Vec<_>>(), text.lines().collect::<Vec<_>>(), "{:?}", text);
+            assert_eq!(count(text), text.lines().count(), "{:?}", text);
+        }
+    }
+}
@@ -1,12 +1,24 @@
 use clap::Parser;
-use std::io::{self, IsTerminal, Read};
-use std::path::PathBuf;
+use std::io::{self, BufRead, IsTerminal, Read};
+use std::path::{Path, PathBuf};
 use std::process;
 
+mod cache;
 mod detect;
+mod diff;
+mod fuzzy;
+mod git;
+mod index;
 mod info;
+mod jsondoc;
+mod lines;
 mod output;
+mod query;
 mod render;
+mod schema;
+mod span;
+mod structural;
+mod symbols;
 mod theme;
 
 use detect::{detect_format, FileFormat};
@@ -34,10 +46,42 @@ struct Cli {
     #[arg(short = 'B', long = "blame")]
     blame: bool,
 
+    /// Mark lines changed since the last commit next to the line numbers
+    #[arg(long = "diff-gutter")]
+    diff_gutter: bool,
+
+    /// Diff two files (either may be REV:path), emphasizing changed words
+    #[arg(long = "diff", num_args = 2, value_names = ["OLD", "NEW"])]
+    diff: Option<Vec<PathBuf>>,
+
     /// Grep: show only lines matching PAT with highlight
     #[arg(short = 'g', long = "grep", value_name = "PAT")]
     grep: Option<String>,
 
+    /// With --grep: only matches in code, comments or strings
+    #[arg(long = "grep-in", value_name = "WHERE", value_parser = render::grep::Region::parse)]
+    grep_in: Option<render::grep::Region>,
+
+    /// With --brief --grep: rank outline lines by fuzzy match (best 50, or --head N)
+    #[arg(long = "fuzzy")]
+    fuzzy: bool,
+
+    /// Fold JSON/YAML/TOML subtrees deeper than N levels
+    #[arg(long = "depth", value_name = "N")]
+    depth: Option<usize>,
+
+    /// Query: show only the JSON subtrees at PATH (e.g. .items[3].spec)
+    #[arg(short = 'q', long = "query", value_name = "PATH", value_parser = query::Query::parse)]
+    query: Option<query::Query>,
+
+    /// Symbol: show only the definition of NAME (files and directories)
+    #[arg(long = "symbol", value_name = "NAME")]
+    symbol: Option<String>,
+
+    /// Table: show a JSON array of records or NDJSON as a table
+    #[arg(long = "table")]
+    table: bool,
+
     /// Hex dump: show raw bytes
     #[arg(short = 'x', long = "hex")]
     hex: bool,
@@ -70,6 +114,10 @@ struct Cli {
     #[arg(short = 'w', long = "width", default_value_t = 60)]
     width: u32,
 
+    /// Images: reuse a color for cells within N per channel (smaller output)
+    #[arg(long = "color-tolerance", value_name = "N", default_value_t = 0)]
+    color_tolerance: u8,
+
     /// Show only the first N lines
     #[arg(long = "head", value_name = "N")]
     head: Option<usize>,
@@ -105,23 +153,52 @@ fn main() {
         process::exit(1);
     }
 
-    if cli.show_all && cli.brief {
-        eprintln!("vita: --show-all and --brief cannot be used together");
+    // Output modes; each takes over the whole output, so any two conflict,
+    // except --brief with --grep (a brief outline search)
+    let modes = [
+        ("--brief", cli.brief),
+        ("--show-all", cli.show_all),
+        ("--grep", cli.grep.is_some()),
+        ("--blame", cli.blame),
+        ("--hex", cli.hex),
+        ("--query", cli.query.is_some()),
+        ("--table", cli.table),
+        ("--symbol", cli.symbol.is_some()),
+        ("--diff-gutter", cli.diff_gutter),
+        ("--diff", cli.diff.is_some()),
+    ];
+    let active: Vec<&str> = modes.iter().filter(|(_, set)| *set).map(|(name, _)| *name).collect();
+    for (i, first) in active.iter().enumerate() {
+        for second in &active[i + 1..] {
+            if (*first, *second) == ("--brief", "--grep") {
+                continue;
+            }
+            match legacy_conflict(first, second) {
+                Some(message) => eprintln!("vita: {}", message),
+                None => eprintln!("vita: {} cannot be combined with {}", second, first),
+            }
+            process::exit(1);
+        }
+    }
+
+    // Line limits would cut the JSON text before the query parses it
+    if cli.query.is_some() && (cli.head.is_some() || cli.tail.is_some()) {
+        eprintln!("vita: --query cannot be combined with --head or --tail");
         process::exit(1);
     }
 
-    if cli.show_all && cli.grep.is_some() {
-        eprintln!("vita: --show-all and --grep cannot be used together");
+    if cli.diff.is_some() && !cli.files.is_empty() {
+        eprintln!("vita: --diff takes exactly two files");
         process::exit(1);
     }
 
-    if cli.blame && (cli.brief || cli.show_all || cli.grep.is_some()) {
-        eprintln!("vita: --blame cannot be combined with --brief, --show-all, or --grep");
+    if cli.grep_in.is_some() && (cli.grep.is_none() || cli.brief) {
+        eprintln!("vita: --grep-in requires --grep and cannot be combined with --brief");
         process::exit(1);
     }
 
-    if cli.hex && (cli.brief || cli.show_all || cli.grep.is_some() || cli.blame) {
-        eprintln!("vita: --hex cannot be combined with --brief, --show-all, --grep, or --blame");
+    if cli.fuzzy && !(cli.brief && cli.grep.is_some()) {
+        eprintln!("vita: --fuzzy requires --brief and --grep");
         process::exit(1);
     }
 
@@ -148,8 +225,23 @@ fn main() {
         return run_blame(&cli, &theme, &out);
     }
 
+    if cli.diff_gutter {
+        return run_diff_gutter(&cli, &theme, &out);
+    }
+
+    if let Some(ref paths) = cli.diff {
+        return run_diff(&paths[0], &paths[1], &cli, &theme, &out);
+    }
+
+    if let Some(ref name) = cli.symbol {
+        return run_symbol(&cli, name, &theme, &out);
+    }
+
     if cli.brief {
         if let Some(ref pattern) = cli.grep {
+            if cli.fuzzy {
+                return run_brief_fuzzy(&cli, pattern, &theme, &out);
+            }
             return run_brief_grep(&cli, pattern, &theme, &out);
         }
         return run_brief(&cli, &theme, &out);
@@ -165,8 +257,26 @@ fn main() {
             process::exit(1);
         }
 
+        // A diff is told by its first line, so it can stream as it arrives
+        let mut stdin = io::stdin().lock();
+        if streams(&cli) {
+            let head = stdin.fill_buf().unwrap_or_default();
+            let format = match cli.lang.as_deref() {
+                Some(l) => detect::format_from_lang(l),
+                None => detect::detect_from_content(&String::from_utf8_lossy(head)),
+            };
+            if matches!(&format, FileFormat::Code(lang) if lang == "Diff") {
+                check_format_flags(&cli, &format);
+                if render::diff::render_reader(stdin, &theme, &out).is_err() {
+                    eprintln!("vita: failed to read stdin");
+                    process::exit(1);
+                }
+                return;
+            }
+        }
+
         let mut buf = String::new();
-        if io::stdin().read_to_string(&mut buf).is_err() {
+        if stdin.read_to_string(&mut buf).is_err() {
             eprintln!("vita: failed to read stdin");
             process::exit(1);
         }
@@ -178,6 +288,7 @@ fn main() {
             .as_deref()
             .map(|l| detect::format_from_lang(l))
             .unwrap_or_else(|| detect::detect_from_content(&buf));
+        check_format_flags(&cli, &format);
 
         if cli.info {
             info::print_header(None, Some(&format), Some(&buf), &theme, &out);
@@ -187,6 +298,8 @@ fn main() {
     }
 
     let multi = cli.files.len() > 1;
+    // Opened on the first `REV:path` argument and kept for the rest
+    let mut repo = None;
 
     for path in &cli.files {
         if path.to_str() == Some("-") {
@@ -194,6 +307,7 @@ fn main() {
             if io::stdin().read_to_string(&mut buf).is_ok() {
                 let buf = truncate_lines(&buf, cli.head, cli.tail);
                 let format = detect::detect_from_content(&buf);
+                check_format_flags(&cli, &format);
                 if cli.info {
                     info::print_header(None, Some(&format), Some(&buf), &theme, &out);
                 }
@@ -203,7 +317,10 @@ fn main() {
         }
 
         if !path.exists() {
-            eprintln!("vita: '{}': No such file or directory", path.display());
+            match path.to_str().and_then(|p| p.split_once(':')).filter(|(rev, _)| !rev.is_empty()) {
+                Some((rev, file)) => render_revision(path, rev, file, &mut repo, multi, &cli, &theme, &out),
+                None => eprintln!("vita: '{}': No such file or directory", path.display()),
+            }
             continue;
         }
 
@@ -216,13 +333,30 @@ fn main() {
             .as_deref()
             .map(|l| detect::format_from_lang(l))
             .unwrap_or_else(|| detect_format(path));
+        check_format_flags(&cli, &format);
 
         match &format {
             FileFormat::Image => {
                 if cli.info {
                     info::print_header(Some(path), Some(&format), None, &theme, &out);
                 }
-                render::image::render(path, cli.width, &theme, &out);
+                render::image::render(path, cli.width, cli.color_tolerance, &theme, &out);
+            }
+            FileFormat::Code(lang) if streams_from_disk(&cli, lang).is_some() => {
+                let html = streams_from_disk(&cli, lang) == Some(true);
+                let result = std::fs::File::open(path).and_then(|f| {
+                    render::xml::render_reader(io::BufReader::new(f), html, &theme, &out)
+                });
+                if let Err(e) = result {
+                    eprintln!("vita: '{}': {}", path.display(), e);
+                }
+            }
+            FileFormat::Code(lang) if lang == "Diff" && streams(&cli) => {
+                let result = std::fs::File::open(path)
+                    .and_then(|f| render::diff::render_reader(io::BufReader::new(f), &theme, &out));
+                if let Err(e) = result {
+                    eprintln!("vita: '{}': {}", path.display(), e);
+                }
             }
             _ => match std::fs::read_to_string(path) {
                 Ok(content) => {
@@ -240,6 +374,64 @@ fn main() {
     }
 }
 
+/// Show `file` as of `rev` (a `REV:path` argument), read from the object
+/// database of the repository around the current directory.
+fn render_revision(
+    arg: &Path,
+    rev: &str,
+    file: &str,
+    repo: &mut Option<io::Result<git::Repo>>,
+    multi: bool,
+    cli: &Cli,
+    theme: &Theme,
+    out: &Output,
+) {
+    let data = match revision_data(rev, file, repo) {
+        Ok(data) => data,
+        Err(e) => {
+            eprintln!("vita: '{}': {}", arg.display(), e);
+            return;
+        }
+    };
+
+    if multi {
+        out.file_separator(&arg.display().to_string(), theme);
+    }
+
+    let format = cli
+        .lang
+        .as_deref()
+        .map(|l| detect::format_from_lang(l))
+        .unwrap_or_else(|| detect_format(Path::new(file)));
+    check_format_flags(cli, &format);
+
+    if matches!(format, FileFormat::Image) {
+        if cli.info {
+            info::print_header(Some(arg), Some(&format), None, theme, out);
+        }
+        render::image::render_bytes(&data, cli.width, cli.color_tolerance, theme, out);
+        return;
+    }
+
+    let Ok(content) = String::from_utf8(data) else {
+        eprintln!("vita: '{}': stream did not contain valid UTF-8", arg.display());
+        return;
+    };
+    let content = truncate_lines(&content, cli.head, cli.tail);
+    if cli.info {
+        info::print_header(Some(arg), Some(&format), Some(&content), theme, out);
+    }
+    render_content(&content, &format, cli, theme, out);
+}
+
+/// The contents of `file` as of `rev`, opening the repository on first use.
+fn revision_data(rev: &str, file: &str, repo: &mut Option<io::Result<git::Repo>>) -> io::Result<Vec<u8>> {
+    match repo.get_or_insert_with(|| git::Repo::discover(Path::new("."))) {
+        Ok(repo) => repo.show(rev, file),
+        Err(e) => Err(io::Error::new(e.kind(), e.to_string())),
+    }
+}
+
 fn run_show_all(cli: &Cli, theme: &Theme, out: &Output) {
     if cli.files.is_empty() {
         if io::stdin().is_terminal() {
@@ -338,23 +530,99 @@ fn run_blame(cli: &Cli, theme: &Theme, out: &Output) {
             .map(|l| detect::format_from_lang(l))
             .unwrap_or_else(|| detect_format(path));
 
-        let lang = match &format {
-            FileFormat::Code(l) => l.as_str(),
-            FileFormat::Markdown => "Markdown",
-            FileFormat::Json => "JSON",
-            FileFormat::Toml => "TOML",
-            FileFormat::Yaml => "YAML",
-            _ => "Plain Text",
-        };
-
         if cli.info {
             info::print_header(Some(path), Some(&format), None, theme, out);
         }
 
+        let lang = render::code::syntax_name(&format).unwrap_or("Plain Text");
         render::blame::render(path, lang, cli.head, cli.tail, theme, out);
     }
 }
 
+fn run_diff_gutter(cli: &Cli, theme: &Theme, out: &Output) {
+    if cli.files.is_empty() {
+        eprintln!("vita: --diff-gutter requires a file argument");
+        process::exit(1);
+    }
+
+    let multi = cli.files.len() > 1;
+
+    for path in &cli.files {
+        if path.to_str() == Some("-") {
+            eprintln!("vita: --diff-gutter cannot read from stdin");
+            continue;
+        }
+
+        let content = match std::fs::read_to_string(path) {
+            Ok(content) => content,
+            Err(e) => {
+                eprintln!("vita: '{}': {}", path.display(), e);
+                continue;
+            }
+        };
+
+        if multi {
+            out.file_separator(&path.display().to_string(), theme);
+        }
+
+        let format = cli
+            .lang
+            .as_deref()
+            .map(|l| detect::format_from_lang(l))
+            .unwrap_or_else(|| detect_format(path));
+
+        if cli.info {
+            info::print_header(Some(path), Some(&format), Some(&content), theme, out);
+        }
+
+        let line_count = content.lines().count();
+        let span = if let Some(n) = cli.head {
+            0..n
+        } else if let Some(n) = cli.tail {
+            line_count.saturating_sub(n)..line_count
+        } else {
+            0..line_count
+        };
+        let changes = || git::changes::against_head(path, content.as_bytes());
+        let lang = render::code::syntax_name(&format).unwrap_or("Plain Text");
+        render::code::render_changes(&content, lang, span, theme, out, changes);
+    }
+}
+
+fn run_diff(old: &Path, new: &Path, cli: &Cli, theme: &Theme, out: &Output) {
+    let mut repo = None;
+    let mut read = |arg: &Path| {
+        let data = match arg.to_str().and_then(|p| p.split_once(':')).filter(|(rev, _)| !rev.is_empty()) {
+            Some((rev, file)) if !arg.exists() => revision_data(rev, file, &mut repo),
+            _ => std::fs::read(arg),
+        };
+        let text = data.and_then(|d| String::from_utf8(d).map_err(|e| io::Error::new(io::ErrorKind::InvalidData, e)));
+        match text {
+            Ok(text) => text,
+            Err(e) => {
+                eprintln!("vita: '{}': {}", arg.display(), e);
+                process::exit(1);
+            }
+        }
+    };
+    let (old_text, new_text) = (read(old), read(new));
+
+    // Named by the file part of a `REV:path` argument
+    let file = |arg: &Path| match arg.to_str().and_then(|p| p.split_once(':')) {
+        Some((_, file)) if !arg.exists() => PathBuf::from(file),
+        _ => arg.to_path_buf(),
+    };
+    let format = cli
+        .lang
+        .as_deref()
+        .map(|l| detect::format_from_lang(l))
+        .unwrap_or_else(|| detect_format(&file(new)));
+
+    let (old_name, new_name) = (old.display().to_string(), new.display().to_string());
+    let lang = render::code::syntax_name(&format).unwrap_or("Plain Text");
+    render::diff::render_files(&old_name, &old_text, &new_name, &new_text, lang, theme, out);
+}
+
 fn run_hex(cli: &Cli, theme: &Theme, out: &Output) {
     if cli.files.is_empty() {
         if io::stdin().is_terminal() {
@@ -433,7 +701,7 @@ fn run_brief_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
         if cli.info {
             info::print_header(None, Some(&format), Some(&buf), theme, out);
         }
-        render_brief_grep(&buf, &format, pattern, theme, out);
+        render_brief_grep(&buf, &format, None, pattern, theme, out);
         return;
     }
 
@@ -448,7 +716,7 @@ fn run_brief_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
                 if cli.info {
                     info::print_header(None, Some(&format), Some(&buf), theme, out);
                 }
-                render_brief_grep(&buf, &format, pattern, theme, out);
+                render_brief_grep(&buf, &format, None, pattern, theme, out);
             }
             continue;
         }
@@ -458,6 +726,11 @@ fn run_brief_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
             continue;
         }
 
+        if path.is_dir() {
+            run_brief_dir(path, Some(pattern), theme, out);
+            continue;
+        }
+
         if multi {
             out.file_separator(&path.display().to_string(), theme);
         }
@@ -478,19 +751,26 @@ fn run_brief_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
                 if cli.info {
                     info::print_header(Some(path), Some(&format), Some(&content), theme, out);
                 }
-                render_brief_grep(&content, &format, pattern, theme, out);
+                render_brief_grep(&content, &format, Some(path), pattern, theme, out);
             }
             Err(e) => eprintln!("vita: '{}': {}", path.display(), e),
         }
     }
 }
 
-fn render_brief_grep(content: &str, format: &FileFormat, pattern: &str, theme: &Theme, out: &Output) {
-    let structural = render::brief::structural_lines(content, format);
+fn render_brief_grep(
+    content: &str,
+    format: &FileFormat,
+    path: Option<&Path>,
+    pattern: &str,
+    theme: &Theme,
+    out: &Output,
+) {
+    let structural = render::brief::structural_lines(content, format, path);
 
     if structural.is_empty() {
         // JSON/CSV/Plain: fall back to brief only
-        render::brief::render(content, format, theme, out);
+        render::brief::render(content, format, path, theme, out);
         return;
     }
 
@@ -498,13 +778,177 @@ fn render_brief_grep(content: &str, format: &FileFormat, pattern: &str, theme: &
     let num_width = format!("{}", total_lines).len();
 
     for (line_num, text) in &structural {
-        if !text.contains(pattern) {
+        if text.contains(pattern) {
+            print_structural_line(*line_num, num_width, text, Some(pattern), theme, out);
+        }
+    }
+}
+
+/// Default number of results for `--fuzzy`
+const FUZZY_LIMIT: usize = 50;
+
+/// Rank the structural lines of every input (files, directories through
+/// the project index, or stdin) by fuzzy match and print the best ones.
+fn run_brief_fuzzy(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
+    // (label, content, format) of single files; (dir, index) of directories
+    let mut docs: Vec<(String, String, FileFormat)> = Vec::new();
+    let mut indexes: Vec<(PathBuf, index::Index)> = Vec::new();
+
+    let read_stdin = |docs: &mut Vec<(String, String, FileFormat)>| {
+        let mut buf = String::new();
+        if io::stdin().read_to_string(&mut buf).is_err() {
+            eprintln!("vita: failed to read stdin");
+            process::exit(1);
+        }
+        let format = cli
+            .lang
+            .as_deref()
+            .map(|l| detect::format_from_lang(l))
+            .unwrap_or_else(|| detect::detect_from_content(&buf));
+        docs.push((String::new(), buf, format));
+    };
+
+    if cli.files.is_empty() {
+        if io::stdin().is_terminal() {
+            eprintln!("vita: no input. Use 'vita --help' for usage.");
+            process::exit(1);
+        }
+        read_stdin(&mut docs);
+    }
+
+    for path in &cli.files {
+        if path.to_str() == Some("-") {
+            read_stdin(&mut docs);
+            continue;
+        }
+        if !path.exists() {
+            eprintln!("vita: '{}': No such file or directory", path.display());
+            continue;
+        }
+        if path.is_dir() {
+            match index::Index::open(path) {
+                Ok(index) => indexes.push((path.clone(), index)),
+                Err(e) => eprintln!("vita: '{}': {}", path.display(), e),
+            }
             continue;
         }
+        let format = cli
+            .lang
+            .as_deref()
+            .map(|l| detect::format_from_lang(l))
+            .unwrap_or_else(|| detect_format(path));
+        if matches!(format, FileFormat::Image) {
+            continue;
+        }
+        match std::fs::read_to_string(path) {
+            Ok(content) => docs.push((path.display().to_string(), content, format)),
+            Err(e) => eprintln!("vita: '{}': {}", path.display(), e),
+        }
+    }
+
+    let dir_labels: Vec<Vec<String>> = indexes
+        .iter()
+        .map(|(dir, index)| index.files.iter().map(|f| dir.join(&f.path).display().to_string()).collect())
+        .collect();
+    let doc_lines: Vec<Vec<(usize, &str)>> = docs
+        .iter()
+        .map(|(label, content, format)| {
+            // Stdin has no label and no path
+            let path = (!label.is_empty()).then(|| Path::new(label.as_str()));
+            render::brief::structural_lines(content, format, path)
+        })
+        .collect();
+
+    // (label, line number) and text of every candidate line
+    let mut origins: Vec<(&str, usize)> = Vec::new();
+    let mut texts: Vec<&str> = Vec::new();
+    for ((_, index), labels) in indexes.iter().zip(&dir_labels) {
+        for (file, label) in index.files.iter().zip(labels) {
+            for (line_num, text) in &file.lines {
+                origins.push((label, *line_num as usize));
+                texts.push(text);
+            }
+        }
+    }
+    for ((label, _, _), lines) in docs.iter().zip(&doc_lines) {
+        for &(line_num, text) in lines {
+            origins.push((label, line_num));
+            texts.push(text);
+        }
+    }
 
-        out.dim(&format!(" {:>width$} │ ", line_num, width = num_width), theme.line_number);
+    let pattern = fuzzy::Pattern::new(pattern);
+    let ranked = fuzzy::top_k(&pattern, &texts, cli.head.unwrap_or(FUZZY_LIMIT));
+
+    let locations: Vec<String> = ranked
+        .iter()
+        .map(|(i, _)| match origins[*i] {
+            ("", line_num) => line_num.to_string(),
+            (label, line_num) => format!("{}:{}", label, line_num),
+        })
+        .collect();
+    let width = locations.iter().map(|l| l.chars().count()).max().unwrap_or(0);
+
+    for ((i, m), location) in ranked.iter().zip(&locations) {
+        out.dim(&format!(" {:<width$} │ ", location, width = width), theme.line_number);
+        let text = texts[*i];
+        let mut last = 0;
+        for &pos in &m.positions {
+            let end = pos + text[pos..].chars().next().map_or(0, |c| c.len_utf8());
+            if pos > last {
+                out.colored(&text[last..pos], theme.text);
+            }
+            out.colored_bg(&text[pos..end], theme.grep_match_fg, theme.grep_match_bg);
+            last = end;
+        }
+        if last < text.len() {
+            out.colored(&text[last..], theme.text);
+        }
+        println!();
+    }
+}
+
+/// Outline every file under `dir` from the project index, or with a
+/// pattern, only the structural lines containing it.
+fn run_brief_dir(dir: &std::path::Path, pattern: Option<&str>, theme: &Theme, out: &Output) {
+    let index = match index::Index::open(dir) {
+        Ok(index) => index,
+        Err(e) => {
+            eprintln!("vita: '{}': {}", dir.display(), e);
+            return;
+        }
+    };
+
+    for file in &index.files {
+        let shown: Vec<&(u32, String)> = file
+            .lines
+            .iter()
+            .filter(|(_, text)| pattern.map_or(true, |p| text.contains(p)))
+            .collect();
+        let Some(last) = shown.last() else { continue };
+
+        // Joined with the argument, as fuzzy and --symbol results are
+        out.file_separator(&dir.join(&file.path).display().to_string(), theme);
+        let num_width = last.0.to_string().len();
+        for (line_num, text) in shown {
+            print_structural_line(*line_num as usize, num_width, text, pattern, theme, out);
+        }
+    }
+}
 
-        let mut rest = *text;
+/// ` 12 │ text` with every occurrence of `pattern` highlighted.
+fn print_structural_line(
+    line_num: usize,
+    num_width: usize,
+    text: &str,
+    pattern: Option<&str>,
+    theme: &Theme,
+    out: &Output,
+) {
+    out.dim(&format!(" {:>width$} │ ", line_num, width = num_width), theme.line_number);
+
+    let mut rest = text;
+    if let Some(pattern) = pattern.filter(|p| !p.is_empty()) {
         while let Some(pos) = rest.find(pattern) {
             if pos > 0 {
                 out.colored(&rest[..pos], theme.text);
@@ -512,11 +956,11 @@ fn render_brief_grep(content: &str, format: &FileFormat, pattern: &str, theme: &
             out.colored_bg(pattern, theme.grep_match_fg, theme.grep_match_bg);
             rest = &rest[pos + pattern.len()..];
         }
-        if !rest.is_empty() {
-            out.colored(rest, theme.text);
-        }
-        println!();
     }
+    if !rest.is_empty() {
+        out.colored(rest, theme.text);
+    }
+    println!();
 }
 
 fn run_brief(cli: &Cli, theme: &Theme, out: &Output) {
@@ -542,7 +986,7 @@ fn run_brief(cli: &Cli, theme: &Theme, out: &Output) {
         if cli.info {
             info::print_header(None, Some(&format), Some(&buf), theme, out);
         }
-        render::brief::render(&buf, &format, theme, out);
+        render::brief::render(&buf, &format, None, theme, out);
         return;
     }
 
@@ -557,7 +1001,7 @@ fn run_brief(cli: &Cli, theme: &Theme, out: &Output) {
                 if cli.info {
                     info::print_header(None, Some(&format), Some(&buf), theme, out);
                 }
-                render::brief::render(&buf, &format, theme, out);
+                render::brief::render(&buf, &format, None, theme, out);
             }
             continue;
         }
@@ -567,6 +1011,11 @@ fn run_brief(cli: &Cli, theme: &Theme, out: &Output) {
             continue;
         }
 
+        if path.is_dir() {
+            run_brief_dir(path, None, theme, out);
+            continue;
+        }
+
         if multi {
             out.file_separator(&path.display().to_string(), theme);
         }
@@ -587,13 +1036,119 @@ fn run_brief(cli: &Cli, theme: &Theme, out: &Output) {
                 if cli.info {
                     info::print_header(Some(path), Some(&format), Some(&content), theme, out);
                 }
-                render::brief::render(&content, &format, theme, out);
+                render::brief::render(&content, &format, Some(path), theme, out);
             }
             Err(e) => eprintln!("vita: '{}': {}", path.display(), e),
         }
     }
 }
 
+/// Show the definitions of `name` in the given files, and in the files
+/// under given directories whose index outline mentions it. Candidate
+/// files are read and searched in parallel.
+fn run_symbol(cli: &Cli, name: &str, theme: &Theme, out: &Output) {
+    // (label, content if already read)
+    let mut inputs: Vec<(PathBuf, Option<String>)> = Vec::new();
+
+    let read_stdin = || {
+        let mut buf = String::new();
+        if io::stdin().read_to_string(&mut buf).is_err() {
+            eprintln!("vita: failed to read stdin");
+            process::exit(1);
+        }
+        (PathBuf::from("-"), Some(buf))
+    };
+
+    if cli.files.is_empty() {
+        if io::stdin().is_terminal() {
+            eprintln!("vita: no input. Use 'vita --help' for usage.");
+            process::exit(1);
+        }
+        inputs.push(read_stdin());
+    }
+
+    for path in &cli.files {
+        if path.to_str() == Some("-") {
+            inputs.push(read_stdin());
+        } else if !path.exists() {
+            eprintln!("vita: '{}': No such file or directory", path.display());
+        } else if path.is_dir() {
+            match index::Index::open(path) {
+                Ok(index) => inputs.extend(
+                    index
+                        .files
+                        .iter()
+                        .filter(|f| f.lines.iter().any(|(_, text)| span::contains_word(text, name)))
+                        .map(|f| (path.join(&f.path), None)),
+                ),
+                Err(e) => eprintln!("vita: '{}': {}", path.display(), e),
+            }
+        } else {
+            inputs.push((path.clone(), None));
+        }
+    }
+
+    let locate = |(path, content): &(PathBuf, Option<String>)| {
+        let format = match (cli.lang.as_deref(), content) {
+            (Some(lang), _) => detect::format_from_lang(lang),
+            (None, Some(content)) => detect::detect_from_content(content),
+            (None, None) => detect_format(path),
+        };
+        if matches!(format, FileFormat::Image) {
+            return None;
+        }
+        // Only files on disk are cached
+        let source = content.is_none().then_some(path.as_path());
+        let content = match content {
+            Some(content) => content.clone(),
+            None => match std::fs::read_to_string(path) {
+                Ok(content) => content,
+                Err(e) => {
+                    eprintln!("vita: '{}': {}", path.display(), e);
+                    return None;
+                }
+            },
+        };
+        let spans = span::find(&content, &format, source, name);
+        (!spans.is_empty()).then(|| (path.clone(), content, format, spans))
+    };
+
+    let workers = std::thread::available_parallelism().map_or(1, |n| n.get());
+    let chunk = ((inputs.len() + workers - 1) / workers).max(1);
+    let found: Vec<_> = std::thread::scope(|scope| {
+        let handles: Vec<_> = inputs
+            .chunks(chunk)
+            .map(|part| scope.spawn(move || part.iter().filter_map(locate).collect::<Vec<_>>()))
+            .collect();
+        handles.into_iter().flat_map(|h| h.join().unwrap_or_default()).collect()
+    });
+
+    let total: usize = found.iter().map(|(_, _, _, spans)| spans.len()).sum();
+    if total == 0 {
+        eprintln!("vita: symbol '{}' not found", name);
+        process::exit(1);
+    }
+
+    for (path, content, format, spans) in &found {
+        for span in spans {
+            if total > 1 {
+                out.file_separator(&format!("{}:{}", path.display(), span.start + 1), theme);
+            }
+            match render::code::syntax_name(format) {
+                Some(lang) => render::code::render_span(content, lang, span.clone(), true, theme, out),
+                None => {
+                    let num_width = format!("{}", lines::count(content)).len();
+                    for (i, line) in lines::lines(content).enumerate().skip(span.start).take(span.len()) {
+                        out.dim(&format!(" {:>width$} │ ", i + 1, width = num_width), theme.line_number);
+                        out.colored(line, theme.text);
+                        println!();
+                    }
+                }
+            }
+        }
+    }
+}
+
 fn run_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
     if cli.files.is_empty() {
         if io::stdin().is_terminal() {
@@ -611,7 +1166,7 @@ fn run_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
         if cli.info {
             info::print_header(None, None, Some(&buf), theme, out);
         }
-        render::grep::render(&buf, pattern, theme, out);
+        grep_content(cli, &buf, None, pattern, theme, out);
         return;
     }
 
@@ -625,7 +1180,7 @@ fn run_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
                 if cli.info {
                     info::print_header(None, None, Some(&buf), theme, out);
                 }
-                render::grep::render(&buf, pattern, theme, out);
+                grep_content(cli, &buf, None, pattern, theme, out);
             }
             continue;
         }
@@ -646,13 +1201,27 @@ fn run_grep(cli: &Cli, pattern: &str, theme: &Theme, out: &Output) {
                     let format = detect_format(path);
                     info::print_header(Some(path), Some(&format), Some(&content), theme, out);
                 }
-                render::grep::render(&content, pattern, theme, out);
+                grep_content(cli, &content, Some(path), pattern, theme, out);
             }
             Err(e) => eprintln!("vita: '{}': {}", path.display(), e),
         }
     }
 }
 
+/// Grep `content`, restricted to the `--grep-in` region when one is given.
+fn grep_content(cli: &Cli, content: &str, path: Option<&std::path::Path>, pattern: &str, theme: &Theme, out: &Output) {
+    let Some(region) = cli.grep_in else {
+        render::grep::render(content, pattern, theme, out);
+        return;
+    };
+    let format = match (cli.lang.as_deref(), path) {
+        (Some(lang), _) => detect::format_from_lang(lang),
+        (None, Some(path)) => detect_format(path),
+        (None, None) => detect::detect_from_content(content),
+    };
+    render::grep::render_in(content, pattern, &format, region, theme, out);
+}
+
 fn truncate_lines(content: &str, head: Option<usize>, tail: Option<usize>) -> String {
     if let Some(n) = head {
         content.lines().take(n).collect::<Vec<_>>().join("\n")
@@ -665,6 +1234,54 @@ fn truncate_lines(content: &str, head: Option<usize>, tail: Option<usize>) -> St
     }
 }
 
+/// Messages of the mode conflicts that predate the mode table, kept word
+/// for word for scripts matching on them. `first` precedes `second` in the
+/// table, so for --blame and --hex it is one of the modes their messages list.
+fn legacy_conflict(first: &str, second: &str) -> Option<&'static str> {
+    match (first, second) {
+        ("--brief", "--show-all") => Some("--show-all and --brief cannot be used together"),
+        ("--show-all", "--grep") => Some("--show-all and --grep cannot be used together"),
+        (_, "--blame") => Some("--blame cannot be combined with --brief, --show-all, or --grep"),
+        (_, "--hex") => Some("--hex cannot be combined with --brief, --show-all, --grep, or --blame"),
+        _ => None,
+    }
+}
+
+/// `--query` and `--table` only apply to JSON, and `--depth` to JSON, YAML
+/// and TOML; anything else is an error rather than a silently ignored flag.
+fn check_format_flags(cli: &Cli, format: &FileFormat) {
+    if cli.depth.is_some() && !matches!(format, FileFormat::Json | FileFormat::Yaml | FileFormat::Toml) {
+        eprintln!("vita: --depth requires JSON, YAML or TOML input");
+        process::exit(1);
+    }
+    if matches!(format, FileFormat::Json) {
+        return;
+    }
+    if cli.query.is_some() {
+        eprintln!("vita: --query requires JSON input");
+        process::exit(1);
+    }
+    if cli.table {
+        eprintln!("vita: --table requires JSON or NDJSON input");
+        process::exit(1);
+    }
+}
+
+/// Markup and diffs are rendered straight from their input, without
+/// reading it into memory, unless line limits, the info header,
+/// plain/raw output or line numbers need the whole text.
+fn streams(cli: &Cli) -> bool {
+    !(cli.plain || cli.raw || cli.info || cli.line_numbers || cli.head.is_some() || cli.tail.is_some())
+}
+
+/// Whether markup streams from disk, and if so whether to parse as HTML.
+fn streams_from_disk(cli: &Cli, lang: &str) -> Option<bool> {
+    if !streams(cli) {
+        return None;
+    }
+    render::xml::is_markup(lang)
+}
+
 fn render_content(content: &str, format: &FileFormat, cli: &Cli, theme: &Theme, out: &Output) {
     if cli.plain {
         print!("{}", content);
@@ -688,13 +1305,20 @@ fn render_content(content: &str, format: &FileFormat, cli: &Cli, theme: &Theme,
 
     match format {
         FileFormat::Markdown => render::markdown::render(content, theme, out),
-        FileFormat::Json => render::json::render(content, theme, out),
+        FileFormat::Json if cli.table => render::records::render(content, theme, out),
+        FileFormat::Json => match &cli.query {
+            Some(q) => render::json::render_query(content, q, cli.depth, theme, out),
+            None => render::json::render(content, cli.depth, theme, out),
+        },
         FileFormat::Csv => render::csv::render(content, theme, out),
-        FileFormat::Toml => render::toml::render(content, theme, out),
-        FileFormat::Yaml => render::yaml::render(content, theme, out),
-        FileFormat::Code(lang) => {
-            render::code::render(content, lang, cli.line_numbers, theme, out)
-        }
+        FileFormat::Toml => render::toml::render(content, cli.depth, theme, out),
+        FileFormat::Yaml => render::yaml::render(content, cli.depth, theme, out),
+        FileFormat::Code(lang) if lang == "Diff" && !cli.line_numbers => render::diff::render(content, theme, out),
+        FileFormat::Code(lang) => match render::xml::is_markup(lang) {
+            // Line numbers refer to the source, so -n shows it as code
+            Some(html) if !cli.line_numbers => render::xml::render(content, html, theme, out),
+            _ => render::code::render(content, lang, cli.line_numbers, theme, out),
+        },
         FileFormat::Image => {}
         FileFormat::Plain => render::plain::render(content, cli.line_numbers, theme, out),
     }
@@ -0,0 +1,359 @@
+//! JSON path queries (`--query`)
+//!
+//! Supports a jq/JSONPath-lite subset:
+//!   `.items[3].spec`   keys and indices (negative indices count from the end)
+//!   `.items[*].name`   wildcards over arrays and objects (also `.*`, `[]`)
+//!   `.items[2:5]`      slices with optional, possibly negative bounds
+//!   `.["a key"]`       quoted keys, with an optional leading `$`
+//!
+//! Evaluation is a single streaming pass over the raw bytes: matching
+//! members are descended into, everything else is skipped with the
+//! structural scanner, and the byte ranges of the matches are returned.
+
+use std::ops::Range;
+
+use crate::structural::{skip_string, skip_value, skip_whitespace};
+
+#[derive(Clone, Debug, PartialEq)]
+enum Segment {
+    Key(String),
+    Index(i64),
+    Slice(Option<i64>, Option<i64>),
+    Wildcard,
+}
+
+#[derive(Clone, Debug, PartialEq)]
+pub struct Query {
+    source: String,
+    segments: Vec<Segment>,
+}
+
+impl Query {
+    pub fn parse(source: &str) -> Result<Query, String> {
+        let mut segments = Vec::new();
+        let s = source.trim();
+        let s = s.strip_prefix('$').unwrap_or(s);
+        let bytes = s.as_bytes();
+        let mut i = 0;
+
+        while i < bytes.len() {
+            match bytes[i] {
+                b'.' => {
+                    i += 1;
+                    if i >= bytes.len() || bytes[i] == b'[' {
+                        continue;
+                    }
+                    if bytes[i] == b'*' {
+                        segments.push(Segment::Wildcard);
+                        i += 1;
+                        continue;
+                    }
+                    let start = i;
+                    while i < bytes.len() && bytes[i] != b'.' && bytes[i] != b'[' {
+                        i += 1;
+                    }
+                    if start == i {
+                        return Err(format!("empty key at offset {}", start));
+                    }
+                    segments.push(Segment::Key(s[start..i].to_string()));
+                }
+                b'[' => {
+                    let close = find_bracket_end(s, i)
+                        .ok_or_else(|| format!("unclosed '[' at offset {}", i))?;
+                    segments.push(parse_bracket(s[i + 1..close].trim())?);
+                    i = close + 1;
+                }
+                _ => {
+                    // Bare leading key: `items[0]`
+                    if !segments.is_empty() || i != 0 {
+                        return Err(format!("unexpected '{}' at offset {}", bytes[i] as char, i));
+                    }
+                    let start = i;
+                    while i < bytes.len() && bytes[i] != b'.' && bytes[i] != b'[' {
+                        i += 1;
+                    }
+                    segments.push(Segment::Key(s[start..i].to_string()));
+                }
+            }
+        }
+
+        Ok(Query {
+            source: source.to_string(),
+            segments,
+        })
+    }
+
+    pub fn as_str(&self) -> &str {
+        &self.source
+    }
+
+    /// Byte ranges of every value in `json` selected by the query, in
+    /// document order.
+    pub fn matches(&self, json: &str) -> Vec<Range<usize>> {
+        let bytes = json.as_bytes();
+        let mut found = Vec::new();
+        let start = skip_whitespace(bytes, 0);
+        if start < bytes.len() {
+            eval(json, start, &self.segments, &mut found);
+        }
+        found
+    }
+}
+
+/// Index of the `]` closing the bracket at `open`, skipping quoted keys.
+fn find_bracket_end(s: &str, open: usize) -> Option<usize> {
+    let bytes = s.as_bytes();
+    let mut quote: Option<u8> = None;
+    let mut i = open + 1;
+    while i < bytes.len() {
+        match (quote, bytes[i]) {
+            (Some(_), b'\\') => i += 1,
+            (Some(q), b) if b == q => quote = None,
+            (None, b'"') | (None, b'\'') => quote = Some(bytes[i]),
+            (None, b']') => return Some(i),
+            _ => {}
+        }
+        i += 1;
+    }
+    None
+}
+
+fn parse_bracket(inner: &str) -> Result<Segment, String> {
+    if inner.is_empty() || inner == "*" {
+        return Ok(Segment::Wildcard);
+    }
+    if inner.starts_with('"') {
+        return serde_json::from_str::<String>(inner)
+            .map(Segment::Key)
+            .map_err(|_| format!("invalid quoted key {}", inner));
+    }
+    if inner.len() >= 2 && inner.starts_with('\'') && inner.ends_with('\'') {
+        return Ok(Segment::Key(inner[1..inner.len() - 1].replace("\\'", "'")));
+    }
+    if let Some((a, b)) = inner.split_once(':') {
+        return Ok(Segment::Slice(parse_bound(a)?, parse_bound(b)?));
+    }
+    inner
+        .parse::<i64>()
+        .map(Segment::Index)
+        .map_err(|_| format!("invalid index [{}]", inner))
+}
+
+fn parse_bound(s: &str) -> Result<Option<i64>, String> {
+    let s = s.trim();
+    if s.is_empty() {
+        return Ok(None);
+    }
+    s.parse::<i64>()
+        .map(Some)
+        .map_err(|_| format!("invalid slice bound '{}'", s))
+}
+
+/// Evaluate `segments` against the value at `pos`, pushing matches into
+/// `found`. Returns the index just past that value.
+fn eval(json: &str, pos: usize, segments: &[Segment], found: &mut Vec<Range<usize>>) -> usize {
+    let bytes = json.as_bytes();
+    let (segment, rest) = match segments.split_first() {
+        Some(split) => split,
+        None => {
+            let end = skip_value(bytes, pos);
+            found.push(pos..end);
+            return end;
+        }
+    };
+
+    match (bytes[pos], segment) {
+        (b'{', Segment::Key(_)) | (b'{', Segment::Wildcard) => {
+            let mut i = skip_whitespace(bytes, pos + 1);
+            while i < bytes.len() && bytes[i] != b'}' {
+                if bytes[i] != b'"' {
+                    // Malformed member: skip to the next structural boundary
+                    i = skip_value(bytes, i).max(i + 1);
+                    i = skip_separator(bytes, i);
+                    continue;
+                }
+                let key_end = skip_string(bytes, i);
+                let selected = match segment {
+                    Segment::Key(want) => key_equals(&json[i..key_end], want),
+                    _ => true,
+                };
+                i = skip_whitespace(bytes, key_end);
+                if i < bytes.len() && bytes[i] == b':' {
+                    i = skip_whitespace(bytes, i + 1);
+                }
+                if i >= bytes.len() {
+                    break;
+                }
+                i = if selected {
+                    eval(json, i, rest, found)
+                } else {
+                    skip_value(bytes, i)
+                };
+                i = skip_separator(bytes, i);
+            }
+            (i + 1).min(bytes.len())
+        }
+        (b'[', Segment::Index(_)) | (b'[', Segment::Slice(..)) | (b'[', Segment::Wildcard) => {
+            eval_array(json, pos, segment, rest, found)
+        }
+        _ => skip_value(bytes, pos),
+    }
+}
+
+fn eval_array(
+    json: &str,
+    pos: usize,
+    segment: &Segment,
+    rest: &[Segment],
+    found: &mut Vec<Range<usize>>,
+) -> usize {
+    let bytes = json.as_bytes();
+    let needs_len = match segment {
+        Segment::Index(n) => *n < 0,
+        Segment::Slice(a, b) => a.map_or(false, |v| v < 0) || b.map_or(false, |v| v < 0),
+        _ => false,
+    };
+
+    // Negative positions need the length first: record element offsets
+    // in one skipping pass, then evaluate only the selected ones.
+    if needs_len {
+        let mut starts = Vec::new();
+        let end = for_each_element(bytes, pos, |i| {
+            starts.push(i);
+            skip_value(bytes, i)
+        });
+        let len = starts.len() as i64;
+        for (idx, &start) in starts.iter().enumerate() {
+            if selects(segment, idx as i64, len) {
+                eval(json, start, rest, found);
+            }
+        }
+        return end;
+    }
+
+    let mut idx = 0i64;
+    for_each_element(bytes, pos, |i| {
+        let selected = selects(segment, idx, i64::MAX);
+        idx += 1;
+        if selected {
+            eval(json, i, rest, found)
+        } else {
+            skip_value(bytes, i)
+        }
+    })
+}
+
+/// Walk the elements of the array at `pos`, letting `visit` consume each
+/// one and return the index past it. Returns the index past the array.
+fn for_each_element<F: FnMut(usize) -> usize>(bytes: &[u8], pos: usize, mut visit: F) -> usize {
+    let mut i = skip_whitespace(bytes, pos + 1);
+    while i < bytes.len() && bytes[i] != b']' {
+        i = visit(i).max(i + 1);
+        i = skip_separator(bytes, i);
+    }
+    (i + 1).min(bytes.len())
+}
+
+/// Skip whitespace and at most one `,` after a value.
+fn skip_separator(bytes: &[u8], i: usize) -> usize {
+    let i = skip_whitespace(bytes, i);
+    if i < bytes.len() && bytes[i] == b',' {
+        skip_whitespace(bytes, i + 1)
+    } else {
+        i
+    }
+}
+
+fn selects(segment: &Segment, idx: i64, len: i64) -> bool {
+    let resolve = |v: i64| if v < 0 { len + v } else { v };
+    match segment {
+        Segment::Wildcard => true,
+        Segment::Index(n) => resolve(*n) == idx,
+        Segment::Slice(a, b) => {
+            let lo = a.map_or(0, resolve);
+            let hi = b.map_or(i64::MAX, resolve);
+            idx >= lo && idx < hi
+        }
+        Segment::Key(_) => false,
+    }
+}
+
+/// Compare a raw quoted JSON key against `want`, decoding escapes only
+/// when the key actually contains any.
+fn key_equals(raw: &str, want: &str) -> bool {
+    let inner = &raw[1..raw.len().saturating_sub(1).max(1)];
+    if !inner.contains('\\') {
+        return inner == want;
+    }
+    serde_json::from_str::<String>(raw).map_or(false, |k| k == want)
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn select<'a>(q: &str, json: &'a str) -> Vec<&'a str> {
+        let query = Query::parse(q).unwrap();
+        query.matches(json).into_iter().map(|r| &json[r]).collect()
+    }
+
+    const DOC: &str = r#"{
+        "items": [
+            {"name": "a", "spec": {"x": 1}},
+            {"name": "b", "spec": {"x": 2}},
+            {"name": "c", "spec": [3, 4]}
+        ],
+        "weird key": "w",
+        "esc\"aped": true
+    }"#;
+
+    #[test]
+    fn test_parse_segments() {
+        let q = Query::parse("$.items[3].spec").unwrap();
+        assert_eq!(
+            q.segments,
+            vec![Segment::Key("items".into()), Segment::Index(3), Segment::Key("spec".into())]
+        );
+        let q = Query::parse(".a[*][1:-1][\"b.c\"]").unwrap();
+        assert_eq!(
+            q.segments,
+            vec![
+                Segment::Key("a".into()),
+                Segment::Wildcard,
+                Segment::Slice(Some(1), Some(-1)),
+                Segment::Key("b.c".into()),
+            ]
+        );
+        assert!(Query::parse(".a[").is_err());
+        assert!(Query::parse(".a[x]").is_err());
+    }
+
+    #[test]
+    fn test_identity() {
+        assert_eq!(select(".", "[1, 2]"), vec!["[1, 2]"]);
+    }
+
+    #[test]
+    fn test_key_and_index() {
+        assert_eq!(select(".items[1].spec", DOC), vec![r#"{"x": 2}"#]);
+        assert_eq!(select(".items[-1].spec[0]", DOC), vec!["3"]);
+        assert_eq!(select(".items[7]", DOC), Vec::<&str>::new());
+        assert_eq!(select(".missing", DOC), Vec::<&str>::new());
+    }
+
+    #[test]
+    fn test_wildcard_and_slice() {
+        assert_eq!(select(".items[*].name", DOC), vec![r#""a""#, r#""b""#, r#""c""#]);
+        assert_eq!(select(".items[1:].name", DOC), vec![r#""b""#, r#""c""#]);
+        assert_eq!(select(".items[:-2].name", DOC), vec![r#""a""#]);
+        assert_eq!(select(".items[0].*", DOC), vec![r#""a""#, r#"{"x": 1}"#]);
+    }
+
+    #[test]
+    fn test_quoted_and_escaped_keys() {
+        assert_eq!(select(".[\"weird key\"]", DOC), vec![r#""w""#]);
+        assert_eq!(select(".['esc\"aped']", DOC), vec!["true"]);
+    }
+}
@@ -1,72 +1,176 @@
 //! Git blame renderer — grouped annotations with syntax-highlighted code.
 //!
-//! Runs `git blame --porcelain` and parses the output. Consecutive lines from
-//! the same commit show metadata only on the first line; subsequent lines leave
-//! the metadata columns blank for a clean, grouped layout.
+//! Blame is computed in-process by `crate::git`, with no `git` binary
+//! needed. Repositories it cannot read (SHA-256, reftable, missing objects)
+//! fall back to `git blame --porcelain`. Consecutive lines from the same
+//! commit show metadata only on the first line; subsequent lines leave the
+//! metadata columns blank for a clean, grouped layout.
+//!
+//! A blame that takes a while is shown as it progresses. On a terminal
+//! that fits the file, the code is drawn at once with empty annotation
+//! columns, which are filled in place as commits are resolved. Otherwise
+//! (piped output, or a taller file) lines are printed in order as soon as
+//! every line up to them is attributed, with fixed-width columns since the
+//! widest author is not known yet.
 
 use std::collections::HashMap;
+use std::io::{self, Write};
+use std::ops::Range;
 use std::path::Path;
 use std::process::Command;
-use std::time::{Duration, UNIX_EPOCH};
+use std::time::{Duration, Instant, UNIX_EPOCH};
 
+use crossterm::cursor::MoveToPreviousLine;
 use crossterm::style::Color;
+use crossterm::terminal::{Clear, ClearType};
 use syntect::easy::HighlightLines;
-use syntect::highlighting::{FontStyle, Style, ThemeSet};
-use syntect::parsing::SyntaxSet;
+use syntect::highlighting::{FontStyle, Style, Theme as HighlightTheme, ThemeSet};
+use syntect::parsing::{SyntaxReference, SyntaxSet};
+use unicode_width::UnicodeWidthChar;
 
+use crate::git;
 use crate::output::Output;
 use crate::theme::Theme;
 
-struct BlameLine {
+/// How long a blame may run before partial results are shown
+const PROGRESS_DELAY: Duration = Duration::from_millis(150);
+
+/// Minimum time between in-place repaints
+const REPAINT_INTERVAL: Duration = Duration::from_millis(50);
+
+/// Author column width while streaming, before all authors are known
+const STREAM_AUTHOR_WIDTH: usize = 16;
+
+/// Widest relative date ("just now", "11mo ago")
+const STREAM_DATE_WIDTH: usize = 8;
+
+/// `git blame --porcelain` output, borrowing from its text
+struct Porcelain<'a> {
+    /// `(short hash, author, author time)` of each commit, in order of
+    /// first appearance
+    commits: Vec<(&'a str, &'a str, i64)>,
+    /// Index into `commits` and content of each line
+    lines: Vec<(u32, &'a str)>,
+}
+
+/// Commit metadata shown in the annotation columns, with the date
+/// formatted once per commit
+struct Annotation {
     hash: String,
     author: String,
-    timestamp: i64,
-    content: String,
+    date: String,
 }
 
-pub fn render(
-    path: &Path,
-    lang: &str,
-    head: Option<usize>,
-    tail: Option<usize>,
-    theme: &Theme,
-    out: &Output,
-) {
-    let cmd = match Command::new("git")
-        .args(["blame", "--porcelain"])
-        .arg(path)
-        .output()
-    {
-        Ok(o) if o.status.success() => String::from_utf8_lossy(&o.stdout).into_owned(),
-        Ok(o) => {
-            eprintln!(
-                "vita: git blame failed: {}",
-                String::from_utf8_lossy(&o.stderr).trim()
-            );
-            return;
+/// Lines being blamed and what is known about them so far
+struct View<'a> {
+    content: Vec<&'a str>,
+    annotations: Vec<Annotation>,
+    /// Annotation of each commit seen, by full id; abbreviated hashes
+    /// may collide
+    ids: HashMap<git::Oid, u32>,
+    /// Annotation of each line, once attributed
+    origin: Vec<Option<u32>>,
+}
+
+impl<'a> View<'a> {
+    fn new(content: Vec<&'a str>) -> Self {
+        View {
+            origin: vec![None; content.len()],
+            content,
+            annotations: Vec::new(),
+            ids: HashMap::new(),
         }
-        Err(e) => {
-            eprintln!("vita: failed to run git: {}", e);
-            return;
+    }
+
+    /// Add the annotation of a new commit, shown as `hash`.
+    fn annotate(&mut self, hash: &str, author: &str, timestamp: i64) -> u32 {
+        let time = UNIX_EPOCH + Duration::from_secs(timestamp as u64);
+        self.annotations.push(Annotation {
+            hash: hash.to_string(),
+            author: author.to_string(),
+            date: crate::info::format_relative_time(time),
+        });
+        self.annotations.len() as u32 - 1
+    }
+
+    /// Annotation id of `commit`, added on first sight.
+    fn intern(&mut self, commit: &git::Oid, author: &str, timestamp: i64) -> u32 {
+        if let Some(&id) = self.ids.get(commit) {
+            return id;
         }
-    };
+        let id = self.annotate(&git::to_hex(commit)[..7], author, timestamp);
+        self.ids.insert(*commit, id);
+        id
+    }
 
-    let mut lines = parse_porcelain(&cmd);
-    if lines.is_empty() {
-        return;
+    fn add_hunk(&mut self, hunk: git::blame::Hunk) {
+        let id = self.intern(&hunk.commit, &hunk.author, hunk.time);
+        for i in hunk.lines {
+            self.origin[i as usize] = Some(id);
+        }
     }
 
-    if let Some(n) = head {
-        lines.truncate(n);
-    } else if let Some(n) = tail {
-        let skip = lines.len().saturating_sub(n);
-        lines = lines.split_off(skip);
+    fn annotation(&self, i: usize) -> Option<&Annotation> {
+        self.origin[i].map(|id| &self.annotations[id as usize])
+    }
+
+    /// Whether line `i` continues the previous shown line's commit
+    fn continues(&self, i: usize, shown: &Range<usize>) -> bool {
+        i > shown.start && self.origin[i].is_some() && self.origin[i] == self.origin[i - 1]
+    }
+
+    fn resolved(&self, shown: &Range<usize>) -> bool {
+        self.origin[shown.clone()].iter().all(Option::is_some)
+    }
+}
+
+struct Layout {
+    author: usize,
+    date: usize,
+    num: usize,
+}
+
+impl Layout {
+    /// Columns sized to the annotations of the shown lines
+    fn fitted(view: &View, shown: &Range<usize>) -> Self {
+        let shown_annotations = || shown.clone().filter_map(|i| view.annotation(i));
+        Layout {
+            author: shown_annotations().map(|a| a.author.len()).max().unwrap_or(0),
+            date: shown_annotations().map(|a| a.date.len()).max().unwrap_or(0),
+            num: format!("{}", shown.len()).len(),
+        }
+    }
+
+    fn streaming(shown: &Range<usize>) -> Self {
+        Layout {
+            author: STREAM_AUTHOR_WIDTH,
+            date: STREAM_DATE_WIDTH,
+            num: format!("{}", shown.len()).len(),
+        }
+    }
+
+    /// Columns before the code: annotations, then ` N │ `
+    fn code_column(&self) -> usize {
+        7 + 2 + self.author + 2 + self.date + self.num + 4
     }
+}
 
-    let max_author = lines.iter().map(|l| l.author.len()).max().unwrap_or(0);
-    let line_count = lines.len();
-    let num_width = format!("{}", line_count).len();
+struct Painter<'a> {
+    ss: &'a SyntaxSet,
+    syntax: &'a SyntaxReference,
+    highlight_theme: &'a HighlightTheme,
+    theme: &'a Theme,
+    out: &'a Output,
+}
 
+pub fn render(
+    path: &Path,
+    lang: &str,
+    head: Option<usize>,
+    tail: Option<usize>,
+    theme: &Theme,
+    out: &Output,
+) {
     let ss = SyntaxSet::load_defaults_newlines();
     let ts = ThemeSet::load_defaults();
 
@@ -87,59 +191,300 @@ pub fn render(
         .or_else(|| ts.themes.get("Monokai Extended"))
         .unwrap_or_else(|| ts.themes.values().next().unwrap());
 
-    let mut h = HighlightLines::new(syntax, highlight_theme);
-    let mut prev_hash = String::new();
+    let painter = Painter {
+        ss: &ss,
+        syntax,
+        highlight_theme,
+        theme,
+        out,
+    };
 
-    let dates: Vec<String> = lines
+    let mut blame = match git::Blame::start(path) {
+        Ok(blame) => blame,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => {
+            eprintln!("vita: git blame failed: {}", e);
+            return;
+        }
+        Err(_) => return render_porcelain(path, head, tail, &painter),
+    };
+    let text = std::mem::take(&mut blame.text);
+    if text.is_empty() {
+        return;
+    }
+
+    let mut view = View::new(text.split_terminator('\n').collect());
+    let shown = window(view.content.len(), head, tail);
+    blame.only(shown.clone());
+    let result = if out.use_colors {
+        render_terminal(&mut blame, &mut view, &shown, &painter)
+    } else {
+        stream(&mut blame, &mut view, &shown, &painter)
+    };
+    match result {
+        Ok(()) => blame.finish(),
+        Err(Failure { error, shown_any }) if shown_any => eprintln!("vita: git blame failed: {}", error),
+        Err(_) => render_porcelain(path, head, tail, &painter),
+    }
+}
+
+/// A walk error, and whether any blame had been printed before it
+struct Failure {
+    error: io::Error,
+    shown_any: bool,
+}
+
+fn render_terminal(blame: &mut git::Blame, view: &mut View, shown: &Range<usize>, painter: &Painter) -> Result<(), Failure> {
+    let fail = |error| Failure { error, shown_any: false };
+
+    // Most files resolve quickly; show those in their final layout directly
+    let started = Instant::now();
+    while !view.resolved(shown) && started.elapsed() < PROGRESS_DELAY {
+        match blame.next() {
+            Some(hunk) => view.add_hunk(hunk.map_err(fail)?),
+            None => break,
+        }
+    }
+    if view.resolved(shown) {
+        painter.print_all(view, shown);
+        return Ok(());
+    }
+
+    let rows = terminal_size::terminal_size().map_or(0, |(_, h)| h.0 as usize);
+    if shown.len() >= rows {
+        return stream(blame, view, shown, painter);
+    }
+
+    // Fits on screen: draw everything now and fill annotations in place
+    let mut h = painter.highlighter();
+    let highlighted: Vec<_> = shown.clone().map(|i| painter.highlight(&mut h, &view.content[i])).collect();
+    let mut last_paint: Option<Instant> = None;
+    while !view.resolved(shown) {
+        if last_paint.map_or(true, |t| t.elapsed() >= REPAINT_INTERVAL) {
+            painter.repaint(view, shown, &highlighted, last_paint.is_some());
+            last_paint = Some(Instant::now());
+        }
+        match blame.next() {
+            Some(Ok(hunk)) => view.add_hunk(hunk),
+            Some(Err(error)) => {
+                painter.erase(shown.len());
+                return Err(Failure { error, shown_any: false });
+            }
+            None => break,
+        }
+    }
+    if last_paint.is_some() {
+        painter.erase(shown.len());
+    }
+    let layout = Layout::fitted(view, shown);
+    for (i, code) in shown.clone().zip(&highlighted) {
+        painter.print_row(view, shown, i, &layout, code.as_deref(), None);
+    }
+    Ok(())
+}
+
+/// Print shown lines in order, each as soon as it and all before it are
+/// attributed, and stop walking once every shown line is.
+fn stream(blame: &mut git::Blame, view: &mut View, shown: &Range<usize>, painter: &Painter) -> Result<(), Failure> {
+    let layout = Layout::streaming(shown);
+    let mut h = painter.highlighter();
+    let mut next = shown.start;
+    let mut done = false;
+    loop {
+        while next < shown.end && (done || view.origin[next].is_some()) {
+            let code = painter.highlight(&mut h, &view.content[next]);
+            painter.print_row(view, shown, next, &layout, code.as_deref(), None);
+            next += 1;
+        }
+        if next == shown.end {
+            return Ok(());
+        }
+        match blame.next() {
+            Some(Ok(hunk)) => view.add_hunk(hunk),
+            Some(Err(error)) => {
+                let shown_any = next > shown.start;
+                return Err(Failure { error, shown_any });
+            }
+            None => done = true,
+        }
+    }
+}
+
+fn render_porcelain(path: &Path, head: Option<usize>, tail: Option<usize>, painter: &Painter) {
+    let Some(text) = porcelain(path) else { return };
+    let parsed = parse_porcelain(&text);
+    if parsed.lines.is_empty() {
+        return;
+    }
+    let mut view = View::new(parsed.lines.iter().map(|&(_, content)| content).collect());
+    // Commits are already distinct by full hash
+    let ids: Vec<u32> = parsed
+        .commits
         .iter()
-        .map(|l| {
-            let time = UNIX_EPOCH + Duration::from_secs(l.timestamp as u64);
-            crate::info::format_relative_time(time)
-        })
+        .map(|&(hash, author, time)| view.annotate(hash, author, time))
         .collect();
-    let max_date = dates.iter().map(|d| d.len()).max().unwrap_or(0);
-
-    for (i, line) in lines.iter().enumerate() {
-        let same_commit = line.hash == prev_hash;
-
-        if same_commit {
-            let meta_width = 7 + 2 + max_author + 2 + max_date;
-            print!("{:width$}", "", width = meta_width);
-        } else {
-            out.colored(&line.hash, theme.blame_hash);
-            print!("  ");
-            out.colored(
-                &format!("{:<width$}", line.author, width = max_author),
-                theme.blame_author,
-            );
-            print!("  ");
-            out.dim(&format!("{:<width$}", dates[i], width = max_date), theme.blame_date);
+    for (i, &(commit, _)) in parsed.lines.iter().enumerate() {
+        view.origin[i] = Some(ids[commit as usize]);
+    }
+    let shown = window(view.content.len(), head, tail);
+    painter.print_all(&view, &shown);
+}
+
+/// Lines selected by `--head` / `--tail`
+fn window(len: usize, head: Option<usize>, tail: Option<usize>) -> Range<usize> {
+    if let Some(n) = head {
+        0..n.min(len)
+    } else if let Some(n) = tail {
+        len.saturating_sub(n)..len
+    } else {
+        0..len
+    }
+}
+
+impl<'a> Painter<'a> {
+    /// A highlighter at the start of the file; each pass over the lines
+    /// needs its own, as highlighting carries state from line to line.
+    fn highlighter(&self) -> HighlightLines<'a> {
+        HighlightLines::new(self.syntax, self.highlight_theme)
+    }
+
+    /// Highlighted pieces of one line, without its newline.
+    fn highlight(&self, h: &mut HighlightLines, content: &str) -> Option<Vec<(Style, String)>> {
+        let line = format!("{}\n", content);
+        let ranges = h.highlight_line(&line, self.ss).ok()?;
+        Some(
+            ranges
+                .into_iter()
+                .map(|(style, text)| (style, text.trim_end_matches('\n').to_string()))
+                .filter(|(_, text)| !text.is_empty())
+                .collect(),
+        )
+    }
+
+    fn print_all(&self, view: &View, shown: &Range<usize>) {
+        let layout = Layout::fitted(view, shown);
+        let mut h = self.highlighter();
+        for i in shown.clone() {
+            let code = self.highlight(&mut h, &view.content[i]);
+            self.print_row(view, shown, i, &layout, code.as_deref(), None);
+        }
+    }
+
+    /// Draw the shown lines over the previous drawing, clipped to one
+    /// terminal row each so the cursor can return to the top.
+    fn repaint(
+        &self,
+        view: &View,
+        shown: &Range<usize>,
+        highlighted: &[Option<Vec<(Style, String)>>],
+        painted: bool,
+    ) {
+        if painted {
+            print!("{}", MoveToPreviousLine(shown.len() as u16));
+        }
+        let layout = Layout::fitted(view, shown);
+        let width = (self.out.term_width as usize).saturating_sub(1);
+        for (i, code) in shown.clone().zip(highlighted) {
+            self.print_row(view, shown, i, &layout, code.as_deref(), Some(width));
+        }
+        let _ = io::stdout().flush();
+    }
+
+    /// Remove a drawing of `rows` lines, leaving the cursor where it began.
+    fn erase(&self, rows: usize) {
+        print!("{}{}", MoveToPreviousLine(rows as u16), Clear(ClearType::FromCursorDown));
+        let _ = io::stdout().flush();
+    }
+
+    /// Print line `i`: annotation (blank when continuing the previous
+    /// line's commit, or not yet known), line number, then the highlighted
+    /// `code`, or the plain line when highlighting failed. `clip` limits
+    /// the row to that many terminal columns.
+    fn print_row(
+        &self,
+        view: &View,
+        shown: &Range<usize>,
+        i: usize,
+        layout: &Layout,
+        code: Option<&[(Style, String)]>,
+        clip: Option<usize>,
+    ) {
+        let (theme, out) = (self.theme, self.out);
+        match view.annotation(i).filter(|_| !view.continues(i, shown)) {
+            Some(a) => {
+                out.colored(&a.hash, theme.blame_hash);
+                print!("  ");
+                out.colored(&format!("{:<width$}", a.author, width = layout.author), theme.blame_author);
+                print!("  ");
+                out.dim(&format!("{:<width$}", a.date, width = layout.date), theme.blame_date);
+            }
+            None => print!("{:width$}", "", width = 7 + 2 + layout.author + 2 + layout.date),
         }
 
         out.dim(
-            &format!(" {:>width$} \u{2502} ", i + 1, width = num_width),
+            &format!(" {:>width$} \u{2502} ", i - shown.start + 1, width = layout.num),
             theme.line_number,
         );
 
-        let code_line = format!("{}\n", line.content);
-        match h.highlight_line(&code_line, &ss) {
-            Ok(ranges) => {
-                for (style, text) in ranges {
-                    let color = syntect_to_crossterm(style);
-                    if style.font_style.contains(FontStyle::BOLD) {
-                        out.bold_colored(text, color);
-                    } else if style.font_style.contains(FontStyle::ITALIC) {
-                        out.italic_colored(text, color);
-                    } else {
-                        out.colored(text, color);
+        let Some(code) = code else {
+            let content = &view.content[i];
+            match clip {
+                Some(width) => print!("{}", clipped(content, layout.code_column(), width).0),
+                None => print!("{}", content),
+            }
+            return end_row(clip);
+        };
+
+        let mut column = layout.code_column();
+        for (style, text) in code {
+            let text = match clip {
+                Some(width) => {
+                    let (fitted, end) = clipped(text, column, width);
+                    if fitted.is_empty() {
+                        break;
                     }
+                    column = end;
+                    fitted
                 }
+                None => text,
+            };
+            let style = *style;
+            let color = syntect_to_crossterm(style);
+            if style.font_style.contains(FontStyle::BOLD) {
+                out.bold_colored(text, color);
+            } else if style.font_style.contains(FontStyle::ITALIC) {
+                out.italic_colored(text, color);
+            } else {
+                out.colored(text, color);
             }
-            Err(_) => print!("{}\n", line.content),
         }
+        end_row(clip);
+    }
+}
+
+fn end_row(clip: Option<usize>) {
+    match clip {
+        Some(_) => println!("{}", Clear(ClearType::UntilNewLine)),
+        None => println!(),
+    }
+}
 
-        prev_hash.clone_from(&line.hash);
+/// The part of `text` that fits before column `width` when it starts at
+/// column `start`, and the column it ends at.
+fn clipped(text: &str, start: usize, width: usize) -> (&str, usize) {
+    let mut column = start;
+    for (at, c) in text.char_indices() {
+        let next = match c {
+            '\t' => (column / 8 + 1) * 8,
+            // Other control characters could move the cursor; stop there
+            c if c.is_control() => width + 1,
+            c => column + c.width().unwrap_or(0),
+        };
+        if next > width {
+            return (&text[..at], column);
+        }
+        column = next;
     }
+    (text, column)
 }
 
 fn syntect_to_crossterm(style: Style) -> Color {
@@ -150,60 +495,65 @@ fn syntect_to_crossterm(style: Style) -> Color {
     }
 }
 
-fn parse_porcelain(input: &str) -> Vec<BlameLine> {
-    let mut results = Vec::new();
-    let mut iter = input.lines().peekable();
-    let mut cache: HashMap<String, (String, i64)> = HashMap::new();
-
-    while let Some(header) = iter.next() {
-        let parts: Vec<&str> = header.split_whitespace().collect();
-        if parts.is_empty() || parts[0].len() < 40 {
-            continue;
+/// Output of `git blame --porcelain`, or `None` after reporting the failure.
+fn porcelain(path: &Path) -> Option<String> {
+    match Command::new("git")
+        .args(["blame", "--porcelain"])
+        .arg(path)
+        .output()
+    {
+        Ok(o) if o.status.success() => Some(String::from_utf8_lossy(&o.stdout).into_owned()),
+        Ok(o) => {
+            eprintln!(
+                "vita: git blame failed: {}",
+                String::from_utf8_lossy(&o.stderr).trim()
+            );
+            None
+        }
+        Err(e) => {
+            eprintln!("vita: failed to run git: {}", e);
+            None
         }
+    }
+}
 
-        let full_hash = parts[0];
-        let short_hash = full_hash[..7].to_string();
+fn parse_porcelain(input: &str) -> Porcelain<'_> {
+    let mut parsed = Porcelain {
+        commits: Vec::new(),
+        lines: Vec::new(),
+    };
+    let mut ids: HashMap<&str, u32> = HashMap::new();
+    let mut iter = input.lines();
 
-        let mut author = String::new();
-        let mut timestamp: i64 = 0;
+    while let Some(header) = iter.next() {
+        let Some(full_hash) = header.split_whitespace().next().filter(|h| h.len() >= 40) else {
+            continue;
+        };
+        let commits = &mut parsed.commits;
+        let id = *ids.entry(full_hash).or_insert_with(|| {
+            commits.push((&full_hash[..7], "", 0));
+            commits.len() as u32 - 1
+        });
 
-        // Read metadata lines until tab-prefixed content line
-        while let Some(&next) = iter.peek() {
-            if next.starts_with('\t') {
+        // Metadata (only on a commit's first line) up to the tab-prefixed
+        // content line
+        let mut content = "";
+        for line in iter.by_ref() {
+            if let Some(text) = line.strip_prefix('\t') {
+                content = text;
                 break;
             }
-            let line = iter.next().unwrap();
+            let commit = &mut commits[id as usize];
             if let Some(name) = line.strip_prefix("author ") {
-                author = name.to_string();
+                commit.1 = name;
             } else if let Some(ts) = line.strip_prefix("author-time ") {
-                timestamp = ts.parse().unwrap_or(0);
+                commit.2 = ts.parse().unwrap_or(0);
             }
         }
-
-        if author.is_empty() {
-            if let Some((a, t)) = cache.get(full_hash) {
-                author = a.clone();
-                timestamp = *t;
-            }
-        } else {
-            cache.insert(full_hash.to_string(), (author.clone(), timestamp));
-        }
-
-        let content = iter
-            .next()
-            .and_then(|l| l.strip_prefix('\t'))
-            .unwrap_or("")
-            .to_string();
-
-        results.push(BlameLine {
-            hash: short_hash,
-            author,
-            timestamp,
-            content,
-        });
+        parsed.lines.push((id, content));
     }
 
-    results
+    parsed
 }
 
 #[cfg(test)]
@@ -244,27 +594,59 @@ abc1234567890abcdef1234567890abcdef12345678 4 4
 filename src/main.rs
 \t}";
 
-        let lines = parse_porcelain(input);
-        assert_eq!(lines.len(), 4);
-        assert_eq!(lines[0].hash, "abc1234");
-        assert_eq!(lines[0].author, "Alice");
-        assert_eq!(lines[0].timestamp, 1_700_000_000);
-        assert_eq!(lines[0].content, "fn main() {");
-        assert_eq!(lines[1].hash, "abc1234");
-        assert_eq!(lines[1].author, "Alice");
-        assert_eq!(lines[1].content, "    println!(\"hello\");");
-        assert_eq!(lines[2].hash, "def4567");
-        assert_eq!(lines[2].author, "Bob");
-        assert_eq!(lines[2].timestamp, 1_710_000_000);
-        assert_eq!(lines[2].content, "    let x = 42;");
-        assert_eq!(lines[3].hash, "abc1234");
-        assert_eq!(lines[3].author, "Alice");
-        assert_eq!(lines[3].content, "}");
+        let parsed = parse_porcelain(input);
+        assert_eq!(
+            parsed.commits,
+            [("abc1234", "Alice", 1_700_000_000), ("def4567", "Bob", 1_710_000_000)]
+        );
+        assert_eq!(
+            parsed.lines,
+            [
+                (0, "fn main() {"),
+                (0, "    println!(\"hello\");"),
+                (1, "    let x = 42;"),
+                (0, "}")
+            ]
+        );
+    }
+
+    #[test]
+    fn test_commits_sharing_a_short_hash_stay_apart() {
+        let mut view = View::new(vec!["a", "b", "c"]);
+        let first = [0xab; 20];
+        let mut second = first;
+        second[19] = 0;
+        let hunk = |commit, author: &str, lines| git::blame::Hunk {
+            commit,
+            author: author.to_string(),
+            time: 0,
+            lines,
+        };
+        view.add_hunk(hunk(first, "Alice", vec![0, 2]));
+        view.add_hunk(hunk(second, "Bob", vec![1]));
+        let authors: Vec<&str> = (0..3).map(|i| view.annotation(i).unwrap().author.as_str()).collect();
+        assert_eq!(authors, ["Alice", "Bob", "Alice"]);
+        assert_eq!(view.annotations[0].hash, view.annotations[1].hash);
+    }
+
+    #[test]
+    fn test_window_and_clip() {
+        assert_eq!(window(10, Some(3), None), 0..3);
+        assert_eq!(window(10, None, Some(3)), 7..10);
+        assert_eq!(window(2, Some(5), None), 0..2);
+        assert_eq!(window(2, None, None), 0..2);
+
+        assert_eq!(clipped("hello", 0, 3), ("hel", 3));
+        assert_eq!(clipped("hello", 2, 10), ("hello", 7));
+        // A tab reaches the next multiple of 8
+        assert_eq!(clipped("a\tb", 0, 8), ("a\t", 8));
+        assert_eq!(clipped("日本", 0, 3), ("日", 2));
+        assert_eq!(clipped("a\x1b[2Jb", 0, 80), ("a", 1));
     }
 
     #[test]
     fn test_parse_porcelain_empty() {
-        let lines = parse_porcelain("");
-        assert!(lines.is_empty());
+        let parsed = parse_porcelain("");
+        assert!(parsed.lines.is_empty() && parsed.commits.is_empty());
     }
 }
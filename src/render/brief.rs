@@ -2,21 +2,31 @@
 //!
 //! Extracts and displays structural elements from source files:
 //! function definitions, class declarations, headings, section headers, etc.
-//! Uses keyword-based line matching for code and format-specific logic for
-//! data files (JSON, CSV, YAML, TOML, Markdown, HTML).
+//! Code is outlined from syntect definition scopes (see `symbols`), falling
+//! back to keyword-based line matching, and format-specific logic handles
+//! data files (JSON, CSV, YAML, TOML, Markdown, HTML, XML).
+
+use std::path::Path;
 
 use crate::detect::FileFormat;
+use crate::jsondoc::{Document, Kind, Value as JsonValue};
+use crate::lines;
 use crate::output::Output;
+use crate::render::fold::group_thousands;
+use crate::render::xml;
+use crate::schema::{self, Schema};
+use crate::symbols::{self, Symbol};
 use crate::theme::Theme;
 
-pub fn render(content: &str, format: &FileFormat, theme: &Theme, out: &Output) {
+/// `path` is the file `content` was read from, if any, for caching.
+pub fn render(content: &str, format: &FileFormat, path: Option<&Path>, theme: &Theme, out: &Output) {
     match format {
         FileFormat::Markdown => brief_markdown(content, theme, out),
         FileFormat::Json => brief_json(content, theme, out),
         FileFormat::Csv => brief_csv(content, theme, out),
         FileFormat::Toml => brief_toml(content, theme, out),
         FileFormat::Yaml => brief_yaml(content, theme, out),
-        FileFormat::Code(lang) => brief_code(content, lang, theme, out),
+        FileFormat::Code(lang) => brief_code(content, lang, path, theme, out),
         FileFormat::Plain => brief_plain(content, theme, out),
         FileFormat::Image => {}
     }
@@ -39,8 +49,8 @@ fn brief_markdown(content: &str, theme: &Theme, out: &Output) {
 // ─── JSON ───
 
 fn brief_json(content: &str, theme: &Theme, out: &Output) {
-    if let Ok(val) = serde_json::from_str::<serde_json::Value>(content) {
-        brief_json_value(&val, theme, out);
+    if let Ok(doc) = Document::parse(content) {
+        brief_json_value(doc.root(), theme, out);
     } else {
         // Fallback: scan for top-level keys by looking for lines with `"key":`
         let lines: Vec<&str> = content.lines().collect();
@@ -54,24 +64,35 @@ fn brief_json(content: &str, theme: &Theme, out: &Output) {
     }
 }
 
-fn brief_json_value(val: &serde_json::Value, theme: &Theme, out: &Output) {
-    match val {
-        serde_json::Value::Object(map) => {
-            for (key, value) in map {
+fn brief_json_value(val: JsonValue, theme: &Theme, out: &Output) {
+    match val.kind() {
+        Kind::Object => {
+            for (key, value) in val.entries() {
                 let summary = json_type_summary(value);
                 out.colored("  ", theme.text);
-                out.bold_colored(key, theme.json_key);
+                out.bold_colored(&key, theme.json_key);
                 out.dim(&format!(": {}\n", summary), theme.line_number);
+                if value.kind() == Kind::Array && !value.is_empty() {
+                    let (schema, _) = schema::infer_items(value);
+                    brief_schema_fields(&schema, 2, theme, out);
+                }
             }
         }
-        serde_json::Value::Array(arr) => {
-            let summary = if arr.is_empty() {
-                "[] (empty)".to_string()
-            } else {
-                let first_type = json_type_name(&arr[0]);
-                format!("[{}] ({} items, {})", first_type, arr.len(), first_type)
-            };
+        Kind::Array if val.is_empty() => {
+            out.dim("  [] (empty)\n", theme.line_number);
+        }
+        Kind::Array => {
+            let (schema, sampled) = schema::infer_items(val);
+            let mut summary = format!("[{}] ({} items", schema.type_label(), group_thousands(val.len()));
+            if sampled < val.len() {
+                summary.push_str(&format!(", schema from {} sampled", group_thousands(sampled)));
+            }
+            summary.push(')');
+            if let Some(range) = schema.range_label() {
+                summary.push_str(&format!("  {}", range));
+            }
             out.dim(&format!("  {}\n", summary), theme.line_number);
+            brief_schema_fields(&schema, 1, theme, out);
         }
         _ => {
             out.dim(&format!("  {}\n", json_type_name(val)), theme.line_number);
@@ -79,37 +100,69 @@ fn brief_json_value(val: &serde_json::Value, theme: &Theme, out: &Output) {
     }
 }
 
-fn json_type_summary(val: &serde_json::Value) -> String {
-    match val {
-        serde_json::Value::Object(map) => format!("{{}} ({} keys)", map.len()),
-        serde_json::Value::Array(arr) => {
-            if arr.is_empty() {
-                "[] (empty)".to_string()
-            } else {
-                format!("[{}] ({} items)", json_type_name(&arr[0]), arr.len())
-            }
+/// Deepest nesting level printed for an inferred schema
+const SCHEMA_MAX_LEVEL: usize = 4;
+
+/// Print the merged fields of `schema` (the shape of array elements), one
+/// per line: `name?: type  ranges (presence%)`. Nested objects and arrays
+/// of objects are expanded underneath, indented one more level.
+fn brief_schema_fields(schema: &Schema, level: usize, theme: &Theme, out: &Output) {
+    if level > SCHEMA_MAX_LEVEL {
+        return;
+    }
+    let records = schema.objects();
+    let indent = "  ".repeat(level + 1);
+    for (name, field) in &schema.fields {
+        out.colored(&indent, theme.text);
+        out.bold_colored(name, theme.json_key);
+        let mut line = String::new();
+        if field.seen < records {
+            line.push('?');
+        }
+        line.push_str(": ");
+        line.push_str(&field.type_label());
+        if let Some(range) = field.range_label() {
+            line.push_str(&format!("  {}", range));
         }
-        serde_json::Value::String(s) => {
-            if s.len() > 40 {
-                format!("\"{}...\"", &s[..37])
-            } else {
-                format!("\"{}\"", s)
+        if field.seen < records {
+            line.push_str(&format!(" ({}%)", field.seen * 100 / records.max(1)));
+        }
+        out.dim(&format!("{}\n", line), theme.line_number);
+
+        if !field.fields.is_empty() {
+            brief_schema_fields(field, level + 1, theme, out);
+        } else if let Some(items) = field.items.as_deref() {
+            brief_schema_fields(items, level + 1, theme, out);
+        }
+    }
+}
+
+fn json_type_summary(val: JsonValue) -> String {
+    match val.kind() {
+        Kind::Object => format!("{{}} ({} keys)", val.len()),
+        Kind::Array => match val.items().next() {
+            None => "[] (empty)".to_string(),
+            Some(first) => format!("[{}] ({} items)", json_type_name(first), val.len()),
+        },
+        Kind::String => {
+            let s = val.as_str().unwrap_or_default();
+            match s.char_indices().nth(37) {
+                Some((cut, _)) if s.len() > 40 => format!("\"{}...\"", &s[..cut]),
+                _ => format!("\"{}\"", s),
             }
         }
-        serde_json::Value::Number(n) => n.to_string(),
-        serde_json::Value::Bool(b) => b.to_string(),
-        serde_json::Value::Null => "null".to_string(),
+        Kind::Number | Kind::Bool | Kind::Null => val.raw().to_string(),
     }
 }
 
-fn json_type_name(val: &serde_json::Value) -> &'static str {
-    match val {
-        serde_json::Value::Object(_) => "object",
-        serde_json::Value::Array(_) => "array",
-        serde_json::Value::String(_) => "string",
-        serde_json::Value::Number(_) => "number",
-        serde_json::Value::Bool(_) => "bool",
-        serde_json::Value::Null => "null",
+fn json_type_name(val: JsonValue) -> &'static str {
+    match val.kind() {
+        Kind::Object => "object",
+        Kind::Array => "array",
+        Kind::String => "string",
+        Kind::Number => "number",
+        Kind::Bool => "bool",
+        Kind::Null => "null",
     }
 }
 
@@ -149,59 +202,186 @@ fn brief_csv(content: &str, theme: &Theme, out: &Output) {
 
 // ─── Code (keyword-based) ───
 
-fn brief_code(content: &str, lang: &str, theme: &Theme, out: &Output) {
+fn brief_code(content: &str, lang: &str, path: Option<&Path>, theme: &Theme, out: &Output) {
     let normalized = lang.to_lowercase();
 
     match normalized.as_str() {
         "yaml" | "yml" => return brief_yaml(content, theme, out),
         "toml" => return brief_toml(content, theme, out),
         "html" | "html (rails)" | "html (tcl)" => return brief_html(content, theme, out),
+        "xml" => return brief_xml(content, theme, out),
         "css" | "scss" | "sass" | "less" => return brief_css(content, theme, out),
         "batch file" | "bat" | "cmd" => return brief_batch(content, theme, out),
         "asm" | "nasm" | "assembly" => return brief_asm(content, theme, out),
         _ => {}
     }
 
-    let keywords = keywords_for(&normalized);
-    let lines: Vec<&str> = content.lines().collect();
-    let width = line_num_width(lines.len());
-    let mut found = false;
+    if let Some(symbols) = symbols::extract(content, lang, path).filter(|s| !s.is_empty()) {
+        let width = line_num_width(lines::count(content));
+        for (num, line) in symbol_lines(content, &symbols) {
+            print_line(num, width, line, theme, out);
+        }
+        return;
+    }
 
-    for (i, line) in lines.iter().enumerate() {
-        let trimmed = line.trim_start();
+    let rule = CodeRule::new(&normalized);
+    let width = line_num_width(lines::count(content));
+    let mut found = false;
 
-        if matches_keyword(trimmed, keywords) {
+    for (i, line) in lines::lines(content).enumerate() {
+        if rule.matches(line) {
             print_line(i + 1, width, line, theme, out);
             found = true;
-            continue;
         }
+    }
 
-        // Language-specific heuristics (use original line for indentation checks)
-        match normalized.as_str() {
-            "c" | "c++" | "objective-c" | "objective-c++" if is_c_func_def(line) => {
-                print_line(i + 1, width, line, theme, out);
-                found = true;
-            }
-            "haskell" if has_haskell_sig(line) => {
-                print_line(i + 1, width, line, theme, out);
-                found = true;
+    if !found {
+        out.dim(&format!("  (no brief outline for {})\n", lang), theme.line_number);
+    }
+}
+
+/// `(line number, text)` of each distinct line holding a symbol, in order.
+fn symbol_lines<'a>(content: &'a str, symbols: &[Symbol]) -> Vec<(usize, &'a str)> {
+    let mut wanted = symbols.iter().map(|s| s.line).peekable();
+    let mut result = Vec::new();
+    for (i, line) in lines::lines(content).enumerate() {
+        if wanted.peek().is_none() {
+            break;
+        }
+        let mut hit = false;
+        while let Some(&n) = wanted.peek() {
+            if n > i + 1 {
+                break;
             }
-            "bash" | "sh" | "zsh" | "fish" | "shell"
-            | "bourne again shell (bash)" if is_shell_func(line) => {
-                print_line(i + 1, width, line, theme, out);
-                found = true;
+            hit |= n == i + 1;
+            wanted.next();
+        }
+        if hit {
+            result.push((i + 1, line));
+        }
+    }
+    result
+}
+
+/// Structural-line test for a code language, compiled once per file: the
+/// keyword prefixes become an anchored trie and the language-specific
+/// heuristic is chosen up front instead of re-matching the name per line.
+struct CodeRule {
+    keywords: Keywords,
+    heuristic: Heuristic,
+}
+
+#[derive(Clone, Copy)]
+enum Heuristic {
+    None,
+    CFunction,
+    HaskellSignature,
+    ShellFunction,
+}
+
+impl CodeRule {
+    fn new(lang: &str) -> Self {
+        let heuristic = match lang {
+            "c" | "c++" | "objective-c" | "objective-c++" => Heuristic::CFunction,
+            "haskell" => Heuristic::HaskellSignature,
+            "bash" | "sh" | "zsh" | "fish" | "shell" | "bourne again shell (bash)" => {
+                Heuristic::ShellFunction
             }
-            _ => {}
+            _ => Heuristic::None,
+        };
+        CodeRule {
+            keywords: Keywords::new(keywords_for(lang)),
+            heuristic,
         }
     }
 
-    if !found {
-        out.dim(&format!("  (no brief outline for {})\n", lang), theme.line_number);
+    #[inline]
+    fn matches(&self, line: &str) -> bool {
+        if self.keywords.matches(line.trim_start()) {
+            return true;
+        }
+        // Heuristics look at the original line for indentation checks
+        match self.heuristic {
+            Heuristic::None => false,
+            Heuristic::CFunction => is_c_func_def(line),
+            Heuristic::HaskellSignature => has_haskell_sig(line),
+            Heuristic::ShellFunction => is_shell_func(line),
+        }
     }
 }
 
-fn matches_keyword(trimmed: &str, keywords: &[&str]) -> bool {
-    keywords.iter().any(|kw| trimmed.starts_with(kw))
+/// Keyword prefixes compiled into an anchored byte trie. One walk over the
+/// start of a line decides membership in the whole set, and most lines are
+/// rejected by a single lookup on their first byte.
+struct Keywords {
+    /// Node index + 1 for each first byte; 0 when no keyword starts with it
+    root: [u32; 256],
+    nodes: Vec<TrieNode>,
+}
+
+#[derive(Default)]
+struct TrieNode {
+    terminal: bool,
+    edges: Vec<(u8, u32)>,
+}
+
+impl Keywords {
+    fn new(keywords: &[&str]) -> Self {
+        let mut trie = Keywords {
+            root: [0; 256],
+            nodes: Vec::new(),
+        };
+        for kw in keywords {
+            let bytes = kw.as_bytes();
+            let Some((&first, rest)) = bytes.split_first() else {
+                continue;
+            };
+            let mut node = match trie.root[first as usize] {
+                0 => {
+                    trie.nodes.push(TrieNode::default());
+                    trie.root[first as usize] = trie.nodes.len() as u32;
+                    trie.nodes.len() - 1
+                }
+                n => n as usize - 1,
+            };
+            for &b in rest {
+                node = match trie.nodes[node].edges.iter().find(|(e, _)| *e == b) {
+                    Some(&(_, next)) => next as usize,
+                    None => {
+                        trie.nodes.push(TrieNode::default());
+                        let next = trie.nodes.len() - 1;
+                        trie.nodes[node].edges.push((b, next as u32));
+                        next
+                    }
+                };
+            }
+            trie.nodes[node].terminal = true;
+        }
+        trie
+    }
+
+    /// Whether `text` starts with any of the keywords.
+    #[inline]
+    fn matches(&self, text: &str) -> bool {
+        let bytes = text.as_bytes();
+        let Some(&first) = bytes.first() else {
+            return false;
+        };
+        let mut node = match self.root[first as usize] {
+            0 => return false,
+            n => n as usize - 1,
+        };
+        for &b in &bytes[1..] {
+            if self.nodes[node].terminal {
+                return true;
+            }
+            match self.nodes[node].edges.iter().find(|(e, _)| *e == b) {
+                Some(&(_, next)) => node = next as usize,
+                None => return false,
+            }
+        }
+        self.nodes[node].terminal
+    }
 }
 
 fn keywords_for(lang: &str) -> &'static [&'static str] {
@@ -465,30 +645,62 @@ fn brief_toml(content: &str, theme: &Theme, out: &Output) {
 // ─── HTML ───
 
 fn brief_html(content: &str, theme: &Theme, out: &Output) {
-    let lines: Vec<&str> = content.lines().collect();
-    let width = line_num_width(lines.len());
+    let width = line_num_width(content.lines().count());
+    let mut reader = xml::Reader::new(content.as_bytes(), true);
+    // Open heading: its level (0 for <title>), line and text so far
+    let mut heading: Option<(usize, usize, String)> = None;
     let mut found = false;
 
-    for (i, line) in lines.iter().enumerate() {
-        let lower = line.trim_start().to_lowercase();
-        if lower.starts_with("<title")
-            || lower.starts_with("<h1")
-            || lower.starts_with("<h2")
-            || lower.starts_with("<h3")
-            || lower.starts_with("<h4")
-            || lower.starts_with("<h5")
-            || lower.starts_with("<h6")
-        {
-            print_line(i + 1, width, line, theme, out);
-            found = true;
+    while let Ok(Some(ev)) = reader.next_event() {
+        match ev {
+            xml::Event::Open { name, .. } if heading.is_none() => {
+                if let Some(level) = heading_level(&name) {
+                    heading = Some((level, reader.line(), String::new()));
+                }
+            }
+            xml::Event::Text(text) => {
+                if let Some((_, _, buf)) = heading.as_mut() {
+                    if !buf.is_empty() {
+                        buf.push(' ');
+                    }
+                    buf.push_str(&text.split_whitespace().collect::<Vec<_>>().join(" "));
+                }
+            }
+            xml::Event::Close(name) if heading_level(&name).is_some() => {
+                if let Some((level, line, text)) = heading.take() {
+                    let tag = if level == 0 { "title".to_string() } else { format!("h{}", level) };
+                    let indent = "  ".repeat(level.saturating_sub(1));
+                    print_line(line, width, &format!("{}<{}> {}", indent, tag, text.trim()), theme, out);
+                    found = true;
+                }
+            }
+            _ => {}
         }
     }
 
     if !found {
-        out.dim("  (no brief outline for HTML)\n", theme.line_number);
+        // No headings: fall back to the element-path outline
+        let _ = xml::outline(content.as_bytes(), true, theme, out);
     }
 }
 
+/// `<title>` is level 0, `<h1>`…`<h6>` are 1–6.
+fn heading_level(name: &str) -> Option<usize> {
+    let lower = name.to_ascii_lowercase();
+    match lower.as_str() {
+        "title" => Some(0),
+        "h1" | "h2" | "h3" | "h4" | "h5" | "h6" => lower[1..].parse().ok(),
+        _ => None,
+    }
+}
+
+// ─── XML ───
+
+fn brief_xml(content: &str, theme: &Theme, out: &Output) {
+    // Reading from a slice cannot fail
+    let _ = xml::outline(content.as_bytes(), false, theme, out);
+}
+
 // ─── Plain text fallback ───
 
 fn brief_plain(content: &str, theme: &Theme, out: &Output) {
@@ -500,8 +712,9 @@ fn brief_plain(content: &str, theme: &Theme, out: &Output) {
 
 /// Returns (1-based line number, line text) for lines considered structural.
 /// For JSON/CSV/Plain (no line-mapped structure), returns empty vec.
-pub fn structural_lines<'a>(content: &'a str, format: &FileFormat) -> Vec<(usize, &'a str)> {
-    let lines: Vec<&str> = content.lines().collect();
+/// `path` is the file `content` was read from, if any, for caching.
+pub fn structural_lines<'a>(content: &'a str, format: &FileFormat, path: Option<&Path>) -> Vec<(usize, &'a str)> {
+    let lines: Vec<&str> = lines::lines(content).collect();
     match format {
         FileFormat::Markdown => lines
             .iter()
@@ -521,56 +734,79 @@ pub fn structural_lines<'a>(content: &'a str, format: &FileFormat) -> Vec<(usize
             .filter(|(_, l)| !l.is_empty() && l.len() - l.trim_start().len() <= 2 && l.contains(':'))
             .map(|(i, l)| (i + 1, *l))
             .collect(),
-        FileFormat::Code(lang) => collect_code_structural(&lines, lang),
+        FileFormat::Code(lang) => collect_code_structural(content, &lines, lang, path),
         _ => Vec::new(),
     }
 }
 
-fn collect_code_structural<'a>(lines: &[&'a str], lang: &str) -> Vec<(usize, &'a str)> {
-    let normalized = lang.to_lowercase();
+fn collect_code_structural<'a>(
+    content: &'a str,
+    lines: &[&'a str],
+    lang: &str,
+    path: Option<&Path>,
+) -> Vec<(usize, &'a str)> {
+    let rule = LineRule::new(&lang.to_lowercase());
+    if let LineRule::Code(_) = rule {
+        if let Some(symbols) = symbols::extract(content, lang, path).filter(|s| !s.is_empty()) {
+            return symbol_lines(content, &symbols);
+        }
+    }
     let mut result = Vec::new();
 
     for (i, line) in lines.iter().enumerate() {
-        if is_structural_code_line(line, &normalized) {
+        if rule.matches(line) {
             result.push((i + 1, *line));
         }
     }
     result
 }
 
-fn is_structural_code_line(line: &str, lang: &str) -> bool {
-    let trimmed = line.trim_start();
+/// Structural-line test for any code language, resolved once per file.
+enum LineRule {
+    Yaml,
+    Toml,
+    Html,
+    Css,
+    Batch,
+    Asm,
+    Code(CodeRule),
+}
 
-    match lang {
-        "yaml" | "yml" => {
-            !line.is_empty() && line.len() - line.trim_start().len() <= 2 && line.contains(':')
-        }
-        "toml" => trimmed.starts_with('['),
-        "html" | "html (rails)" | "html (tcl)" => {
-            let lower = trimmed.to_lowercase();
-            lower.starts_with("<title")
-                || lower.starts_with("<h1")
-                || lower.starts_with("<h2")
-                || lower.starts_with("<h3")
-                || lower.starts_with("<h4")
-                || lower.starts_with("<h5")
-                || lower.starts_with("<h6")
-        }
-        "css" | "scss" | "sass" | "less" => is_css_selector(trimmed),
-        "batch file" | "bat" | "cmd" => trimmed.starts_with(':') && !trimmed.starts_with("::"),
-        "asm" | "nasm" | "assembly" => is_asm_structural(trimmed),
-        _ => {
-            let keywords = keywords_for(lang);
-            if matches_keyword(trimmed, keywords) {
-                return true;
+impl LineRule {
+    fn new(lang: &str) -> Self {
+        match lang {
+            "yaml" | "yml" => LineRule::Yaml,
+            "toml" => LineRule::Toml,
+            "html" | "html (rails)" | "html (tcl)" => LineRule::Html,
+            "css" | "scss" | "sass" | "less" => LineRule::Css,
+            "batch file" | "bat" | "cmd" => LineRule::Batch,
+            "asm" | "nasm" | "assembly" => LineRule::Asm,
+            _ => LineRule::Code(CodeRule::new(lang)),
+        }
+    }
+
+    fn matches(&self, line: &str) -> bool {
+        let trimmed = line.trim_start();
+
+        match self {
+            LineRule::Yaml => {
+                !line.is_empty() && line.len() - line.trim_start().len() <= 2 && line.contains(':')
             }
-            match lang {
-                "c" | "c++" | "objective-c" | "objective-c++" => is_c_func_def(line),
-                "haskell" => has_haskell_sig(line),
-                "bash" | "sh" | "zsh" | "fish" | "shell"
-                | "bourne again shell (bash)" => is_shell_func(line),
-                _ => false,
+            LineRule::Toml => trimmed.starts_with('['),
+            LineRule::Html => {
+                let lower = trimmed.to_lowercase();
+                lower.starts_with("<title")
+                    || lower.starts_with("<h1")
+                    || lower.starts_with("<h2")
+                    || lower.starts_with("<h3")
+                    || lower.starts_with("<h4")
+                    || lower.starts_with("<h5")
+                    || lower.starts_with("<h6")
             }
+            LineRule::Css => is_css_selector(trimmed),
+            LineRule::Batch => trimmed.starts_with(':') && !trimmed.starts_with("::"),
+            LineRule::Asm => is_asm_structural(trimmed),
+            LineRule::Code(rule) => rule.matches(line),
         }
     }
 }
@@ -639,15 +875,17 @@ mod tests {
     #[test]
     fn test_format_json_brief() {
         let json = r#"{"name":"test","items":[1,2,3],"nested":{"a":1}}"#;
-        let val: serde_json::Value = serde_json::from_str(json).unwrap();
-        if let serde_json::Value::Object(map) = &val {
-            assert_eq!(map.len(), 3);
-            assert!(map.contains_key("name"));
-            assert!(map.contains_key("items"));
-            assert!(map.contains_key("nested"));
-        } else {
-            panic!("expected object");
-        }
+        let doc = Document::parse(json).unwrap();
+        let root = doc.root();
+        assert_eq!(root.kind(), Kind::Object);
+        assert_eq!(root.len(), 3);
+        let summaries: Vec<(String, String)> = root
+            .entries()
+            .map(|(k, v)| (k.into_owned(), json_type_summary(v)))
+            .collect();
+        assert_eq!(summaries[0], ("name".to_string(), "\"test\"".to_string()));
+        assert_eq!(summaries[1], ("items".to_string(), "[number] (3 items)".to_string()));
+        assert_eq!(summaries[2], ("nested".to_string(), "{} (1 keys)".to_string()));
     }
 
     #[test]
@@ -696,9 +934,29 @@ mod tests {
 
     #[test]
     fn test_matches_keyword() {
-        let kw = &["fn ", "pub fn "];
-        assert!(matches_keyword("fn main() {", kw));
-        assert!(matches_keyword("pub fn new() -> Self {", kw));
-        assert!(!matches_keyword("let x = fn_ptr;", kw));
+        let kw = Keywords::new(&["fn ", "pub fn "]);
+        assert!(kw.matches("fn main() {"));
+        assert!(kw.matches("pub fn new() -> Self {"));
+        assert!(!kw.matches("let x = fn_ptr;"));
+        assert!(!kw.matches("pub"));
+        assert!(!kw.matches(""));
+    }
+
+    #[test]
+    fn test_keyword_trie_matches_prefix_scan() {
+        let langs = ["rust", "java", "c#", "c++", "python", "sql", "dockerfile"];
+        let samples = [
+            "pub(crate) fn x()", "public static void main", "private int y;", "class A",
+            "CREATE TABLE t", "create index", "FROM alpine", "fn", "f", "pub struct S", "#include <a>",
+            "namespace n {", "async def f():", "x = 1", "",
+        ];
+        for lang in langs {
+            let list = keywords_for(lang);
+            let trie = Keywords::new(list);
+            for line in samples {
+                let expected = list.iter().any(|kw| line.starts_with(kw));
+                assert_eq!(trie.matches(line), expected, "{} / {:?}", lang, line);
+            }
+        }
     }
 }
@@ -1,34 +1,29 @@
+use std::io;
+use std::ops::Range;
+use std::sync::OnceLock;
+use std::thread;
+
 use crossterm::style::Color;
 use syntect::easy::HighlightLines;
-use syntect::highlighting::{FontStyle, Style, ThemeSet};
-use syntect::parsing::SyntaxSet;
+use syntect::highlighting::{FontStyle, Style, Theme as HighlightTheme, ThemeSet};
+use syntect::parsing::{SyntaxReference, SyntaxSet};
 use syntect::util::LinesWithEndings;
 
+use crate::detect::FileFormat;
+use crate::git::changes::Change;
 use crate::output::Output;
 use crate::theme::Theme;
 
 pub fn render(content: &str, lang: &str, line_numbers: bool, theme: &Theme, out: &Output) {
-    let ss = SyntaxSet::load_defaults_newlines();
-    let ts = ThemeSet::load_defaults();
-
-    let syntax = ss
-        .find_syntax_by_name(lang)
-        .or_else(|| ss.find_syntax_by_extension(&lang.to_lowercase()))
-        .or_else(|| ss.find_syntax_by_token(&lang.to_lowercase()))
-        .or_else(|| {
-            let fb = crate::detect::syntax_fallback(lang);
-            ss.find_syntax_by_name(fb)
-                .or_else(|| ss.find_syntax_by_token(fb))
-        })
-        .unwrap_or_else(|| ss.find_syntax_plain_text());
-
-    let highlight_theme = ts
-        .themes
-        .get(theme.syntect_theme)
-        .or_else(|| ts.themes.get("Monokai Extended"))
-        .unwrap_or_else(|| ts.themes.values().next().unwrap());
+    render_span(content, lang, 0..usize::MAX, line_numbers, theme, out);
+}
 
-    let mut h = HighlightLines::new(syntax, highlight_theme);
+/// Render only the 0-based lines in `span`. Earlier lines still go through
+/// the highlighter, unprinted, so the span starts in the right parse state.
+pub fn render_span(content: &str, lang: &str, span: Range<usize>, line_numbers: bool, theme: &Theme, out: &Output) {
+    let ss = syntax_set();
+    let ts = ThemeSet::load_defaults();
+    let mut h = HighlightLines::new(find_syntax(ss, lang), highlight_theme(&ts, theme));
 
     let lines: Vec<&str> = LinesWithEndings::from(content).collect();
     let line_count = lines.len();
@@ -38,34 +33,124 @@ pub fn render(content: &str, lang: &str, line_numbers: bool, theme: &Theme, out:
         0
     };
 
-    for (i, line) in lines.iter().enumerate() {
+    for (i, line) in lines.iter().enumerate().take(span.end) {
+        if i < span.start {
+            let _ = h.highlight_line(line, ss);
+            continue;
+        }
         if line_numbers {
             out.dim(&format!(" {:>width$} │ ", i + 1, width = num_width), theme.line_number);
         }
 
-        match h.highlight_line(line, &ss) {
-            Ok(ranges) => {
-                for (style, text) in ranges {
-                    let color = syntect_to_crossterm(style);
-                    if style.font_style.contains(FontStyle::BOLD) {
-                        out.bold_colored(text, color);
-                    } else if style.font_style.contains(FontStyle::ITALIC) {
-                        out.italic_colored(text, color);
-                    } else {
-                        out.colored(text, color);
-                    }
-                }
-            }
+        match h.highlight_line(line, ss) {
+            Ok(ranges) => print_ranges(&ranges, out),
             Err(_) => print!("{}", line),
         }
     }
 
     // Ensure final newline
-    if !content.ends_with('\n') {
+    if span.end >= line_count && !content.ends_with('\n') {
         println!();
     }
 }
 
+/// `render_span` with line numbers and a gutter marking each line's
+/// `Change`. `changes` (a diff against HEAD) runs on another thread while
+/// the lines are highlighted; printing starts once both are done.
+pub fn render_changes<F>(content: &str, lang: &str, span: Range<usize>, theme: &Theme, out: &Output, changes: F)
+where
+    F: FnOnce() -> io::Result<Vec<Option<Change>>> + Send,
+{
+    let ss = syntax_set();
+    let ts = ThemeSet::load_defaults();
+    let mut h = HighlightLines::new(find_syntax(ss, lang), highlight_theme(&ts, theme));
+
+    let lines: Vec<&str> = LinesWithEndings::from(content).collect();
+    let span = span.start.min(lines.len())..span.end.min(lines.len());
+    let (highlighted, marks) = thread::scope(|scope| {
+        let diff = scope.spawn(changes);
+        let highlighted: Vec<_> = lines[..span.end].iter().map(|line| h.highlight_line(line, ss).ok()).collect();
+        (highlighted, diff.join().expect("diff thread panicked"))
+    });
+    let marks = marks.unwrap_or_else(|e| {
+        eprintln!("vita: cannot diff against HEAD: {}", e);
+        Vec::new()
+    });
+
+    let num_width = format!("{}", lines.len()).len();
+    for i in span.clone() {
+        let (sign, color) = match marks.get(i).copied().flatten() {
+            Some(Change::Added) => ("+", theme.diff_added),
+            Some(Change::Modified) => ("~", theme.diff_modified),
+            Some(Change::RemovedBelow) => ("_", theme.diff_deleted),
+            Some(Change::RemovedAbove) => ("\u{203e}", theme.diff_deleted),
+            None => (" ", theme.line_number),
+        };
+        out.colored(sign, color);
+        out.dim(&format!("{:>width$} │ ", i + 1, width = num_width), theme.line_number);
+        match &highlighted[i] {
+            Some(ranges) => print_ranges(ranges, out),
+            None => print!("{}", lines[i]),
+        }
+    }
+
+    if span.end >= lines.len() && !content.ends_with('\n') {
+        println!();
+    }
+}
+
+/// The syntect theme paired with `theme`.
+pub fn highlight_theme<'a>(ts: &'a ThemeSet, theme: &Theme) -> &'a HighlightTheme {
+    ts.themes
+        .get(theme.syntect_theme)
+        .or_else(|| ts.themes.get("Monokai Extended"))
+        .unwrap_or_else(|| ts.themes.values().next().unwrap())
+}
+
+pub fn print_ranges(ranges: &[(Style, &str)], out: &Output) {
+    for &(style, text) in ranges {
+        let color = syntect_to_crossterm(style);
+        if style.font_style.contains(FontStyle::BOLD) {
+            out.bold_colored(text, color);
+        } else if style.font_style.contains(FontStyle::ITALIC) {
+            out.italic_colored(text, color);
+        } else {
+            out.colored(text, color);
+        }
+    }
+}
+
+/// Bundled syntax definitions, loaded once and shared (also across threads).
+pub fn syntax_set() -> &'static SyntaxSet {
+    static SYNTAXES: OnceLock<SyntaxSet> = OnceLock::new();
+    SYNTAXES.get_or_init(SyntaxSet::load_defaults_newlines)
+}
+
+/// Syntect syntax name for a detected format.
+pub fn syntax_name(format: &FileFormat) -> Option<&str> {
+    match format {
+        FileFormat::Code(lang) => Some(lang),
+        FileFormat::Markdown => Some("Markdown"),
+        FileFormat::Json => Some("JSON"),
+        FileFormat::Yaml => Some("YAML"),
+        FileFormat::Toml => Some("TOML"),
+        FileFormat::Csv | FileFormat::Image | FileFormat::Plain => None,
+    }
+}
+
+/// Resolve a language name to a syntax, falling back to plain text.
+pub fn find_syntax<'a>(ss: &'a SyntaxSet, lang: &str) -> &'a SyntaxReference {
+    ss.find_syntax_by_name(lang)
+        .or_else(|| ss.find_syntax_by_extension(&lang.to_lowercase()))
+        .or_else(|| ss.find_syntax_by_token(&lang.to_lowercase()))
+        .or_else(|| {
+            let fb = crate::detect::syntax_fallback(lang);
+            ss.find_syntax_by_name(fb)
+                .or_else(|| ss.find_syntax_by_token(fb))
+        })
+        .unwrap_or_else(|| ss.find_syntax_plain_text())
+}
+
 fn syntect_to_crossterm(style: Style) -> Color {
     Color::Rgb {
         r: style.foreground.r,
@@ -6,6 +6,7 @@
 use crate::output::Output;
 use crate::theme::Theme;
 use crossterm::style::Color;
+use unicode_width::{UnicodeWidthChar, UnicodeWidthStr};
 
 const COLUMN_COLORS: &[(u8, u8, u8)] = &[
     (182, 215, 252), // pastel blue
@@ -41,35 +42,90 @@ pub fn render(content: &str, theme: &Theme, out: &Output) {
     for row in &rows {
         for (i, cell) in row.iter().enumerate() {
             if i < col_count {
-                widths[i] = widths[i].max(cell.len());
+                widths[i] = widths[i].max(cell.width());
             }
         }
     }
 
-    // Cap column widths to something reasonable
-    let max_col_width = ((out.term_width as usize).saturating_sub(col_count * 3 + 4)) / col_count.max(1);
-    let max_col_width = max_col_width.max(8).min(40);
-    for w in widths.iter_mut() {
-        *w = (*w).min(max_col_width);
+    let table = Table::new(widths, theme, out);
+    table.top(out);
+
+    for (r, row) in rows.iter().enumerate() {
+        if r == 0 {
+            table.header(row, out);
+            if rows.len() > 1 {
+                table.separator(out);
+            }
+        } else {
+            table.row(row, out);
+        }
     }
 
-    let border_color = theme.table_border;
+    table.bottom(out);
 
-    print_border_top(&widths, col_count, border_color, out);
+    let data_rows = if rows.len() > 1 { rows.len() - 1 } else { rows.len() };
+    out.dim(
+        &format!("  {} rows × {} columns\n", data_rows, col_count),
+        theme.hr,
+    );
+}
 
-    for (r, row) in rows.iter().enumerate() {
+/// Bordered table with one pastel color per column. Rows are printed one
+/// at a time, so callers can stream them once the column widths are known.
+pub(crate) struct Table {
+    widths: Vec<usize>,
+    border: Color,
+}
+
+impl Table {
+    /// `widths` are the natural (widest cell) widths; they are capped so the
+    /// table fits the terminal.
+    pub fn new(mut widths: Vec<usize>, theme: &Theme, out: &Output) -> Self {
+        let col_count = widths.len().max(1);
+        let max_col_width = ((out.term_width as usize).saturating_sub(col_count * 3 + 4)) / col_count;
+        let max_col_width = max_col_width.max(8).min(40);
+        for w in widths.iter_mut() {
+            *w = (*w).min(max_col_width);
+        }
+        Table {
+            widths,
+            border: theme.table_border,
+        }
+    }
+
+    pub fn top(&self, out: &Output) {
+        self.border_line(("┌", "┬", "┐"), out);
+    }
+
+    pub fn separator(&self, out: &Output) {
+        self.border_line(("├", "┼", "┤"), out);
+    }
+
+    pub fn bottom(&self, out: &Output) {
+        self.border_line(("└", "┴", "┘"), out);
+    }
+
+    pub fn header<S: AsRef<str>>(&self, cells: &[S], out: &Output) {
+        self.print_cells(cells, true, out);
+    }
+
+    pub fn row<S: AsRef<str>>(&self, cells: &[S], out: &Output) {
+        self.print_cells(cells, false, out);
+    }
+
+    fn print_cells<S: AsRef<str>>(&self, cells: &[S], bold: bool, out: &Output) {
         print!("  ");
-        out.colored("│", border_color);
+        out.colored("│", self.border);
 
-        for (c, w) in widths.iter().enumerate() {
-            let cell = row.get(c).map(|s| s.as_str()).unwrap_or("");
+        for (c, w) in self.widths.iter().enumerate() {
+            let cell = cells.get(c).map(|s| s.as_ref()).unwrap_or("");
             let truncated = truncate_str(cell, *w);
-            let padding = w.saturating_sub(truncated.len());
+            let padding = w.saturating_sub(truncated.width());
 
             let col_color = column_color(c);
 
             print!(" ");
-            if r == 0 {
+            if bold {
                 out.bold_colored(&truncated, col_color);
             } else {
                 out.colored(&truncated, col_color);
@@ -78,22 +134,20 @@ pub fn render(content: &str, theme: &Theme, out: &Output) {
                 print!(" ");
             }
             print!(" ");
-            out.colored("│", border_color);
+            out.colored("│", self.border);
         }
         println!();
+    }
 
-        if r == 0 && rows.len() > 1 {
-            print_border_mid(&widths, col_count, border_color, out);
+    fn border_line(&self, (left, mid, right): (&str, &str, &str), out: &Output) {
+        print!("  ");
+        out.colored(left, self.border);
+        for (i, w) in self.widths.iter().enumerate() {
+            out.colored(&"─".repeat(*w + 2), self.border);
+            out.colored(if i + 1 < self.widths.len() { mid } else { right }, self.border);
         }
+        println!();
     }
-
-    print_border_bottom(&widths, col_count, border_color, out);
-
-    let data_rows = if rows.len() > 1 { rows.len() - 1 } else { rows.len() };
-    out.dim(
-        &format!("  {} rows × {} columns\n", data_rows, col_count),
-        theme.hr,
-    );
 }
 
 fn column_color(index: usize) -> Color {
@@ -168,42 +222,24 @@ fn parse_csv(content: &str, delimiter: char) -> Vec<Vec<String>> {
     rows
 }
 
-fn truncate_str(s: &str, max_len: usize) -> String {
-    if s.len() <= max_len {
-        s.to_string()
-    } else if max_len > 2 {
-        format!("{}…", &s[..max_len - 1])
-    } else {
-        s[..max_len].to_string()
-    }
-}
-
-fn print_border_top(widths: &[usize], col_count: usize, color: Color, out: &Output) {
-    print!("  ");
-    out.colored("┌", color);
-    for (i, w) in widths.iter().enumerate() {
-        out.colored(&"─".repeat(*w + 2), color);
-        out.colored(if i < col_count - 1 { "┬" } else { "┐" }, color);
+/// Cut `s` to at most `max_width` display columns, marking the cut with `…`.
+fn truncate_str(s: &str, max_width: usize) -> String {
+    if s.width() <= max_width {
+        return s.to_string();
     }
-    println!();
-}
-
-fn print_border_mid(widths: &[usize], col_count: usize, color: Color, out: &Output) {
-    print!("  ");
-    out.colored("├", color);
-    for (i, w) in widths.iter().enumerate() {
-        out.colored(&"─".repeat(*w + 2), color);
-        out.colored(if i < col_count - 1 { "┼" } else { "┤" }, color);
+    let budget = if max_width > 2 { max_width - 1 } else { max_width };
+    let mut used = 0;
+    let mut cut = String::new();
+    for ch in s.chars() {
+        let w = ch.width().unwrap_or(0);
+        if used + w > budget {
+            break;
+        }
+        used += w;
+        cut.push(ch);
     }
-    println!();
-}
-
-fn print_border_bottom(widths: &[usize], col_count: usize, color: Color, out: &Output) {
-    print!("  ");
-    out.colored("└", color);
-    for (i, w) in widths.iter().enumerate() {
-        out.colored(&"─".repeat(*w + 2), color);
-        out.colored(if i < col_count - 1 { "┴" } else { "┘" }, color);
+    if max_width > 2 {
+        cut.push('…');
     }
-    println!();
+    cut
 }
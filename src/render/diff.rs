@@ -0,0 +1,486 @@
+//! Diff renderer — two files compared in-process (`vita --diff OLD NEW`),
+//! or a unified diff read as a stream (`git diff | vita`).
+//!
+//! Files are diffed with lines hashed to `u64`s (`crate::diff::Line`) in
+//! linear space, with hunks placed where git would place them, and printed
+//! as a unified diff with three lines of context. Either way code is
+//! highlighted in the file's language, and where a removed line is paired
+//! with an added one, the words that differ between them are emphasized.
+//! Piped, the output is a plain unified diff.
+
+use std::cell::Cell;
+use std::io::{self, BufRead};
+use std::ops::Range;
+use std::path::Path;
+
+use syntect::easy::HighlightLines;
+use syntect::highlighting::{Style, ThemeSet};
+use syntect::parsing::{SyntaxReference, SyntaxSet};
+
+use crate::detect;
+use crate::diff;
+use crate::output::Output;
+use crate::render::code;
+use crate::theme::Theme;
+
+/// Unchanged lines shown around each change
+const CONTEXT: usize = 3;
+
+/// Changed lines `old` of the old file, replaced by `new` of the new one
+#[derive(Clone, Debug, PartialEq)]
+struct Block {
+    old: Range<usize>,
+    new: Range<usize>,
+}
+
+pub fn render_files(old_name: &str, old: &str, new_name: &str, new: &str, lang: &str, theme: &Theme, out: &Output) {
+    let old_lines: Vec<&str> = old.split_inclusive('\n').collect();
+    let new_lines: Vec<&str> = new.split_inclusive('\n').collect();
+    let hash = |lines: &[&str]| -> Vec<diff::Line> { lines.iter().map(|l| diff::Line::new(l.as_bytes())).collect() };
+    let pairs = diff::line_matches(&hash(&old_lines), &hash(&new_lines));
+    let blocks = blocks(&pairs, old_lines.len(), new_lines.len());
+    if blocks.is_empty() {
+        return;
+    }
+
+    out.bold_colored(&format!("--- {}", old_name), theme.file_header);
+    println!();
+    out.bold_colored(&format!("+++ {}", new_name), theme.file_header);
+    println!();
+
+    let painter = Painter::new(lang, theme, out);
+    for hunk in hunks(&blocks) {
+        painter.print_hunk(hunk, &old_lines, &new_lines);
+    }
+}
+
+pub fn render(content: &str, theme: &Theme, out: &Output) {
+    // Reading from a slice cannot fail
+    let _ = render_reader(content.as_bytes(), theme, out);
+}
+
+/// Render a unified diff (`git diff`, `git log -p`, `diff -u`) line by
+/// line. Only the current run of changed lines is held, so output keeps
+/// pace with input however many files the diff spans.
+pub fn render_reader<R: BufRead>(mut input: R, theme: &Theme, out: &Output) -> io::Result<()> {
+    let painter = Painter::new("Plain Text", theme, out);
+    let mut hunk: Option<Hunk> = None;
+    let mut old_path = String::new();
+    let mut raw = Vec::new();
+    loop {
+        raw.clear();
+        if input.read_until(b'\n', &mut raw)? == 0 {
+            break;
+        }
+        let line = String::from_utf8_lossy(&raw);
+        if let Some(h) = hunk.as_mut() {
+            if h.take(&line, &painter) {
+                continue;
+            }
+            h.flush(&painter);
+            hunk = None;
+        }
+
+        let text = line.trim_end_matches(['\n', '\r']);
+        if let Some(path) = text.strip_prefix("--- ") {
+            old_path = header_path(path).to_string();
+            out.bold_colored(text, theme.file_header);
+        } else if let Some(path) = text.strip_prefix("+++ ") {
+            let path = match header_path(path) {
+                "/dev/null" => &old_path,
+                path => path,
+            };
+            painter.set_lang(code::syntax_name(&detect::detect_format(Path::new(path))).unwrap_or("Plain Text"));
+            out.bold_colored(text, theme.file_header);
+        } else if text.starts_with("diff ") {
+            out.bold_colored(text, theme.file_header);
+        } else if text.starts_with("commit ") {
+            out.colored(text, theme.blame_hash);
+        } else if let Some((header, counts)) = hunk_header(text) {
+            out.dim(header, theme.line_number);
+            print!("{}", &text[header.len()..]);
+            hunk = Some(Hunk::new(counts, &painter));
+        } else {
+            print!("{}", text);
+        }
+        println!();
+    }
+    if let Some(mut h) = hunk {
+        h.flush(&painter);
+    }
+    Ok(())
+}
+
+/// The path in a `---`/`+++` header, without quotes or a `diff -u`
+/// timestamp.
+fn header_path(header: &str) -> &str {
+    header.split('\t').next().unwrap_or(header).trim_matches('"')
+}
+
+/// `@@ -l,n +l,n @@` at the start of `text`, with the old and new line
+/// counts it announces.
+fn hunk_header(text: &str) -> Option<(&str, (usize, usize))> {
+    let rest = text.strip_prefix("@@ -")?;
+    let end = rest.find(" @@")?;
+    let (old, new) = rest[..end].split_once(" +")?;
+    let count = |range: &str| match range.split_once(',') {
+        Some((start, count)) => start.parse::<usize>().ok().and(count.parse().ok()),
+        None => range.parse::<usize>().ok().map(|_| 1),
+    };
+    Some((&text[..4 + end + 3], (count(old)?, count(new)?)))
+}
+
+/// A hunk being read: lines still due on each side, and the changed lines
+/// since the last context line.
+struct Hunk<'p> {
+    old_left: usize,
+    new_left: usize,
+    old_h: HighlightLines<'p>,
+    new_h: HighlightLines<'p>,
+    removed: Vec<String>,
+    added: Vec<String>,
+}
+
+impl<'p> Hunk<'p> {
+    fn new((old_left, new_left): (usize, usize), painter: &'p Painter) -> Self {
+        Hunk {
+            old_left,
+            new_left,
+            old_h: painter.highlighter(),
+            new_h: painter.highlighter(),
+            removed: Vec::new(),
+            added: Vec::new(),
+        }
+    }
+
+    /// Take `line` into the hunk, printing what it completes; false once
+    /// the line is past the hunk's end.
+    fn take(&mut self, line: &str, painter: &Painter) -> bool {
+        // A final line without its newline reads as if it had one
+        let body = |line: &str| {
+            let body = line.get(1..).unwrap_or("");
+            if body.ends_with('\n') { body.to_string() } else { format!("{}\n", body) }
+        };
+        match line.as_bytes().first() {
+            Some(b'-') if self.old_left > 0 => {
+                if !self.added.is_empty() {
+                    self.flush(painter);
+                }
+                self.removed.push(body(line));
+                self.old_left -= 1;
+            }
+            Some(b'+') if self.new_left > 0 => {
+                self.added.push(body(line));
+                self.new_left -= 1;
+            }
+            // Some tools strip the space from empty context lines
+            Some(b' ' | b'\n' | b'\r') if self.old_left > 0 && self.new_left > 0 => {
+                self.flush(painter);
+                let body = if line.starts_with(' ') { body(line) } else { "\n".to_string() };
+                painter.line(&mut self.old_h, ' ', &body, &[], false);
+                painter.print(&mut self.new_h, ' ', &body, &[]);
+                self.old_left -= 1;
+                self.new_left -= 1;
+            }
+            Some(b'\\') => {
+                // "No newline at end of file" for the line before; changed
+                // lines print it themselves when they lack the newline
+                match self.added.last_mut().or(self.removed.last_mut()) {
+                    Some(last) => {
+                        last.pop();
+                    }
+                    None => {
+                        painter.out.dim(line.trim_end_matches(['\n', '\r']), painter.theme.line_number);
+                        println!();
+                    }
+                }
+            }
+            _ => return false,
+        }
+        true
+    }
+
+    fn flush(&mut self, painter: &Painter) {
+        painter.print_block(&mut self.old_h, &mut self.new_h, &self.removed, &self.added);
+        self.removed.clear();
+        self.added.clear();
+    }
+}
+
+/// Changed stretches between the matched line pairs, in order.
+fn blocks(pairs: &[(usize, usize)], old_len: usize, new_len: usize) -> Vec<Block> {
+    let mut blocks = Vec::new();
+    let (mut i, mut j) = (0, 0);
+    for &(oi, nj) in pairs.iter().chain([&(old_len, new_len)]) {
+        if oi > i || nj > j {
+            blocks.push(Block { old: i..oi, new: j..nj });
+        }
+        (i, j) = (oi + 1, nj + 1);
+    }
+    blocks
+}
+
+/// Blocks grouped into hunks: those whose context would touch or overlap.
+fn hunks(blocks: &[Block]) -> impl Iterator<Item = &[Block]> {
+    let mut rest = blocks;
+    std::iter::from_fn(move || {
+        if rest.is_empty() {
+            return None;
+        }
+        let len = 1 + rest.windows(2).take_while(|w| w[1].old.start - w[0].old.end <= 2 * CONTEXT).count();
+        let (hunk, tail) = rest.split_at(len);
+        rest = tail;
+        Some(hunk)
+    })
+}
+
+/// `-start,count` / `+start,count` of a hunk header, as `diff -u` writes it.
+fn header_range(range: &Range<usize>) -> String {
+    match range.len() {
+        0 => format!("{},0", range.start),
+        1 => format!("{}", range.start + 1),
+        n => format!("{},{}", range.start + 1, n),
+    }
+}
+
+/// Words, runs of whitespace and single other characters, in order.
+pub fn tokens(line: &str) -> Vec<&str> {
+    let class = |c: char| {
+        if c.is_alphanumeric() || c == '_' {
+            0
+        } else if c.is_whitespace() {
+            1
+        } else {
+            2
+        }
+    };
+    let mut tokens = Vec::new();
+    let mut start = 0;
+    let mut chars = line.char_indices().peekable();
+    while let Some((at, c)) = chars.next() {
+        let kind = class(c);
+        let continues = chars.peek().map_or(false, |&(_, next)| kind != 2 && class(next) == kind);
+        if !continues {
+            tokens.push(&line[start..at + c.len_utf8()]);
+            start = at + c.len_utf8();
+        }
+    }
+    tokens
+}
+
+/// Byte ranges of `old` and `new` outside the tokens they share. Both are
+/// empty when the lines share too little for emphasis to help, as when a
+/// line is rewritten outright.
+pub fn word_diff(old: &str, new: &str) -> (Vec<Range<usize>>, Vec<Range<usize>>) {
+    let (a, b) = (tokens(old), tokens(new));
+    let pairs = diff::matches(&a, &b);
+    let common: usize = pairs.iter().map(|&(i, _)| a[i].len()).sum();
+    let longer = old.len().max(new.len());
+    if common * 2 < longer {
+        return (Vec::new(), Vec::new());
+    }
+
+    let unmatched = |tokens: &[&str], matched: &mut dyn Iterator<Item = usize>| {
+        let mut matched = matched.peekable();
+        let mut ranges: Vec<Range<usize>> = Vec::new();
+        let mut at = 0;
+        for (i, token) in tokens.iter().enumerate() {
+            let range = at..at + token.len();
+            at = range.end;
+            if matched.next_if_eq(&i).is_some() {
+                continue;
+            }
+            match ranges.last_mut() {
+                Some(last) if last.end == range.start => last.end = range.end,
+                _ => ranges.push(range),
+            }
+        }
+        ranges
+    };
+    (
+        unmatched(&a, &mut pairs.iter().map(|&(i, _)| i)),
+        unmatched(&b, &mut pairs.iter().map(|&(_, j)| j)),
+    )
+}
+
+/// Prints highlighted diff lines with emphasized words.
+struct Painter<'a> {
+    ss: &'static SyntaxSet,
+    ts: ThemeSet,
+    // Switched per file while hunks of the last one may still be held
+    syntax: Cell<&'static SyntaxReference>,
+    theme: &'a Theme,
+    out: &'a Output,
+}
+
+impl<'a> Painter<'a> {
+    fn new(lang: &str, theme: &'a Theme, out: &'a Output) -> Self {
+        let ss = code::syntax_set();
+        Painter {
+            ss,
+            ts: ThemeSet::load_defaults(),
+            syntax: Cell::new(code::find_syntax(ss, lang)),
+            theme,
+            out,
+        }
+    }
+
+    fn set_lang(&self, lang: &str) {
+        self.syntax.set(code::find_syntax(self.ss, lang));
+    }
+
+    /// A highlighter for one side of one hunk; hunks are highlighted on
+    /// their own, so unchanged stretches are never parsed.
+    fn highlighter(&self) -> HighlightLines<'_> {
+        HighlightLines::new(self.syntax.get(), code::highlight_theme(&self.ts, self.theme))
+    }
+
+    fn print_hunk(&self, hunk: &[Block], old_lines: &[&str], new_lines: &[&str]) {
+        let (first, last) = (&hunk[0], &hunk[hunk.len() - 1]);
+        let before = first.old.start.min(CONTEXT);
+        let after = (old_lines.len() - last.old.end).min(CONTEXT);
+        let old = first.old.start - before..last.old.end + after;
+        let new = first.new.start - before..last.new.end + after;
+        self.out.dim(
+            &format!("@@ -{} +{} @@", header_range(&old), header_range(&new)),
+            self.theme.line_number,
+        );
+        println!();
+
+        let (mut old_h, mut new_h) = (self.highlighter(), self.highlighter());
+        let mut i = old.start;
+        let mut j = new.start;
+        for block in hunk.iter().chain([&Block { old: old.end..old.end, new: new.end..new.end }]) {
+            while i < block.old.start {
+                self.line(&mut old_h, ' ', old_lines[i], &[], false);
+                self.print(&mut new_h, ' ', new_lines[j], &[]);
+                i += 1;
+                j += 1;
+            }
+            self.print_block(&mut old_h, &mut new_h, &old_lines[block.old.clone()], &new_lines[block.new.clone()]);
+            (i, j) = (block.old.end, block.new.end);
+        }
+    }
+
+    /// Print removed lines, then added ones, pairing them off in order for
+    /// word emphasis.
+    fn print_block<S: AsRef<str>>(&self, old_h: &mut HighlightLines, new_h: &mut HighlightLines, removed: &[S], added: &[S]) {
+        let pairs: Vec<_> = removed.iter().zip(added).map(|(o, n)| word_diff(o.as_ref(), n.as_ref())).collect();
+        for (k, line) in removed.iter().enumerate() {
+            self.print(old_h, '-', line.as_ref(), pairs.get(k).map_or(&[], |p| &p.0));
+        }
+        for (k, line) in added.iter().enumerate() {
+            self.print(new_h, '+', line.as_ref(), pairs.get(k).map_or(&[], |p| &p.1));
+        }
+    }
+
+    /// Print one diff line: `sign`, then `line` highlighted, with the byte
+    /// ranges in `emphasis` set off.
+    fn print(&self, h: &mut HighlightLines, sign: char, line: &str, emphasis: &[Range<usize>]) {
+        self.line(h, sign, line, emphasis, true);
+    }
+
+    /// Feed `line` through `h`, printing it when `show` is set; unprinted
+    /// lines keep the highlighter's state in step.
+    fn line(&self, h: &mut HighlightLines, sign: char, line: &str, emphasis: &[Range<usize>], show: bool) {
+        let (theme, out) = (self.theme, self.out);
+        let text = line.strip_suffix('\n').unwrap_or(line);
+        let with_newline = format!("{}\n", text);
+        let ranges = h.highlight_line(&with_newline, self.ss);
+        if !show {
+            return;
+        }
+
+        let sign_color = match sign {
+            '+' => theme.diff_added,
+            '-' => theme.diff_deleted,
+            _ => theme.line_number,
+        };
+        out.colored(&sign.to_string(), sign_color);
+
+        let ranges: Vec<(Option<Style>, &str)> = match ranges {
+            Ok(ranges) => ranges.into_iter().map(|(style, piece)| (Some(style), piece)).collect(),
+            Err(_) => vec![(None, text)],
+        };
+        let mut at = 0;
+        for (style, piece) in ranges {
+            let piece = &piece[..piece.len().min(text.len().saturating_sub(at))];
+            let end = at + piece.len();
+            // Split the piece where emphasis starts or ends
+            let mut cuts: Vec<usize> = emphasis
+                .iter()
+                .flat_map(|r| [r.start, r.end])
+                .filter(|&c| c > at && c < end)
+                .collect();
+            cuts.push(end);
+            let mut from = at;
+            for cut in cuts {
+                let part = &text[from..cut];
+                if emphasis.iter().any(|r| r.contains(&from)) {
+                    out.colored_bg(part, theme.grep_match_fg, sign_color);
+                } else if let Some(style) = style {
+                    code::print_ranges(&[(style, part)], out);
+                } else {
+                    print!("{}", part);
+                }
+                from = cut;
+            }
+            at = end;
+        }
+        println!();
+        if !line.ends_with('\n') {
+            out.dim("\\ No newline at end of file", theme.line_number);
+            println!();
+        }
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_blocks_and_hunks() {
+        // Old lines 0..20; 2 replaced, 5 removed, 19 replaced
+        let pairs: Vec<_> = (0..20)
+            .filter(|&i| i != 2 && i != 5 && i != 19)
+            .map(|i| (i, if i < 5 { i } else { i - 1 }))
+            .collect();
+        let blocks = blocks(&pairs, 20, 19);
+        assert_eq!(
+            blocks,
+            [
+                Block { old: 2..3, new: 2..3 },
+                Block { old: 5..6, new: 5..5 },
+                Block { old: 19..20, new: 18..19 },
+            ]
+        );
+        let grouped: Vec<usize> = hunks(&blocks).map(|h| h.len()).collect();
+        assert_eq!(grouped, [2, 1]);
+
+        assert_eq!(header_range(&(0..0)), "0,0");
+        assert_eq!(header_range(&(4..5)), "5");
+        assert_eq!(header_range(&(4..9)), "5,5");
+    }
+
+    #[test]
+    fn test_hunk_header() {
+        assert_eq!(hunk_header("@@ -3,7 +3,8 @@ fn main() {"), Some(("@@ -3,7 +3,8 @@", (7, 8))));
+        assert_eq!(hunk_header("@@ -1 +0,0 @@"), Some(("@@ -1 +0,0 @@", (1, 0))));
+        assert_eq!(hunk_header("@@@ -1,2 -1,2 +1,3 @@@"), None);
+        assert_eq!(header_path("b/src/a b.rs\t2024-01-01 10:00"), "b/src/a b.rs");
+        assert_eq!(header_path("\"b/x.rs\""), "b/x.rs");
+    }
+
+    #[test]
+    fn test_word_diff() {
+        assert_eq!(tokens("let x_1 = f(a);"), ["let", " ", "x_1", " ", "=", " ", "f", "(", "a", ")", ";"]);
+        let old = "    let total = price * count;";
+        let new = "    let total = price * quantity + tax;";
+        assert_eq!(word_diff(old, new), (vec![24..29], vec![24..38]));
+        // Too different to emphasize
+        assert_eq!(word_diff("return a;", "while true { spin(); }"), (vec![], vec![]));
+    }
+}
@@ -0,0 +1,179 @@
+//! Depth-limited folding shared by the JSON, YAML and TOML renderers
+//!
+//! Subtrees deeper than `--depth N` collapse into one-line summaries such as
+//! `{…} (214 keys)` or `[…] (10,233 items)`. Collapsed JSON subtrees are
+//! skipped by the structural scanner, counting brackets without formatting,
+//! so the work done is proportional to what is actually shown.
+
+use crate::structural::{is_delimiter, skip_container, skip_string, skip_whitespace};
+
+/// Kind of collapsed subtree, decides the bracket glyphs and the noun.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Fold {
+    Object,
+    Array,
+    Lines,
+}
+
+/// One-line summary for a collapsed subtree, e.g. `{…} (3 keys)`.
+pub fn summary(kind: Fold, count: usize) -> String {
+    let glyph = match kind {
+        Fold::Object => "{…}",
+        Fold::Array => "[…]",
+        Fold::Lines => "…",
+    };
+    format!("{} ({})", glyph, count_label(kind, count))
+}
+
+/// Child count with its noun, e.g. `3 keys`, `1 item`, `10,233 lines`.
+pub fn count_label(kind: Fold, count: usize) -> String {
+    let noun = match kind {
+        Fold::Object => "key",
+        Fold::Array => "item",
+        Fold::Lines => "line",
+    };
+    let plural = if count == 1 { "" } else { "s" };
+    format!("{} {}{}", group_thousands(count), noun, plural)
+}
+
+/// Format a count with `,` thousands separators: 10233 → "10,233".
+pub fn group_thousands(n: usize) -> String {
+    let digits = n.to_string();
+    let mut grouped = String::with_capacity(digits.len() + digits.len() / 3);
+    for (i, ch) in digits.chars().enumerate() {
+        if i > 0 && (digits.len() - i) % 3 == 0 {
+            grouped.push(',');
+        }
+        grouped.push(ch);
+    }
+    grouped
+}
+
+// ─── JSON ───
+
+/// Pretty-print `json` with two-space indentation, collapsing every container
+/// nested deeper than `max_depth` into a summary. The root container is depth 1,
+/// so `max_depth == 0` collapses the whole document.
+///
+/// Works on malformed input too: tokens are copied through as-is.
+pub fn fold_json(json: &str, max_depth: usize) -> String {
+    let bytes = json.as_bytes();
+    let mut out = String::with_capacity(json.len().min(1 << 16));
+    let mut depth = 0usize;
+    let mut i = 0;
+
+    while i < bytes.len() {
+        match bytes[i] {
+            b'{' | b'[' => {
+                if depth >= max_depth {
+                    let (end, count) = skip_container(bytes, i);
+                    if count == 0 {
+                        out.push_str(if bytes[i] == b'{' { "{}" } else { "[]" });
+                    } else {
+                        let kind = if bytes[i] == b'{' { Fold::Object } else { Fold::Array };
+                        out.push_str(&summary(kind, count));
+                    }
+                    i = end;
+                    continue;
+                }
+                let close = if bytes[i] == b'{' { b'}' } else { b']' };
+                let next = skip_whitespace(bytes, i + 1);
+                if bytes.get(next) == Some(&close) {
+                    out.push_str(&json[i..i + 1]);
+                    out.push_str(&json[next..next + 1]);
+                    i = next + 1;
+                    continue;
+                }
+                out.push_str(&json[i..i + 1]);
+                depth += 1;
+                newline_indent(&mut out, depth);
+                i += 1;
+            }
+            b'}' | b']' => {
+                depth = depth.saturating_sub(1);
+                newline_indent(&mut out, depth);
+                out.push_str(&json[i..i + 1]);
+                i += 1;
+            }
+            b',' => {
+                out.push(',');
+                newline_indent(&mut out, depth);
+                i += 1;
+            }
+            b':' => {
+                out.push_str(": ");
+                i += 1;
+            }
+            b'"' => {
+                let end = skip_string(bytes, i);
+                out.push_str(&json[i..end]);
+                i = end;
+            }
+            b if b.is_ascii_whitespace() => i += 1,
+            _ => {
+                let start = i;
+                while i < bytes.len() && !is_delimiter(bytes[i]) {
+                    i += 1;
+                }
+                out.push_str(&json[start..i]);
+            }
+        }
+    }
+
+    out.push('\n');
+    out
+}
+
+fn newline_indent(out: &mut String, depth: usize) {
+    out.push('\n');
+    for _ in 0..depth {
+        out.push_str("  ");
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_group_thousands() {
+        assert_eq!(group_thousands(0), "0");
+        assert_eq!(group_thousands(999), "999");
+        assert_eq!(group_thousands(1000), "1,000");
+        assert_eq!(group_thousands(10233), "10,233");
+        assert_eq!(group_thousands(1234567), "1,234,567");
+    }
+
+    #[test]
+    fn test_summary() {
+        assert_eq!(summary(Fold::Object, 214), "{…} (214 keys)");
+        assert_eq!(summary(Fold::Array, 10233), "[…] (10,233 items)");
+        assert_eq!(summary(Fold::Object, 1), "{…} (1 key)");
+        assert_eq!(summary(Fold::Lines, 2), "… (2 lines)");
+    }
+
+    #[test]
+    fn test_fold_json_depth_one() {
+        let json = r#"{"name":"vita","tags":["a","b"],"deps":{"x":1,"y":2},"empty":[]}"#;
+        let folded = fold_json(json, 1);
+        assert_eq!(
+            folded,
+            "{\n  \"name\": \"vita\",\n  \"tags\": […] (2 items),\n  \"deps\": {…} (2 keys),\n  \"empty\": []\n}\n"
+        );
+    }
+
+    #[test]
+    fn test_fold_json_matches_pretty_when_deep_enough() {
+        let json = r#"{"a":{"b":[1,{"c":null}]},"d":[]}"#;
+        let value: serde_json::Value = serde_json::from_str(json).unwrap();
+        let pretty = serde_json::to_string_pretty(&value).unwrap();
+        assert_eq!(fold_json(json, 10), format!("{}\n", pretty));
+    }
+
+    #[test]
+    fn test_fold_json_depth_zero() {
+        assert_eq!(fold_json("[1, 2, 3]", 0), "[…] (3 items)\n");
+    }
+}
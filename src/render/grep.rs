@@ -1,29 +1,248 @@
+use memchr::memmem;
+use syntect::parsing::{ParseState, Scope, ScopeStack, ScopeStackOp};
+use syntect::util::LinesWithEndings;
+
+use crate::detect::FileFormat;
 use crate::output::Output;
+use crate::render::code::{find_syntax, syntax_name, syntax_set};
 use crate::theme::Theme;
 
+/// Where a `--grep-in` match must lie
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Region {
+    Code,
+    Comment,
+    String,
+}
+
+impl Region {
+    pub fn parse(source: &str) -> Result<Region, String> {
+        match source {
+            "code" => Ok(Region::Code),
+            "comment" | "comments" => Ok(Region::Comment),
+            "string" | "strings" => Ok(Region::String),
+            _ => Err(format!("expected code, comment or string, got '{}'", source)),
+        }
+    }
+}
+
 pub fn render(content: &str, pattern: &str, theme: &Theme, out: &Output) {
-    let lines: Vec<&str> = content.lines().collect();
-    let line_count = lines.len();
-    let num_width = format!("{}", line_count).len();
+    print_hits(content, pattern, hits(content, pattern, |_, _, _| true), theme, out);
+}
+
+/// Like `render`, but keeps only the matches whose first byte lies in
+/// `region` according to the syntect scopes of `format`.
+pub fn render_in(content: &str, pattern: &str, format: &FileFormat, region: Region, theme: &Theme, out: &Output) {
+    if let Some(hits) = region_hits(content, pattern, format, region) {
+        print_hits(content, pattern, hits, theme, out);
+    }
+}
 
-    for (i, line) in lines.iter().enumerate() {
-        if !line.contains(pattern) {
-            continue;
+/// The hits of `pattern` lying in `region`, or None when the file has no
+/// hit at all.
+///
+/// The file is searched for the literal first, and only a file with a hit
+/// is parsed, and only up to its last matching line. Parsing is scopes
+/// only, with no theme styling.
+fn region_hits<'a>(
+    content: &'a str,
+    pattern: &'a str,
+    format: &FileFormat,
+    region: Region,
+) -> Option<impl Iterator<Item = (usize, &'a str, Vec<usize>)> + 'a> {
+    if pattern.is_empty() || memmem::find(content.as_bytes(), pattern.as_bytes()).is_none() {
+        return None;
+    }
+    let mut classifier = Classifier::new(content, format);
+    Some(hits(content, pattern, move |line_idx, _, pos| {
+        classifier.region_at(line_idx, pos) == region
+    }))
+}
+
+/// The lines of `content` with a match of `pattern` accepted by
+/// `keep(line index, line, byte offset)`, with the accepted offsets.
+/// `keep` is called in line order.
+fn hits<'a>(
+    content: &'a str,
+    pattern: &'a str,
+    mut keep: impl FnMut(usize, &str, usize) -> bool + 'a,
+) -> impl Iterator<Item = (usize, &'a str, Vec<usize>)> + 'a {
+    let finder = memmem::Finder::new(pattern);
+    content.lines().enumerate().filter_map(move |(i, line)| {
+        let found: Vec<usize> = if pattern.is_empty() {
+            vec![0]
+        } else {
+            finder.find_iter(line.as_bytes()).collect()
+        };
+        let mut shown = Vec::with_capacity(found.len());
+        // Non-overlapping, like `str::find` from the end of the last match
+        let mut next = 0;
+        for pos in found {
+            if pos >= next && keep(i, line, pos) {
+                shown.push(pos);
+                next = pos + pattern.len();
+            }
         }
+        (!shown.is_empty()).then_some((i, line, shown))
+    })
+}
+
+/// Print matching lines with their numbers, highlighting the matches.
+fn print_hits<'a>(
+    content: &str,
+    pattern: &str,
+    hits: impl Iterator<Item = (usize, &'a str, Vec<usize>)>,
+    theme: &Theme,
+    out: &Output,
+) {
+    let num_width = format!("{}", content.lines().count()).len();
 
+    for (i, line, shown) in hits {
         out.dim(&format!(" {:>width$} │ ", i + 1, width = num_width), theme.line_number);
 
-        let mut rest = *line;
-        while let Some(pos) = rest.find(pattern) {
-            if pos > 0 {
-                out.colored(&rest[..pos], theme.text);
+        let mut last = 0;
+        for pos in shown {
+            if pos > last {
+                out.colored(&line[last..pos], theme.text);
             }
             out.colored_bg(pattern, theme.grep_match_fg, theme.grep_match_bg);
-            rest = &rest[pos + pattern.len()..];
+            last = pos + pattern.len();
         }
-        if !rest.is_empty() {
-            out.colored(rest, theme.text);
+        if last < line.len() {
+            out.colored(&line[last..], theme.text);
         }
         println!();
     }
 }
+
+/// Scope-based region lookup that advances a syntect parse lazily, line
+/// by line, as later positions are asked for.
+struct Classifier<'a> {
+    state: Option<ParseState>,
+    lines: LinesWithEndings<'a>,
+    /// Index of the next line to parse
+    next_line: usize,
+    /// Scope stack at the start of the line at `current`
+    stack: ScopeStack,
+    /// The parsed line the cached ops belong to, with the stack at its start
+    current: Option<(usize, ScopeStack, Vec<(usize, ScopeStackOp)>)>,
+    comment: Scope,
+    string: Scope,
+}
+
+impl<'a> Classifier<'a> {
+    fn new(content: &'a str, format: &FileFormat) -> Self {
+        let state = syntax_name(format)
+            .map(|lang| find_syntax(syntax_set(), lang))
+            .filter(|syntax| syntax.name != "Plain Text")
+            .map(ParseState::new);
+        Classifier {
+            state,
+            lines: LinesWithEndings::from(content),
+            next_line: 0,
+            stack: ScopeStack::new(),
+            current: None,
+            comment: Scope::new("comment").expect("valid scope"),
+            string: Scope::new("string").expect("valid scope"),
+        }
+    }
+
+    /// Region of the byte at `pos` in line `line_idx`. Lines must be asked
+    /// for in ascending order.
+    fn region_at(&mut self, line_idx: usize, pos: usize) -> Region {
+        let Some(state) = self.state.as_mut() else {
+            // No grammar: everything is code
+            return Region::Code;
+        };
+
+        if self.current.as_ref().map(|c| c.0) != Some(line_idx) {
+            // Parse forward, applying whole lines, until `line_idx` is next
+            if let Some((_, start, ops)) = self.current.take() {
+                self.stack = start;
+                apply(&mut self.stack, &ops, usize::MAX);
+            }
+            loop {
+                let Some(text) = self.lines.next() else {
+                    return Region::Code;
+                };
+                let index = self.next_line;
+                self.next_line += 1;
+                let ops = match state.parse_line(text, syntax_set()) {
+                    Ok(ops) => ops,
+                    Err(_) => {
+                        // A broken grammar: stop classifying
+                        self.state = None;
+                        return Region::Code;
+                    }
+                };
+                if index == line_idx {
+                    self.current = Some((index, self.stack.clone(), ops));
+                    break;
+                }
+                apply(&mut self.stack, &ops, usize::MAX);
+            }
+        }
+
+        let (_, start, ops) = self.current.as_ref().expect("line parsed above");
+        let mut stack = start.clone();
+        // Ops at `pos` take effect before the character there
+        apply(&mut stack, ops, pos + 1);
+        let scopes = stack.as_slice();
+        if scopes.iter().any(|s| self.comment.is_prefix_of(*s)) {
+            Region::Comment
+        } else if scopes.iter().any(|s| self.string.is_prefix_of(*s)) {
+            Region::String
+        } else {
+            Region::Code
+        }
+    }
+}
+
+/// Apply the ops positioned before byte `end`.
+fn apply(stack: &mut ScopeStack, ops: &[(usize, ScopeStackOp)], end: usize) {
+    for (at, op) in ops {
+        if *at >= end {
+            break;
+        }
+        let _ = stack.apply(op);
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_region_parse() {
+        assert_eq!(Region::parse("code"), Ok(Region::Code));
+        assert_eq!(Region::parse("comments"), Ok(Region::Comment));
+        assert_eq!(Region::parse("string"), Ok(Region::String));
+        assert!(Region::parse("docs").is_err());
+    }
+
+    fn region_matches(content: &str, pattern: &str, region: Region) -> Option<Vec<(usize, usize)>> {
+        let format = FileFormat::Code("Rust".to_string());
+        let hits = region_hits(content, pattern, &format, region)?;
+        Some(hits.flat_map(|(i, _, shown)| shown.into_iter().map(move |pos| (i, pos))).collect())
+    }
+
+    #[test]
+    fn test_region_selects_own_hit() {
+        let src = "fn main() {\n    let needle = 1; // a needle\n    let s = \"needle\";\n}\n";
+        assert_eq!(region_matches(src, "needle", Region::Code), Some(vec![(1, 8)]));
+        assert_eq!(region_matches(src, "needle", Region::Comment), Some(vec![(1, 25)]));
+        assert_eq!(region_matches(src, "needle", Region::String), Some(vec![(2, 13)]));
+    }
+
+    #[test]
+    fn test_region_prefilter_without_hit() {
+        let src = "fn main() {\n    // nothing to see\n}\n";
+        // No literal hit: the file is never parsed
+        assert_eq!(region_matches(src, "needle", Region::Comment), None);
+        assert_eq!(region_matches(src, "", Region::Code), None);
+        // A hit outside the region parses but keeps nothing
+        assert_eq!(region_matches(src, "nothing", Region::String), Some(vec![]));
+    }
+}
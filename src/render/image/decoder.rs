@@ -4,16 +4,27 @@
 //! Handles:
 //! - Loading from file or memory
 //! - Format detection and decoding
-//! - Smart resizing with aspect ratio correction
+//! - JPEG decoding at reduced scale when the display is much smaller
+//! - Scanline decoding of large PNG/PNM/BMP/QOI straight to a shrunk image
+//! - Smart resizing with aspect ratio correction (box prefilter, then Lanczos)
 //! - Alpha compositing against terminal background
 //! - Animated image handling (first frame)
 
-use image::{DynamicImage, GenericImageView, ImageFormat, Rgba, RgbaImage};
+use image::codecs::jpeg::JpegDecoder;
+use image::{DynamicImage, GenericImageView, ImageDecoder, ImageFormat, RgbaImage};
+use std::io::Read;
 use std::path::Path;
 
+use super::scale;
+use super::stream;
+
+/// Images smaller than this decode whole; the scanline path only pays off
+/// once the full RGBA buffer would be large.
+const STREAM_MIN_BYTES: u64 = 4 << 20;
+
 pub struct DecodedImage {
-    /// RGBA pixel data, row-major
-    pub pixels: Vec<Pixel>,
+    /// RGBA8 pixel data, row-major
+    pub rgba: Vec<u8>,
     pub display_width: u32,
     pub display_height: u32, // always even (for half-block pairs)
     pub original_width: u32,
@@ -29,7 +40,7 @@ pub struct Pixel {
 }
 
 impl Pixel {
-    pub fn from_rgba(rgba: &Rgba<u8>) -> Self {
+    pub fn from_rgba(rgba: &[u8]) -> Self {
         Self {
             r: rgba[0],
             g: rgba[1],
@@ -55,34 +66,52 @@ impl Pixel {
             };
         }
 
-        let alpha = self.a as f32 / 255.0;
-        let inv = 1.0 - alpha;
-
         Pixel {
-            r: (self.r as f32 * alpha + bg_r as f32 * inv) as u8,
-            g: (self.g as f32 * alpha + bg_g as f32 * inv) as u8,
-            b: (self.b as f32 * alpha + bg_b as f32 * inv) as u8,
+            r: blend(self.r, bg_r, self.a),
+            g: blend(self.g, bg_g, self.a),
+            b: blend(self.b, bg_b, self.a),
             a: 255,
         }
     }
 }
 
+/// `c` at alpha `a` over `bg`. The shifts divide by 255, rounded, which
+/// holds for every sum up to 255².
+#[inline]
+fn blend(c: u8, bg: u8, a: u8) -> u8 {
+    let x = c as u32 * a as u32 + bg as u32 * (255 - a as u32) + 128;
+    ((x + (x >> 8)) >> 8) as u8
+}
+
 impl DecodedImage {
-    pub fn get_pixel(&self, x: u32, y: u32) -> Pixel {
-        if x < self.display_width && y < self.display_height {
-            self.pixels[(y * self.display_width + x) as usize]
-        } else {
-            Pixel {
-                r: 0,
-                g: 0,
-                b: 0,
-                a: 0,
-            }
-        }
+    /// Row `y` as RGBA8 bytes.
+    pub fn row(&self, y: u32) -> &[u8] {
+        let stride = self.display_width as usize * 4;
+        &self.rgba[y as usize * stride..][..stride]
     }
 }
 
 pub fn load_and_prepare(path: &Path, max_width: u32, term_width: u16) -> Result<DecodedImage, String> {
+    if format_from_path(path) == Some(ImageFormat::Jpeg) {
+        let scaled = std::fs::File::open(path)
+            .map_err(image::ImageError::IoError)
+            .and_then(|f| decode_jpeg_scaled(std::io::BufReader::new(f), max_width, term_width));
+        // Anything unusual goes the general way, which reports errors
+        if let Ok((img, original)) = scaled {
+            return prepare_image(img.into_rgba8(), original, max_width, term_width);
+        }
+    }
+
+    if let Ok(file) = std::fs::File::open(path) {
+        let len = file.metadata().map(|m| m.len()).unwrap_or(0);
+        let display = |w, h| calculate_display_size(w, h, max_width, term_width);
+        if len >= STREAM_MIN_BYTES {
+            if let Some(shrunk) = stream::decode(std::io::BufReader::new(file), len, display) {
+                return prepare_shrunk(shrunk?, max_width, term_width);
+            }
+        }
+    }
+
     let img = if let Some(fmt) = format_from_path(path) {
         image::open(path)
             .or_else(|_| {
@@ -94,10 +123,24 @@ pub fn load_and_prepare(path: &Path, max_width: u32, term_width: u16) -> Result<
         image::open(path).map_err(|e| format!("{}", e))?
     };
 
-    prepare_image(img, max_width, term_width)
+    let original = img.dimensions();
+    prepare_image(img.into_rgba8(), original, max_width, term_width)
 }
 
 pub fn load_from_memory(data: &[u8], max_width: u32, term_width: u16) -> Result<DecodedImage, String> {
+    if let Ok(ImageFormat::Jpeg) = image::guess_format(data) {
+        if let Ok((img, original)) = decode_jpeg_scaled(data, max_width, term_width) {
+            return prepare_image(img.into_rgba8(), original, max_width, term_width);
+        }
+    }
+
+    let display = |w, h| calculate_display_size(w, h, max_width, term_width);
+    if data.len() as u64 >= STREAM_MIN_BYTES {
+        if let Some(shrunk) = stream::decode(data, data.len() as u64, display) {
+            return prepare_shrunk(shrunk?, max_width, term_width);
+        }
+    }
+
     let img = if let Ok(fmt) = image::guess_format(data) {
         image::load_from_memory_with_format(data, fmt)
     } else {
@@ -105,23 +148,49 @@ pub fn load_from_memory(data: &[u8], max_width: u32, term_width: u16) -> Result<
     }
     .map_err(|e| format!("{}", e))?;
 
-    prepare_image(img, max_width, term_width)
+    let original = img.dimensions();
+    prepare_image(img.into_rgba8(), original, max_width, term_width)
 }
 
-fn prepare_image(img: DynamicImage, max_width: u32, term_width: u16) -> Result<DecodedImage, String> {
-    let (orig_w, orig_h) = img.dimensions();
+/// Decode a JPEG at the smallest DCT scale (1/8, 1/4, 1/2 or full) that
+/// still leaves twice the display size, skipping most of the IDCT work for
+/// large photos. Returns the image with the original dimensions.
+fn decode_jpeg_scaled<R: Read>(
+    reader: R,
+    max_width: u32,
+    term_width: u16,
+) -> image::ImageResult<(DynamicImage, (u32, u32))> {
+    let mut decoder = JpegDecoder::new(reader)?;
+    let (orig_w, orig_h) = decoder.dimensions();
     let (disp_w, disp_h) = calculate_display_size(orig_w, orig_h, max_width, term_width);
+    let want = |n: u32| (n * 2).min(u16::MAX as u32) as u16;
+    decoder.scale(want(disp_w), want(disp_h))?;
+    Ok((DynamicImage::from_decoder(decoder)?, (orig_w, orig_h)))
+}
 
-    let rgba: RgbaImage = if disp_w != orig_w || disp_h != orig_h {
-        image::imageops::resize(&img.to_rgba8(), disp_w, disp_h, image::imageops::FilterType::Lanczos3)
-    } else {
-        img.to_rgba8()
-    };
+fn prepare_shrunk(shrunk: stream::Shrunk, max_width: u32, term_width: u16) -> Result<DecodedImage, String> {
+    let rgba = RgbaImage::from_raw(shrunk.width, shrunk.height, shrunk.rgba).ok_or("image buffer size mismatch")?;
+    prepare_image(rgba, shrunk.original, max_width, term_width)
+}
+
+/// Bring `rgba` (possibly already reduced from an `original`-sized
+/// source) to display size.
+fn prepare_image(mut rgba: RgbaImage, original: (u32, u32), max_width: u32, term_width: u16) -> Result<DecodedImage, String> {
+    let (orig_w, orig_h) = original;
+    let (disp_w, disp_h) = calculate_display_size(orig_w, orig_h, max_width, term_width);
 
-    let pixels: Vec<Pixel> = rgba.pixels().map(|p| Pixel::from_rgba(p)).collect();
+    let (w, h) = (rgba.width(), rgba.height());
+    let factor = scale::prefilter_factor(w, h, disp_w, disp_h);
+    if factor > 1 {
+        let (buf, w, h) = scale::box_shrink(rgba.as_raw(), w, h, factor);
+        rgba = RgbaImage::from_raw(w, h, buf).ok_or("image buffer size mismatch")?;
+    }
+    if rgba.width() != disp_w || rgba.height() != disp_h {
+        rgba = image::imageops::resize(&rgba, disp_w, disp_h, image::imageops::FilterType::Lanczos3);
+    }
 
     Ok(DecodedImage {
-        pixels,
+        rgba: rgba.into_raw(),
         display_width: disp_w,
         display_height: disp_h,
         original_width: orig_w,
@@ -217,6 +286,18 @@ mod tests {
         assert_eq!(result.a, 255);
     }
 
+    #[test]
+    fn test_blend_rounds_exactly() {
+        for bg in [0u32, 26, 46, 255] {
+            for a in 0..=255u32 {
+                for c in 0..=255u32 {
+                    let exact = ((c * a + bg * (255 - a)) as f64 / 255.0).round() as u8;
+                    assert_eq!(blend(c as u8, bg as u8, a as u8), exact);
+                }
+            }
+        }
+    }
+
     #[test]
     fn test_pixel_transparent() {
         let px = Pixel { r: 255, g: 0, b: 0, a: 0 };
@@ -6,10 +6,14 @@
 //! Architecture:
 //!   mod.rs      - Public API, format support
 //!   decoder.rs  - Loading, resizing, preprocessing
+//!   scale.rs    - Fast block-average downscaling
+//!   stream.rs   - Row-streaming decode of large images
 //!   renderer.rs - Half-block terminal rendering
 
 mod decoder;
 mod renderer;
+mod scale;
+mod stream;
 
 use std::path::Path;
 
@@ -83,7 +87,9 @@ pub fn is_image_magic(buf: &[u8]) -> bool {
     false
 }
 
-pub fn render(path: &Path, max_width: u32, theme: &Theme, out: &Output) {
+/// Show an image, reusing a cell's color for the next when every channel is
+/// within `tolerance` of it.
+pub fn render(path: &Path, max_width: u32, tolerance: u8, theme: &Theme, out: &Output) {
     let decoded = match decoder::load_and_prepare(path, max_width, out.term_width) {
         Ok(img) => img,
         Err(e) => {
@@ -93,7 +99,7 @@ pub fn render(path: &Path, max_width: u32, theme: &Theme, out: &Output) {
     };
 
     println!();
-    renderer::render_halfblock(&decoded, out);
+    renderer::render_halfblock(&decoded, tolerance, out);
 
     let fmt_name = path
         .extension()
@@ -114,7 +120,7 @@ pub fn render(path: &Path, max_width: u32, theme: &Theme, out: &Output) {
     );
 }
 
-pub fn render_bytes(data: &[u8], max_width: u32, theme: &Theme, out: &Output) {
+pub fn render_bytes(data: &[u8], max_width: u32, tolerance: u8, theme: &Theme, out: &Output) {
     let decoded = match decoder::load_from_memory(data, max_width, out.term_width) {
         Ok(img) => img,
         Err(e) => {
@@ -124,7 +130,7 @@ pub fn render_bytes(data: &[u8], max_width: u32, theme: &Theme, out: &Output) {
     };
 
     println!();
-    renderer::render_halfblock(&decoded, out);
+    renderer::render_halfblock(&decoded, tolerance, out);
 
     out.dim(
         &format!(
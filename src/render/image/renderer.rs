@@ -9,7 +9,10 @@
 //! This gives 2x vertical resolution compared to a single character.
 //!
 //! Optimizations:
-//!   - Skips redundant ANSI escape codes when colors don't change
+//!   - Tracks the terminal's colors and emits only the SGR parameters that
+//!     change, in one sequence, flipping ▀/▄ when that matches them better
+//!   - Collapses runs of identical cells (CSI REP where the terminal has it)
+//!   - Optionally reuses colors within a tolerance to lengthen runs
 //!   - Handles transparency (composites against terminal background)
 //!   - Batches output for performance
 
@@ -21,87 +24,198 @@ const HALF_LOWER: &str = "▄";
 const RESET: &str = "\x1b[0m";
 const RESET_BG: &str = "\x1b[49m";
 
-#[allow(unused_assignments)]
-pub fn render_halfblock(img: &DecodedImage, _out: &Output) {
-    let mut buf = String::with_capacity(img.display_width as usize * 64);
-
-    // Skip redundant ANSI color codes when adjacent pixels match
-    let mut last_fg: Option<(u8, u8, u8)> = None;
-    let mut last_bg: Option<(u8, u8, u8)> = None;
+pub fn render_halfblock(img: &DecodedImage, tolerance: u8, out: &Output) {
+    let width = img.display_width as usize;
+    // Pipes, files and pagers don't expand REP
+    let mut writer = CellWriter::new(width, tolerance, out.use_colors && rep_supported());
+    let mut top_rgb = Vec::with_capacity(width);
+    let mut bot_rgb = Vec::with_capacity(width);
+    let clear_row = vec![0u8; width * 4];
 
     // Two rows per character cell (▀ = top fg, bottom bg)
     for y in (0..img.display_height).step_by(2) {
-        buf.clear();
-        buf.push_str("  ");
-        last_fg = None;
-        last_bg = None;
-
-        for x in 0..img.display_width {
-            let top = img.get_pixel(x, y);
-            let bot = if y + 1 < img.display_height {
-                img.get_pixel(x, y + 1)
-            } else {
-                Pixel {
-                    r: 0,
-                    g: 0,
-                    b: 0,
-                    a: 0,
-                }
+        let top_row = img.row(y);
+        let bot_row = if y + 1 < img.display_height { img.row(y + 1) } else { &clear_row };
+        composite_row(top_row, &mut top_rgb);
+        composite_row(bot_row, &mut bot_rgb);
+
+        writer.buf.push_str("  ");
+        let cells = top_row.chunks_exact(4).zip(bot_row.chunks_exact(4)).zip(top_rgb.iter().zip(&bot_rgb));
+        for ((top, bot), (&top_c, &bot_c)) in cells {
+            // Only one visible pixel is drawn as is, without compositing
+            let cell = match (top[3] < 128, bot[3] < 128) {
+                (true, true) => Cell::Empty,
+                (true, false) => Cell::Lower([bot[0], bot[1], bot[2]]),
+                (false, true) => Cell::Upper([top[0], top[1], top[2]]),
+                (false, false) => Cell::Both(top_c, bot_c),
             };
+            writer.cell(cell);
+        }
+        writer.end_line();
+        print!("{}", writer.buf);
+        writer.buf.clear();
+    }
+    if writer.fg.is_some() {
+        print!("{}", RESET);
+    }
+}
 
-            let top_trans = top.is_transparent();
-            let bot_trans = bot.is_transparent();
-
-            if top_trans && bot_trans {
-                // Both transparent → space
-                buf.push_str(RESET);
-                buf.push(' ');
-                last_fg = None;
-                last_bg = None;
-            } else if top_trans {
-                // Only bottom visible → ▄ with fg=bottom
-                let fg = (bot.r, bot.g, bot.b);
-                if last_fg != Some(fg) {
-                    write_fg(&mut buf, bot.r, bot.g, bot.b);
-                    last_fg = Some(fg);
-                }
-                buf.push_str(RESET_BG);
-                last_bg = None;
-                buf.push_str(HALF_LOWER);
-            } else if bot_trans {
-                // Only top visible → ▀ with fg=top
-                let fg = (top.r, top.g, top.b);
-                if last_fg != Some(fg) {
-                    write_fg(&mut buf, top.r, top.g, top.b);
-                    last_fg = Some(fg);
+type Rgb = [u8; 3];
+
+/// What one character cell shows
+#[derive(Clone, Copy, Debug, PartialEq)]
+enum Cell {
+    Empty,
+    Upper(Rgb),
+    Lower(Rgb),
+    Both(Rgb, Rgb),
+}
+
+/// Writes cells knowing the colors the terminal is set to, so each costs
+/// only what changes. A run of cells needing no change is held and written
+/// as one glyph plus a repeat.
+struct CellWriter {
+    buf: String,
+    /// Current colors; `None` is the terminal default
+    fg: Option<Rgb>,
+    bg: Option<Rgb>,
+    tolerance: u8,
+    rep: bool,
+    glyph: &'static str,
+    run: usize,
+}
+
+impl CellWriter {
+    fn new(width: usize, tolerance: u8, rep: bool) -> Self {
+        CellWriter {
+            buf: String::with_capacity(width * 64),
+            fg: None,
+            bg: None,
+            tolerance,
+            rep,
+            glyph: "",
+            run: 0,
+        }
+    }
+
+    fn close(&self, a: Rgb, b: Rgb) -> bool {
+        a.iter().zip(b).all(|(x, y)| x.abs_diff(y) <= self.tolerance)
+    }
+
+    /// Whether the current color `now` already serves for `want`.
+    fn serves(&self, now: Option<Rgb>, want: Option<Rgb>) -> bool {
+        match (now, want) {
+            (Some(a), Some(b)) => self.close(a, b),
+            (None, None) => true,
+            _ => false,
+        }
+    }
+
+    fn cell(&mut self, cell: Cell) {
+        // The glyph and the colors it needs; a space doesn't care about fg
+        let (glyph, fg, bg) = match cell {
+            Cell::Empty => (" ", None, None),
+            Cell::Upper(c) => (HALF_UPPER, Some(c), None),
+            Cell::Lower(c) => (HALF_LOWER, Some(c), None),
+            Cell::Both(top, bot) if self.close(top, bot) => (" ", None, Some(bot)),
+            Cell::Both(top, bot) => {
+                // ▄ with the colors swapped looks the same
+                let kept = |fg, bg| self.serves(self.fg, Some(fg)) as u8 + self.serves(self.bg, Some(bg)) as u8;
+                if kept(bot, top) > kept(top, bot) {
+                    (HALF_LOWER, Some(bot), Some(top))
+                } else {
+                    (HALF_UPPER, Some(top), Some(bot))
                 }
-                buf.push_str(RESET_BG);
-                last_bg = None;
-                buf.push_str(HALF_UPPER);
-            } else {
-                // Both visible → ▀ with fg=top, bg=bottom
-                let top_c = composite_for_display(top);
-                let bot_c = composite_for_display(bot);
-
-                let fg = (top_c.r, top_c.g, top_c.b);
-                let bg = (bot_c.r, bot_c.g, bot_c.b);
-
-                if last_fg != Some(fg) {
-                    write_fg(&mut buf, top_c.r, top_c.g, top_c.b);
-                    last_fg = Some(fg);
+            }
+        };
+        let set_fg = fg.filter(|_| !self.serves(self.fg, fg));
+        let set_bg = !self.serves(self.bg, bg);
+        if set_fg.is_none() && !set_bg && glyph == self.glyph {
+            self.run += 1;
+            return;
+        }
+
+        self.flush_run();
+        if set_fg.is_some() || set_bg {
+            self.buf.push_str("\x1b[");
+            if let Some(c) = set_fg {
+                push_rgb(&mut self.buf, "38;2;", c);
+                self.fg = set_fg;
+            }
+            if set_bg {
+                if set_fg.is_some() {
+                    self.buf.push(';');
                 }
-                if last_bg != Some(bg) {
-                    write_bg(&mut buf, bot_c.r, bot_c.g, bot_c.b);
-                    last_bg = Some(bg);
+                match bg {
+                    Some(c) => push_rgb(&mut self.buf, "48;2;", c),
+                    None => self.buf.push_str("49"),
                 }
-                buf.push_str(HALF_UPPER);
+                self.bg = bg;
+            }
+            self.buf.push('m');
+        }
+        self.glyph = glyph;
+        self.run = 1;
+    }
+
+    /// Write the held run: the glyph, then REP for the rest when the
+    /// terminal has it and it's shorter.
+    fn flush_run(&mut self) {
+        if self.run == 0 {
+            return;
+        }
+        self.buf.push_str(self.glyph);
+        let more = self.run - 1;
+        let rep_len = 3 + more.to_string().len();
+        if self.rep && more * self.glyph.len() > rep_len {
+            use std::fmt::Write;
+            let _ = write!(self.buf, "\x1b[{}b", more);
+        } else {
+            for _ in 0..more {
+                self.buf.push_str(self.glyph);
             }
         }
+        self.run = 0;
+    }
+
+    /// Finish a line. The background must be default at the newline, or
+    /// terminals fill the new line with it; the foreground can carry over.
+    fn end_line(&mut self) {
+        self.flush_run();
+        self.glyph = "";
+        if self.bg.is_some() {
+            self.buf.push_str(RESET_BG);
+            self.bg = None;
+        }
+        self.buf.push('\n');
+    }
+}
 
-        buf.push_str(RESET);
-        buf.push('\n');
-        print!("{}", buf);
+/// Whether the terminal repeats the last character on CSI `b` (REP). There
+/// is no dependable query, so only terminals known to implement it get it.
+/// Inside screen or tmux the outer terminal's variables are inherited, but
+/// the multiplexer is what interprets the output.
+fn rep_supported() -> bool {
+    let var = |name| std::env::var(name).unwrap_or_default();
+    let term = var("TERM");
+    if term.starts_with("screen") || term.starts_with("tmux") {
+        return false;
     }
+    std::env::var_os("XTERM_VERSION").is_some()
+        || std::env::var_os("WT_SESSION").is_some()
+        || term == "xterm-kitty"
+        || term.starts_with("foot")
+        || var("TERM_PROGRAM") == "WezTerm"
+}
+
+/// A row of RGBA8 composited for display in one pass, ahead of the
+/// per-cell loop that decides what to emit.
+fn composite_row(row: &[u8], out: &mut Vec<[u8; 3]>) {
+    out.clear();
+    out.extend(row.chunks_exact(4).map(|p| {
+        let c = composite_for_display(Pixel::from_rgba(p));
+        [c.r, c.g, c.b]
+    }));
 }
 
 /// Composites against assumed terminal bg (#1a1a2e)
@@ -112,22 +226,69 @@ fn composite_for_display(px: Pixel) -> Pixel {
     px.composite_over(26, 26, 46)
 }
 
+/// `lead` then `r;g;b`, with the digits pushed directly rather than
+/// through the formatting machinery, which dominated the cell loop.
 #[inline]
-fn write_fg(buf: &mut String, r: u8, g: u8, b: u8) {
-    use std::fmt::Write;
-    let _ = write!(buf, "\x1b[38;2;{};{};{}m", r, g, b);
+fn push_rgb(buf: &mut String, lead: &str, [r, g, b]: Rgb) {
+    buf.push_str(lead);
+    push_u8(buf, r);
+    buf.push(';');
+    push_u8(buf, g);
+    buf.push(';');
+    push_u8(buf, b);
 }
 
 #[inline]
-fn write_bg(buf: &mut String, r: u8, g: u8, b: u8) {
-    use std::fmt::Write;
-    let _ = write!(buf, "\x1b[48;2;{};{};{}m", r, g, b);
+fn push_u8(buf: &mut String, v: u8) {
+    if v >= 100 {
+        buf.push((b'0' + v / 100) as char);
+    }
+    if v >= 10 {
+        buf.push((b'0' + v / 10 % 10) as char);
+    }
+    buf.push((b'0' + v % 10) as char);
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
 
+    fn written(cells: &[Cell], tolerance: u8, rep: bool) -> String {
+        let mut writer = CellWriter::new(8, tolerance, rep);
+        for &cell in cells {
+            writer.cell(cell);
+        }
+        writer.end_line();
+        writer.buf
+    }
+
+    #[test]
+    fn test_cell_writer_deltas() {
+        let (red, blue) = ([255, 0, 0], [0, 7, 255]);
+        // One sequence for both colors; the swapped pair reuses them via ▄
+        assert_eq!(
+            written(&[Cell::Both(red, blue), Cell::Both(blue, red)], 0, false),
+            "\x1b[38;2;255;0;0;48;2;0;7;255m▀▄\x1b[49m\n"
+        );
+        // Transparency only drops the background, keeping the foreground
+        assert_eq!(
+            written(&[Cell::Both(red, blue), Cell::Upper(red), Cell::Empty], 0, false),
+            "\x1b[38;2;255;0;0;48;2;0;7;255m▀\x1b[49m▀ \n"
+        );
+        // A solid cell is a space on the background color
+        assert_eq!(written(&[Cell::Both(blue, blue)], 0, false), "\x1b[48;2;0;7;255m \x1b[49m\n");
+    }
+
+    #[test]
+    fn test_cell_writer_runs() {
+        let (a, b) = ([10, 10, 10], [12, 9, 10]);
+        let run = [Cell::Upper(a), Cell::Upper(a), Cell::Upper(a), Cell::Upper(b)];
+        assert_eq!(written(&run, 0, false), "\x1b[38;2;10;10;10m▀▀▀\x1b[38;2;12;9;10m▀\n");
+        assert_eq!(written(&run, 0, true), "\x1b[38;2;10;10;10m▀\x1b[2b\x1b[38;2;12;9;10m▀\n");
+        // Within tolerance the last cell joins the run
+        assert_eq!(written(&run, 2, true), "\x1b[38;2;10;10;10m▀\x1b[3b\n");
+    }
+
     #[test]
     fn test_composite_opaque() {
         let px = Pixel { r: 255, g: 0, b: 0, a: 255 };
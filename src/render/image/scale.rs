@@ -0,0 +1,127 @@
+//! Fast downscaling ahead of the resize filter
+//!
+//! A terminal shows a few thousand pixels at most, so a large image is
+//! first averaged down in `factor`×`factor` blocks to about twice the
+//! display size. The high-quality filter then only ever sees a small
+//! image. Rows are fed one at a time, so a decoder producing scanlines
+//! never needs the full image in memory.
+
+/// Averages blocks of RGBA8 rows, weighting color by alpha so that
+/// transparent pixels don't darken their neighbours.
+pub struct BoxShrink {
+    factor: u32,
+    width: u32,
+    out_width: u32,
+    /// Per output pixel of the current block row: Σr·a, Σg·a, Σb·a, Σa
+    sums: Vec<[u64; 4]>,
+    rows: u32,
+    out: Vec<u8>,
+}
+
+impl BoxShrink {
+    pub fn new(width: u32, height: u32, factor: u32) -> Self {
+        let out_width = width.div_ceil(factor);
+        BoxShrink {
+            factor,
+            width,
+            out_width,
+            sums: vec![[0; 4]; out_width as usize],
+            rows: 0,
+            out: Vec::with_capacity(out_width as usize * height.div_ceil(factor) as usize * 4),
+        }
+    }
+
+    /// Add one row of `width` RGBA8 pixels.
+    pub fn push_row(&mut self, row: &[u8]) {
+        let block = self.factor as usize * 4;
+        for (sum, pixels) in self.sums.iter_mut().zip(row.chunks(block)) {
+            for p in pixels.chunks_exact(4) {
+                let a = p[3] as u64;
+                sum[0] += p[0] as u64 * a;
+                sum[1] += p[1] as u64 * a;
+                sum[2] += p[2] as u64 * a;
+                sum[3] += a;
+            }
+        }
+        self.rows += 1;
+        if self.rows == self.factor {
+            self.flush();
+        }
+    }
+
+    /// The shrunk image as RGBA8 with its width and height; a last partial
+    /// block row is averaged over the rows it has.
+    pub fn finish(mut self) -> (Vec<u8>, u32, u32) {
+        if self.rows > 0 {
+            self.flush();
+        }
+        let height = (self.out.len() / 4 / self.out_width as usize) as u32;
+        (self.out, self.out_width, height)
+    }
+
+    fn flush(&mut self) {
+        let rows = self.rows as u64;
+        for (bx, sum) in self.sums.iter_mut().enumerate() {
+            let cols = (self.width - bx as u32 * self.factor).min(self.factor) as u64;
+            let a = sum[3];
+            if a == 0 {
+                self.out.extend_from_slice(&[0, 0, 0, 0]);
+            } else {
+                let color = |c: u64| ((c + a / 2) / a) as u8;
+                let alpha = ((a + cols * rows / 2) / (cols * rows)) as u8;
+                self.out.extend_from_slice(&[color(sum[0]), color(sum[1]), color(sum[2]), alpha]);
+            }
+            *sum = [0; 4];
+        }
+        self.rows = 0;
+    }
+}
+
+/// The block size that brings `width`×`height` down to no less than twice
+/// `target_w`×`target_h`; 1 when there's nothing to gain.
+pub fn prefilter_factor(width: u32, height: u32, target_w: u32, target_h: u32) -> u32 {
+    (width / (2 * target_w.max(1))).min(height / (2 * target_h.max(1))).max(1)
+}
+
+/// Shrink a whole RGBA8 buffer by `factor` in each direction.
+pub fn box_shrink(rgba: &[u8], width: u32, height: u32, factor: u32) -> (Vec<u8>, u32, u32) {
+    let mut shrink = BoxShrink::new(width, height, factor);
+    for row in rgba.chunks_exact(width as usize * 4) {
+        shrink.push_row(row);
+    }
+    shrink.finish()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_box_shrink_partial_blocks() {
+        // 3×3 opaque: a 2×2 block of 100s, partial edges of 200s
+        let mut rgba = Vec::new();
+        for y in 0..3 {
+            for x in 0..3 {
+                let v = if x < 2 && y < 2 { 100 } else { 200 };
+                rgba.extend_from_slice(&[v, v, v, 255]);
+            }
+        }
+        let (out, w, h) = box_shrink(&rgba, 3, 3, 2);
+        assert_eq!((w, h), (2, 2));
+        assert_eq!(&out[0..4], &[100, 100, 100, 255]);
+        assert_eq!(&out[4..8], &[200, 200, 200, 255]);
+        assert_eq!(&out[12..16], &[200, 200, 200, 255]);
+    }
+
+    #[test]
+    fn test_box_shrink_alpha_weighted() {
+        // Red beside a fully transparent (black) pixel stays red, half alpha
+        let rgba = [255, 0, 0, 255, 0, 0, 0, 0];
+        let (out, w, h) = box_shrink(&rgba, 2, 1, 2);
+        assert_eq!((w, h), (1, 1));
+        assert_eq!(out, [255, 0, 0, 128]);
+
+        assert_eq!(prefilter_factor(6000, 4000, 60, 40), 50);
+        assert_eq!(prefilter_factor(100, 100, 60, 40), 1);
+    }
+}
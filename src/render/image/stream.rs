@@ -0,0 +1,441 @@
+//! Row-streaming decode for row-oriented formats
+//!
+//! PNG (non-interlaced), binary PNM/PAM, uncompressed BMP and QOI are
+//! decoded a scanline at a time straight into a `BoxShrink`, so memory
+//! stays proportional to the output rather than the input: a 30k×30k map
+//! costs a few rows and the shrunk image, not 3.6GB per buffer. Anything
+//! else, or any variant not handled here, is left to the general loader.
+
+use std::io::{self, BufRead, Read};
+
+use super::scale::{self, BoxShrink};
+
+/// Widest or tallest image streamed; anything larger is a corrupt or
+/// hostile header rather than a picture.
+pub const MAX_DIMENSION: u32 = 1 << 17;
+
+/// A decoded image already shrunk toward display size.
+pub struct Shrunk {
+    pub rgba: Vec<u8>,
+    pub width: u32,
+    pub height: u32,
+    pub original: (u32, u32),
+}
+
+/// Decode `input` row by row, block-averaged to about twice `disp_w`×
+/// `disp_h` as computed by `display_size` from the original dimensions.
+/// `len` is the size of the whole input, against which the header's
+/// dimensions are checked before anything is allocated. `None` when the
+/// format isn't streamed here; nothing is consumed then.
+pub fn decode<R, F>(mut input: R, len: u64, display_size: F) -> Option<Result<Shrunk, String>>
+where
+    R: BufRead,
+    F: FnOnce(u32, u32) -> (u32, u32),
+{
+    let head = input.fill_buf().ok()?;
+    let format = Format::sniff(head)?;
+    let (width, height) = format.dimensions();
+    if width == 0 || height == 0 {
+        return None;
+    }
+    if let Err(e) = format.check_size(len) {
+        return Some(Err(e));
+    }
+    let (disp_w, disp_h) = display_size(width, height);
+    let shrink = BoxShrink::new(width, height, scale::prefilter_factor(width, height, disp_w, disp_h));
+    let result = match format {
+        Format::Png { .. } => png_rows(input, shrink),
+        Format::Pnm { header_len, layout, .. } => {
+            input.consume(header_len);
+            raw_rows(input, shrink, width, height, layout, false)
+        }
+        Format::Bmp { skip, layout, bottom_up, .. } => io::copy(&mut (&mut input).take(skip), &mut io::sink())
+            .and_then(|_| raw_rows(input, shrink, width, height, layout, bottom_up)),
+        Format::Qoi { .. } => {
+            input.consume(14);
+            qoi_rows(input, shrink, width, height)
+        }
+    };
+    Some(
+        result
+            .map(|(rgba, w, h)| Shrunk { rgba, width: w, height: h, original: (width, height) })
+            .map_err(|e| e.to_string()),
+    )
+}
+
+/// How the samples of a raw row map onto RGBA8
+#[derive(Clone, Copy, Debug, PartialEq)]
+struct Layout {
+    channels: usize,
+    /// 16-bit big-endian samples
+    wide: bool,
+    maxval: u32,
+    /// Channel order is BGR(A), as in BMP
+    bgr: bool,
+    /// A fourth channel that is padding, not alpha
+    opaque: bool,
+    /// Rows padded to a multiple of 4 bytes, as in BMP
+    padded: bool,
+}
+
+impl Layout {
+    fn plain(channels: usize) -> Self {
+        Layout { channels, wide: false, maxval: 255, bgr: false, opaque: false, padded: false }
+    }
+
+    fn row_bytes(&self, width: u32) -> usize {
+        let bytes = width as usize * self.channels * if self.wide { 2 } else { 1 };
+        if self.padded { bytes.next_multiple_of(4) } else { bytes }
+    }
+
+    /// Append `src` as RGBA8 pixels to `dst`.
+    fn to_rgba(&self, src: &[u8], width: u32, dst: &mut Vec<u8>) {
+        dst.clear();
+        if self.channels == 4 && !self.wide && self.maxval == 255 && !self.bgr && !self.opaque {
+            dst.extend_from_slice(&src[..width as usize * 4]);
+            return;
+        }
+        if !self.wide && self.maxval == 255 && (self.channels == 3 || self.opaque) {
+            for p in src.chunks_exact(self.channels).take(width as usize) {
+                let (r, b) = if self.bgr { (p[2], p[0]) } else { (p[0], p[2]) };
+                dst.extend_from_slice(&[r, p[1], b, 255]);
+            }
+            return;
+        }
+        let size = if self.wide { 2 } else { 1 };
+        let sample = |s: &[u8]| -> u8 {
+            let v = if self.wide { u16::from_be_bytes([s[0], s[1]]) as u32 } else { s[0] as u32 };
+            if self.maxval == 255 { v as u8 } else { ((v.min(self.maxval) * 255 + self.maxval / 2) / self.maxval) as u8 }
+        };
+        for p in src.chunks_exact(self.channels * size).take(width as usize) {
+            let s = |i: usize| sample(&p[i * size..]);
+            let px = match self.channels {
+                1 => [s(0), s(0), s(0), 255],
+                2 => [s(0), s(0), s(0), s(1)],
+                3 if self.bgr => [s(2), s(1), s(0), 255],
+                3 => [s(0), s(1), s(2), 255],
+                _ => {
+                    let a = if self.opaque { 255 } else { s(3) };
+                    if self.bgr { [s(2), s(1), s(0), a] } else { [s(0), s(1), s(2), a] }
+                }
+            };
+            dst.extend_from_slice(&px);
+        }
+    }
+}
+
+/// A recognized header, read from the first buffered bytes
+#[derive(Debug, PartialEq)]
+enum Format {
+    Png { width: u32, height: u32 },
+    Pnm { width: u32, height: u32, header_len: usize, layout: Layout },
+    Bmp { width: u32, height: u32, skip: u64, layout: Layout, bottom_up: bool },
+    Qoi { width: u32, height: u32 },
+}
+
+impl Format {
+    fn sniff(head: &[u8]) -> Option<Format> {
+        let be32 = |at: usize| Some(u32::from_be_bytes(head.get(at..at + 4)?.try_into().ok()?));
+        let le32 = |at: usize| Some(u32::from_le_bytes(head.get(at..at + 4)?.try_into().ok()?));
+        let le16 = |at: usize| Some(u16::from_le_bytes(head.get(at..at + 2)?.try_into().ok()?));
+
+        if head.starts_with(b"\x89PNG\r\n\x1a\n") && head.get(12..16) == Some(b"IHDR") {
+            // Adam7 rows arrive pass by pass; leave those to the full decoder
+            let interlaced = *head.get(28)? != 0;
+            return (!interlaced).then_some(Format::Png { width: be32(16)?, height: be32(20)? });
+        }
+        if head.starts_with(b"qoif") {
+            return Some(Format::Qoi { width: be32(4)?, height: be32(8)? });
+        }
+        if head.starts_with(b"BM") {
+            let offset = le32(10)? as u64;
+            let header_size = le32(14)?;
+            let width = le32(18)? as i32;
+            let height = le32(22)? as i32;
+            let bpp = le16(28)?;
+            let compression = le32(30)?;
+            if header_size < 40 || width <= 0 || height == 0 || compression != 0 || !(bpp == 24 || bpp == 32) {
+                return None;
+            }
+            let layout = Layout { bgr: true, opaque: bpp == 32, padded: true, ..Layout::plain(bpp as usize / 8) };
+            return Some(Format::Bmp {
+                width: width as u32,
+                height: height.unsigned_abs(),
+                skip: offset,
+                layout,
+                bottom_up: height > 0,
+            });
+        }
+        if head.starts_with(b"P5") || head.starts_with(b"P6") {
+            return pnm_header(head);
+        }
+        if head.starts_with(b"P7") {
+            return pam_header(head);
+        }
+        None
+    }
+
+    /// Reject dimensions over `MAX_DIMENSION`, or more samples than an
+    /// input of `len` bytes can hold.
+    fn check_size(&self, len: u64) -> Result<(), String> {
+        let (width, height) = self.dimensions();
+        if width > MAX_DIMENSION || height > MAX_DIMENSION {
+            return Err(format!("image dimensions {}x{} exceed the {} pixel limit", width, height, MAX_DIMENSION));
+        }
+        let pixels = width as u64 * height as u64;
+        let needed = match self {
+            Format::Pnm { header_len, layout, .. } => (layout.row_bytes(width) as u64)
+                .checked_mul(height as u64)
+                .and_then(|n| n.checked_add(*header_len as u64)),
+            Format::Bmp { skip, layout, .. } => (layout.row_bytes(width) as u64)
+                .checked_mul(height as u64)
+                .and_then(|n| n.checked_add(*skip)),
+            // A run chunk covers at most 62 pixels
+            Format::Qoi { .. } => Some(14 + pixels.div_ceil(62)),
+            // Deflate's best case is about 1032:1 over at least a bit per pixel
+            Format::Png { .. } => Some(pixels.div_ceil(8 * 1032)),
+        };
+        match needed {
+            Some(n) if n <= len => Ok(()),
+            _ => Err(format!("image header claims {}x{} pixels, more than the data holds", width, height)),
+        }
+    }
+
+    fn dimensions(&self) -> (u32, u32) {
+        match *self {
+            Format::Png { width, height }
+            | Format::Pnm { width, height, .. }
+            | Format::Bmp { width, height, .. }
+            | Format::Qoi { width, height } => (width, height),
+        }
+    }
+}
+
+/// Binary PGM/PPM: magic, width, height, maxval, with `#` comments
+/// between, then one whitespace byte.
+fn pnm_header(head: &[u8]) -> Option<Format> {
+    let mut at = 2;
+    let mut fields = [0u32; 3];
+    for field in &mut fields {
+        loop {
+            match head.get(at)? {
+                b'#' => at += head[at..].iter().position(|&b| b == b'\n')?,
+                b if b.is_ascii_whitespace() => at += 1,
+                _ => break,
+            }
+        }
+        let digits = head[at..].iter().take_while(|b| b.is_ascii_digit()).count();
+        *field = std::str::from_utf8(&head[at..at + digits]).ok()?.parse().ok()?;
+        at += digits;
+    }
+    // The single whitespace byte before the samples
+    head.get(at)?.is_ascii_whitespace().then_some(())?;
+    let [width, height, maxval] = fields;
+    let channels = if head[1] == b'5' { 1 } else { 3 };
+    pnm_format(width, height, maxval, channels, at + 1)
+}
+
+/// PAM: `KEY value` lines up to `ENDHDR`.
+fn pam_header(head: &[u8]) -> Option<Format> {
+    let end = memchr::memmem::find(head, b"ENDHDR\n")?;
+    let text = std::str::from_utf8(&head[3..end]).ok()?;
+    let (mut width, mut height, mut depth, mut maxval) = (0, 0, 0, 0);
+    for line in text.lines() {
+        let mut words = line.split_whitespace();
+        let value = |w: Option<&str>| w.and_then(|v| v.parse::<u32>().ok());
+        match words.next() {
+            Some("WIDTH") => width = value(words.next())?,
+            Some("HEIGHT") => height = value(words.next())?,
+            Some("DEPTH") => depth = value(words.next())?,
+            Some("MAXVAL") => maxval = value(words.next())?,
+            _ => {}
+        }
+    }
+    if !(1..=4).contains(&depth) {
+        return None;
+    }
+    pnm_format(width, height, maxval, depth as usize, end + 7)
+}
+
+fn pnm_format(width: u32, height: u32, maxval: u32, channels: usize, header_len: usize) -> Option<Format> {
+    if !(1..=65535).contains(&maxval) {
+        return None;
+    }
+    let layout = Layout { wide: maxval > 255, maxval, ..Layout::plain(channels) };
+    Some(Format::Pnm { width, height, header_len, layout })
+}
+
+/// Rows stored one after another, optionally bottom row first.
+fn raw_rows<R: Read>(
+    mut input: R,
+    mut shrink: BoxShrink,
+    width: u32,
+    height: u32,
+    layout: Layout,
+    bottom_up: bool,
+) -> io::Result<(Vec<u8>, u32, u32)> {
+    let mut row = vec![0; layout.row_bytes(width)];
+    let mut rgba = Vec::with_capacity(width as usize * 4);
+    for _ in 0..height {
+        input.read_exact(&mut row)?;
+        layout.to_rgba(&row, width, &mut rgba);
+        shrink.push_row(&rgba);
+    }
+    let (mut out, w, h) = shrink.finish();
+    if bottom_up {
+        // Blocks were averaged bottom up; put their rows back in order
+        let stride = w as usize * 4;
+        let rows: Vec<&[u8]> = out.chunks_exact(stride).rev().collect();
+        out = rows.concat();
+    }
+    Ok((out, w, h))
+}
+
+fn png_rows<R: BufRead>(input: R, mut shrink: BoxShrink) -> io::Result<(Vec<u8>, u32, u32)> {
+    let mut decoder = png::Decoder::new(input);
+    decoder.set_transformations(png::Transformations::EXPAND | png::Transformations::STRIP_16);
+    let mut reader = decoder.read_info().map_err(io::Error::other)?;
+    let width = reader.info().width;
+    let channels = match reader.output_color_type().0 {
+        png::ColorType::Grayscale => 1,
+        png::ColorType::GrayscaleAlpha => 2,
+        png::ColorType::Rgb => 3,
+        png::ColorType::Rgba => 4,
+        // EXPAND turns palettes into RGB(A)
+        png::ColorType::Indexed => return Err(io::Error::other("unexpanded palette")),
+    };
+    let layout = Layout::plain(channels);
+    let mut rgba = Vec::with_capacity(width as usize * 4);
+    while let Some(row) = reader.next_row().map_err(io::Error::other)? {
+        layout.to_rgba(row.data(), width, &mut rgba);
+        shrink.push_row(&rgba);
+    }
+    Ok(shrink.finish())
+}
+
+/// QOI's chunk stream, decoded as the format's reference decoder does.
+fn qoi_rows<R: Read>(mut input: R, mut shrink: BoxShrink, width: u32, height: u32) -> io::Result<(Vec<u8>, u32, u32)> {
+    let mut index = [[0u8; 4]; 64];
+    let mut px = [0, 0, 0, 255u8];
+    let mut run = 0u8;
+    let mut row = Vec::with_capacity(width as usize * 4);
+    let mut byte = || -> io::Result<u8> {
+        let mut b = [0];
+        input.read_exact(&mut b)?;
+        Ok(b[0])
+    };
+    for _ in 0..height {
+        row.clear();
+        for _ in 0..width {
+            if run > 0 {
+                run -= 1;
+            } else {
+                let b1 = byte()?;
+                match b1 {
+                    0xfe => px = [byte()?, byte()?, byte()?, px[3]],
+                    0xff => px = [byte()?, byte()?, byte()?, byte()?],
+                    _ => match b1 >> 6 {
+                        0 => px = index[(b1 & 0x3f) as usize],
+                        1 => {
+                            px[0] = px[0].wrapping_add((b1 >> 4 & 3).wrapping_sub(2));
+                            px[1] = px[1].wrapping_add((b1 >> 2 & 3).wrapping_sub(2));
+                            px[2] = px[2].wrapping_add((b1 & 3).wrapping_sub(2));
+                        }
+                        2 => {
+                            let b2 = byte()?;
+                            let dg = (b1 & 0x3f).wrapping_sub(32);
+                            px[0] = px[0].wrapping_add(dg.wrapping_sub(8).wrapping_add(b2 >> 4));
+                            px[1] = px[1].wrapping_add(dg);
+                            px[2] = px[2].wrapping_add(dg.wrapping_sub(8).wrapping_add(b2 & 0x0f));
+                        }
+                        _ => run = b1 & 0x3f,
+                    },
+                }
+                let hash = px[0] as usize * 3 + px[1] as usize * 5 + px[2] as usize * 7 + px[3] as usize * 11;
+                index[hash % 64] = px;
+            }
+            row.extend_from_slice(&px);
+        }
+        shrink.push_row(&row);
+    }
+    Ok(shrink.finish())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn decode_all(data: &[u8]) -> Shrunk {
+        // A display as large as the image: no shrinking
+        decode(data, data.len() as u64, |w, h| (w, h)).expect("streamed").expect("decoded")
+    }
+
+    #[test]
+    fn test_pnm_headers() {
+        let ppm = b"P6\n# comment\n2 1\n255\n\xff\x00\x00\x00\x00\xff";
+        let img = decode_all(ppm);
+        assert_eq!((img.width, img.height), (2, 1));
+        assert_eq!(img.rgba, [255, 0, 0, 255, 0, 0, 255, 255]);
+
+        let pgm16 = b"P5 1 1 65535\n\x80\x00";
+        assert_eq!(decode_all(pgm16).rgba, [128, 128, 128, 255]);
+
+        let pam = b"P7\nWIDTH 1\nHEIGHT 1\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n\x01\x02\x03\x04";
+        assert_eq!(decode_all(pam).rgba, [1, 2, 3, 4]);
+
+        // ASCII PNM goes to the general loader
+        assert!(decode(&b"P3 1 1 255 0 0 0"[..], 16, |w, h| (w, h)).is_none());
+    }
+
+    #[test]
+    fn test_hostile_dimensions() {
+        let rejected = |data: &[u8]| decode(data, data.len() as u64, |w, h| (w, h)).expect("streamed").is_err();
+
+        // Over the dimension limit, and more samples than the file holds
+        assert!(rejected(b"P6 4000000000 1 255\n\0\0\0"));
+        assert!(rejected(b"P6 60000 60000 255\n\0\0\0"));
+        assert!(rejected(b"P7\nWIDTH 100000\nHEIGHT 100000\nDEPTH 4\nMAXVAL 65535\nENDHDR\n"));
+
+        let mut qoi = b"qoif".to_vec();
+        qoi.extend_from_slice(&100_000u32.to_be_bytes());
+        qoi.extend_from_slice(&100_000u32.to_be_bytes());
+        qoi.extend_from_slice(&[4, 0, 0xc0]);
+        assert!(rejected(&qoi));
+    }
+
+    #[test]
+    fn test_bmp_bottom_up() {
+        // 1×2, 24-bit: bottom row blue, top row red, rows padded to 4
+        let mut bmp = b"BM".to_vec();
+        bmp.extend_from_slice(&[0; 8]);
+        bmp.extend_from_slice(&54u32.to_le_bytes());
+        bmp.extend_from_slice(&40u32.to_le_bytes());
+        bmp.extend_from_slice(&1i32.to_le_bytes());
+        bmp.extend_from_slice(&2i32.to_le_bytes());
+        bmp.extend_from_slice(&1u16.to_le_bytes());
+        bmp.extend_from_slice(&24u16.to_le_bytes());
+        bmp.extend_from_slice(&[0; 24]);
+        bmp.extend_from_slice(&[255, 0, 0, 0, 0, 0, 255, 0]);
+        let img = decode_all(&bmp);
+        assert_eq!((img.width, img.height), (1, 2));
+        assert_eq!(img.rgba, [255, 0, 0, 255, 0, 0, 255, 255]);
+    }
+
+    #[test]
+    fn test_qoi_chunks() {
+        let mut qoi = b"qoif".to_vec();
+        qoi.extend_from_slice(&4u32.to_be_bytes());
+        qoi.extend_from_slice(&1u32.to_be_bytes());
+        qoi.extend_from_slice(&[4, 0]);
+        // RGB 10,20,30; DIFF +1,0,-1; RUN ×1; INDEX of the first pixel
+        let first = [10u8, 20, 30, 255];
+        let hash = (10 * 3 + 20 * 5 + 30 * 7 + 255 * 11) % 64;
+        qoi.extend_from_slice(&[0xfe, 10, 20, 30, 0x40 | 3 << 4 | 2 << 2 | 1, 0xc0, hash as u8]);
+        qoi.extend_from_slice(&[0, 0, 0, 0, 0, 0, 0, 1]);
+        let img = decode_all(&qoi);
+        assert_eq!(&img.rgba[..4], &first);
+        assert_eq!(&img.rgba[4..8], &[11, 20, 29, 255]);
+        assert_eq!(&img.rgba[8..12], &[11, 20, 29, 255]);
+        assert_eq!(&img.rgba[12..16], &first);
+    }
+}
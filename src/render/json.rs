@@ -2,8 +2,13 @@
 //!
 //! Nested brackets `{}[]` cycle through pastel rainbow colors,
 //! making nesting depth instantly visible.
+//! With `--depth N`, deeper subtrees fold into `{…} (n keys)` summaries;
+//! with `--query PATH`, only the selected subtrees are rendered.
 
+use super::fold;
+use crate::jsondoc::Document;
 use crate::output::Output;
+use crate::query::Query;
 use crate::theme::Theme;
 
 const RAINBOW: &[(u8, u8, u8)] = &[
@@ -17,16 +22,40 @@ const RAINBOW: &[(u8, u8, u8)] = &[
     (248, 165, 212), // pastel pink
 ];
 
-pub fn render(content: &str, theme: &Theme, out: &Output) {
-    match serde_json::from_str::<serde_json::Value>(content) {
-        Ok(value) => {
-            let pretty =
-                serde_json::to_string_pretty(&value).unwrap_or_else(|_| content.to_string());
-            render_highlighted(&pretty, theme, out);
-        }
-        Err(_) => {
-            render_highlighted(content, theme, out);
-        }
+pub fn render(content: &str, depth: Option<usize>, theme: &Theme, out: &Output) {
+    if let Some(max_depth) = depth {
+        render_highlighted(&fold::fold_json(content, max_depth), theme, out);
+        return;
+    }
+
+    // Valid documents are re-indented straight from the source text, keeping
+    // key order and number formatting; anything else is highlighted as-is.
+    if Document::parse(content).is_ok() {
+        render_highlighted(&fold::fold_json(content, usize::MAX), theme, out);
+    } else {
+        render_highlighted(content, theme, out);
+    }
+}
+
+/// Render only the subtrees selected by `query`. The document is never
+/// parsed as a whole: the query walks the raw bytes and skips everything
+/// it does not select, then each match is pretty-printed on its own.
+pub fn render_query(
+    content: &str,
+    query: &Query,
+    depth: Option<usize>,
+    theme: &Theme,
+    out: &Output,
+) {
+    let matches = query.matches(content);
+    if matches.is_empty() {
+        out.dim(&format!("  (no match for {})\n", query.as_str()), theme.line_number);
+        return;
+    }
+
+    for range in matches {
+        let pretty = fold::fold_json(&content[range], depth.unwrap_or(usize::MAX));
+        render_highlighted(&pretty, theme, out);
     }
 }
 
@@ -69,7 +98,7 @@ fn render_highlighted(json: &str, theme: &Theme, out: &Output) {
         if ch == '"' {
             if !in_string {
                 in_string = true;
-                is_key = !after_colon && is_likely_key(json, i);
+                is_key = !after_colon && is_likely_key(&chars, i);
                 let color = if is_key {
                     theme.json_key
                 } else {
@@ -132,6 +161,22 @@ fn render_highlighted(json: &str, theme: &Theme, out: &Output) {
                     crossterm::style::Color::Rgb { r, g, b },
                 );
                 i += 1;
+                // Folded subtree: `{…} (n keys)` — dim the count
+                if i >= 2 && chars[i - 2] == '…' && chars.get(i) == Some(&' ') {
+                    let start = i;
+                    while i < chars.len() && chars[i] != ')' && chars[i] != '\n' {
+                        i += 1;
+                    }
+                    if i < chars.len() && chars[i] == ')' {
+                        i += 1;
+                    }
+                    let note: String = chars[start..i].iter().collect();
+                    out.dim(&note, theme.line_number);
+                }
+            }
+            '…' => {
+                out.dim("…", theme.line_number);
+                i += 1;
             }
             _ if ch.is_ascii_digit() || ch == '-' || ch == '.' => {
                 let start = i;
@@ -188,13 +233,14 @@ fn render_highlighted(json: &str, theme: &Theme, out: &Output) {
     }
 }
 
-fn rainbow_color(depth: usize) -> (u8, u8, u8) {
+pub(crate) fn rainbow_color(depth: usize) -> (u8, u8, u8) {
     RAINBOW[depth % RAINBOW.len()]
 }
 
-fn is_likely_key(json: &str, quote_pos: usize) -> bool {
-    let chars: Vec<char> = json[quote_pos + 1..].chars().collect();
-    let mut i = 0;
+/// Whether the string opening at `quote_pos` is followed by `:`. Only the
+/// string itself and the whitespace after it are scanned.
+fn is_likely_key(chars: &[char], quote_pos: usize) -> bool {
+    let mut i = quote_pos + 1;
     let mut escaped = false;
 
     while i < chars.len() {
@@ -209,15 +255,10 @@ fn is_likely_key(json: &str, quote_pos: usize) -> bool {
             continue;
         }
         if chars[i] == '"' {
-            for j in (i + 1)..chars.len() {
-                if chars[j] == ':' {
-                    return true;
-                }
-                if !chars[j].is_whitespace() {
-                    return false;
-                }
-            }
-            return false;
+            return chars[i + 1..]
+                .iter()
+                .find(|c| !c.is_whitespace())
+                .map_or(false, |&c| c == ':');
         }
         i += 1;
     }
@@ -2,12 +2,16 @@ pub mod blame;
 pub mod brief;
 pub mod code;
 pub mod csv;
+pub mod diff;
+pub mod fold;
 pub mod grep;
 pub mod hex;
 pub mod image;
 pub mod json;
 pub mod markdown;
 pub mod plain;
+pub mod records;
 pub mod showall;
 pub mod toml;
+pub mod xml;
 pub mod yaml;
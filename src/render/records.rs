@@ -0,0 +1,255 @@
+//! Tabular view of JSON record sets (`--table`)
+//!
+//! Projects a JSON array of objects, or NDJSON (one JSON value per line),
+//! onto columns: the union of the record keys, with nested objects
+//! flattened into dotted paths such as `geo.lat`. Columns and widths are
+//! inferred from an evenly spaced sample of records; rows are then parsed
+//! and printed one at a time through the CSV table renderer, so no record
+//! tree or row list is built.
+//!
+//! The input is still held in memory and scanned several times. An array
+//! is first indexed as a whole by `Document::parse`, which costs 8 bytes
+//! per structural character. NDJSON is tried the same way until the parse
+//! fails. The records are then walked once to count them, once for the
+//! sample and once to print.
+
+use std::collections::HashMap;
+
+use crate::jsondoc::{Document, Items, Kind, Value};
+use crate::output::Output;
+use crate::render::csv::Table;
+use crate::render::fold::group_thousands;
+use crate::structural::skip_string;
+use crate::theme::Theme;
+use unicode_width::UnicodeWidthStr;
+
+/// Records inspected to pick columns and widths
+const SAMPLE_ROWS: usize = 1_000;
+
+/// Object nesting flattened into dotted columns; deeper values are shown
+/// as compact JSON.
+const FLATTEN_DEPTH: usize = 3;
+
+/// Longest cell text kept; cells are cut to the column width anyway
+const CELL_LIMIT: usize = 256;
+
+/// Column for records that are not objects (scalars, arrays)
+const VALUE_COLUMN: &str = "value";
+
+pub fn render(content: &str, theme: &Theme, out: &Output) {
+    let doc = Document::parse(content).ok();
+    let total = records(content, doc.as_ref()).count();
+    if total == 0 {
+        out.dim("  (no JSON records to tabulate)\n", theme.line_number);
+        return;
+    }
+
+    // Pass 1: columns and natural widths from the sample
+    let mut columns = Columns::default();
+    let stride = ((total + SAMPLE_ROWS - 1) / SAMPLE_ROWS).max(1);
+    for raw in records(content, doc.as_ref()).step_by(stride) {
+        for_each_cell(raw, |path, cell| {
+            let idx = columns.index_or_insert(path);
+            columns.widths[idx] = columns.widths[idx].max(cell.width());
+        });
+    }
+    if columns.names.is_empty() {
+        out.dim(
+            &format!("  ({} records with no fields; no columns to tabulate)\n", group_thousands(total)),
+            theme.line_number,
+        );
+        return;
+    }
+
+    // Pass 2: stream the rows
+    let table = Table::new(columns.widths.clone(), theme, out);
+    table.top(out);
+    table.header(&columns.names, out);
+    table.separator(out);
+
+    let mut cells = vec![String::new(); columns.names.len()];
+    let mut unsampled = 0usize;
+    for raw in records(content, doc.as_ref()) {
+        for cell in cells.iter_mut() {
+            cell.clear();
+        }
+        for_each_cell(raw, |path, cell| match columns.index.get(path) {
+            Some(&i) => cells[i].push_str(cell),
+            None => unsampled += 1,
+        });
+        table.row(&cells, out);
+    }
+
+    table.bottom(out);
+    out.dim(
+        &format!("  {} rows × {} columns\n", group_thousands(total), columns.names.len()),
+        theme.hr,
+    );
+    if unsampled > 0 {
+        out.dim(
+            &format!("  ({} values in fields outside the sampled columns omitted)\n", group_thousands(unsampled)),
+            theme.hr,
+        );
+    }
+}
+
+/// Column names in first-seen order, with their widest sampled cell.
+#[derive(Default)]
+struct Columns {
+    names: Vec<String>,
+    widths: Vec<usize>,
+    index: HashMap<String, usize>,
+}
+
+impl Columns {
+    fn index_or_insert(&mut self, name: &str) -> usize {
+        if let Some(&i) = self.index.get(name) {
+            return i;
+        }
+        self.names.push(name.to_string());
+        self.widths.push(name.width());
+        self.index.insert(name.to_string(), self.names.len() - 1);
+        self.names.len() - 1
+    }
+}
+
+/// Raw text of each record: the elements of a root array, the root value
+/// itself when it is anything else, or the non-blank lines of NDJSON.
+enum Records<'d, 'a> {
+    Array(Items<'d, 'a>),
+    One(Option<&'a str>),
+    Lines(std::str::Lines<'a>),
+}
+
+fn records<'d, 'a>(content: &'a str, doc: Option<&'d Document<'a>>) -> Records<'d, 'a> {
+    match doc {
+        Some(doc) if doc.root().kind() == Kind::Array => Records::Array(doc.root().items()),
+        Some(doc) => Records::One(Some(doc.root().raw())),
+        None => Records::Lines(content.lines()),
+    }
+}
+
+impl<'d, 'a> Iterator for Records<'d, 'a> {
+    type Item = &'a str;
+
+    fn next(&mut self) -> Option<&'a str> {
+        match self {
+            Records::Array(items) => items.next().map(|v| v.raw()),
+            Records::One(raw) => raw.take(),
+            Records::Lines(lines) => lines.map(str::trim).find(|l| !l.is_empty()),
+        }
+    }
+}
+
+/// Parse one record and report each flattened `(column, cell)` pair.
+/// Lines that are not valid JSON land in the value column verbatim.
+fn for_each_cell<F: FnMut(&str, &str)>(raw: &str, mut f: F) {
+    match Document::parse(raw) {
+        Ok(doc) if doc.root().kind() == Kind::Object => {
+            let mut path = String::new();
+            flatten(doc.root(), &mut path, 0, &mut f);
+        }
+        Ok(doc) => f(VALUE_COLUMN, &cell_text(doc.root())),
+        Err(_) => f(VALUE_COLUMN, &sanitize(raw)),
+    }
+}
+
+fn flatten<F: FnMut(&str, &str)>(obj: Value, path: &mut String, depth: usize, f: &mut F) {
+    for (key, value) in obj.entries() {
+        let len = path.len();
+        if !path.is_empty() {
+            path.push('.');
+        }
+        path.push_str(&key);
+        if value.kind() == Kind::Object && !value.is_empty() && depth + 1 < FLATTEN_DEPTH {
+            flatten(value, path, depth + 1, f);
+        } else {
+            f(path, &cell_text(value));
+        }
+        path.truncate(len);
+    }
+}
+
+fn cell_text(value: Value) -> String {
+    match value.kind() {
+        Kind::String => sanitize(&value.as_str().unwrap_or_default()),
+        Kind::Null => String::new(),
+        Kind::Number | Kind::Bool => value.raw().to_string(),
+        Kind::Object | Kind::Array => compact(value.raw()),
+    }
+}
+
+/// Control characters (newlines, tabs) would break the row; show them as spaces.
+fn sanitize(s: &str) -> String {
+    s.chars().map(|c| if c.is_control() { ' ' } else { c }).collect()
+}
+
+/// JSON text with the whitespace between tokens removed, cut short after
+/// `CELL_LIMIT` bytes.
+fn compact(raw: &str) -> String {
+    let bytes = raw.as_bytes();
+    let mut out = String::with_capacity(raw.len().min(CELL_LIMIT));
+    let mut i = 0;
+    while i < bytes.len() && out.len() < CELL_LIMIT {
+        if bytes[i] == b'"' {
+            let end = skip_string(bytes, i);
+            out.push_str(&sanitize(&raw[i..end]));
+            i = end;
+            continue;
+        }
+        let start = i;
+        while i < bytes.len() && bytes[i] != b'"' {
+            i += 1;
+        }
+        out.extend(raw[start..i].chars().filter(|c| !c.is_whitespace()));
+    }
+    out
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn cells(raw: &str) -> Vec<(String, String)> {
+        let mut found = Vec::new();
+        for_each_cell(raw, |p, c| found.push((p.to_string(), c.to_string())));
+        found
+    }
+
+    #[test]
+    fn test_flatten_dotted_paths() {
+        let found = cells(r#"{"id": 1, "geo": {"lat": 1.5, "tags": [1, 2]}, "note": null, "e": {}}"#);
+        let pairs: Vec<(&str, &str)> = found.iter().map(|(p, c)| (p.as_str(), c.as_str())).collect();
+        assert_eq!(
+            pairs,
+            vec![("id", "1"), ("geo.lat", "1.5"), ("geo.tags", "[1,2]"), ("note", ""), ("e", "{}")]
+        );
+    }
+
+    #[test]
+    fn test_flatten_depth_limit() {
+        let found = cells(r#"{"a": {"b": {"c": {"d": 1}}}}"#);
+        assert_eq!(found, vec![("a.b.c".to_string(), r#"{"d":1}"#.to_string())]);
+    }
+
+    #[test]
+    fn test_records_array_and_ndjson() {
+        let json = r#"[{"a": 1}, {"a": 2}]"#;
+        let doc = Document::parse(json).ok();
+        assert_eq!(records(json, doc.as_ref()).collect::<Vec<_>>(), vec![r#"{"a": 1}"#, r#"{"a": 2}"#]);
+
+        let ndjson = "{\"a\": 1}\n\n{\"a\": 2}\n";
+        let doc = Document::parse(ndjson).ok();
+        assert!(doc.is_none());
+        assert_eq!(records(ndjson, doc.as_ref()).count(), 2);
+    }
+
+    #[test]
+    fn test_strings_are_sanitized() {
+        let found = cells(r#"{"s": "two\nlines", "raw": ["x y\t"]}"#);
+        assert_eq!(found[0].1, "two lines");
+        assert_eq!(found[1].1, r#"["x y\t"]"#);
+    }
+}
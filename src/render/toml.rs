@@ -3,17 +3,231 @@
 //! Line-based parser that preserves original formatting.
 //! Section headers `[name]`/`[[name]]` get bracket color + bold key,
 //! key-value pairs are colored by value type.
+//! With `--depth N`, tables and inline/multi-line values nested deeper than
+//! N levels fold into one-line summaries.
 
+use super::fold::{self, Fold};
 use crate::output::Output;
 use crate::theme::Theme;
 
-pub fn render(content: &str, theme: &Theme, out: &Output) {
+pub fn render(content: &str, depth: Option<usize>, theme: &Theme, out: &Output) {
+    if let Some(max_depth) = depth {
+        render_folded(content, max_depth, theme, out);
+        return;
+    }
+
     for line in content.lines() {
         render_line(line, theme, out);
         println!();
     }
 }
 
+/// Render the document with everything below `max_depth` folded. The root
+/// table is level 1 and `[a.b]` is level 3. A folded table keeps its header
+/// line and gets a key count; its body (and any sub-tables) is skipped by
+/// scanning headers only.
+fn render_folded(content: &str, max_depth: usize, theme: &Theme, out: &Output) {
+    let lines: Vec<&str> = content.lines().collect();
+
+    if max_depth == 0 {
+        let (_, count) = count_table(&lines, 0, &[]);
+        out.dim(&fold::summary(Fold::Object, count), theme.line_number);
+        println!();
+        return;
+    }
+
+    // Level of the table whose body we are in (root = 1)
+    let mut level = 1;
+    let mut i = 0;
+
+    while i < lines.len() {
+        let line = lines[i];
+        let trimmed = line.trim();
+
+        if trimmed.starts_with('[') {
+            let path = header_path(trimmed);
+            level = path.len() + 1;
+            if level > max_depth {
+                let (end, count) = count_table(&lines, i + 1, &path);
+                render_line(line, theme, out);
+                print!(" ");
+                out.dim(&fold::summary(Fold::Object, count), theme.line_number);
+                println!();
+                i = end;
+                continue;
+            }
+            render_line(line, theme, out);
+            println!();
+            i += 1;
+            continue;
+        }
+
+        // Container values are one level below their table; multi-line
+        // arrays are consumed whole so their lines never look like headers
+        if let Some(eq_pos) = find_key_equals(trimmed) {
+            let (val, _) = split_trailing_comment(trimmed[eq_pos + 1..].trim());
+            if val.starts_with('[') || val.starts_with('{') {
+                let (end, kind, count) = scan_value(&lines, i, eq_pos);
+                if level + 1 > max_depth {
+                    let indent = &line[..line.len() - line.trim_start().len()];
+                    print!("{}", indent);
+                    out.colored(trimmed[..eq_pos].trim_end(), theme.json_key);
+                    print!(" ");
+                    out.colored("=", theme.json_bracket);
+                    print!(" ");
+                    if count == 0 {
+                        out.colored(&val[..1], theme.json_bracket);
+                        out.colored(if kind == Fold::Object { "}" } else { "]" }, theme.json_bracket);
+                    } else {
+                        out.dim(&fold::summary(kind, count), theme.line_number);
+                    }
+                    println!();
+                } else {
+                    for l in &lines[i..end] {
+                        render_line(l, theme, out);
+                        println!();
+                    }
+                }
+                i = end;
+                continue;
+            }
+        }
+
+        render_line(line, theme, out);
+        println!();
+        i += 1;
+    }
+}
+
+/// Position of the `=` in a `key = value` line (comments and headers excluded).
+fn find_key_equals(trimmed: &str) -> Option<usize> {
+    if trimmed.starts_with('#') || trimmed.starts_with('[') {
+        return None;
+    }
+    find_equals(trimmed)
+}
+
+/// Dotted path of a `[table]` / `[[array]]` header, with quoted segments
+/// kept intact: `[a."b.c".d]` → `["a", "\"b.c\"", "d"]`.
+fn header_path(trimmed: &str) -> Vec<&str> {
+    let inner = trimmed.trim_start_matches('[');
+    let end = inner.find(']').unwrap_or(inner.len());
+    split_top_level(&inner[..end], '.')
+        .into_iter()
+        .map(|s| s.trim())
+        .collect()
+}
+
+/// Count the direct keys of the table whose body starts at `start`: its own
+/// `key = value` lines plus the distinct first segments of any sub-table
+/// headers under `path`. Returns the index of the first line after the table
+/// and its descendants, and the count.
+fn count_table(lines: &[&str], start: usize, path: &[&str]) -> (usize, usize) {
+    let mut count = 0;
+    let mut children: Vec<&str> = Vec::new();
+    let mut in_own_body = true;
+    let mut i = start;
+
+    while i < lines.len() {
+        let trimmed = lines[i].trim();
+        if trimmed.starts_with('[') {
+            let sub = header_path(trimmed);
+            if sub.len() <= path.len() || sub[..path.len()] != *path {
+                break;
+            }
+            if !children.contains(&sub[path.len()]) {
+                children.push(sub[path.len()]);
+            }
+            in_own_body = false;
+        } else if let Some(eq_pos) = find_key_equals(trimmed) {
+            // Dotted keys share a first segment: `a.b = 1`, `a.c = 2` → `a`
+            let segments = split_top_level(trimmed[..eq_pos].trim(), '.');
+            if !in_own_body {
+                // Belongs to a sub-table, already counted by its header
+            } else if segments.len() == 1 {
+                count += 1;
+            } else if !children.contains(&segments[0].trim()) {
+                children.push(segments[0].trim());
+            }
+            // Skip the rest of a multi-line value
+            let (end, _, _) = scan_value(lines, i, eq_pos);
+            i = end;
+            continue;
+        }
+        i += 1;
+    }
+
+    (i, count + children.len())
+}
+
+/// Scan the value starting after `=` on line `start`, following brackets
+/// across lines for multi-line arrays. Returns the first line after the
+/// value, the container kind, and its number of top-level elements.
+fn scan_value(lines: &[&str], start: usize, eq_pos: usize) -> (usize, Fold, usize) {
+    let first = lines[start].trim();
+    let (val, _) = split_trailing_comment(first[eq_pos + 1..].trim());
+    let kind = if val.starts_with('{') { Fold::Object } else { Fold::Array };
+    if !val.starts_with('[') && !val.starts_with('{') {
+        return (start + 1, kind, 0);
+    }
+
+    let mut depth = 0i32;
+    let mut commas = 0;
+    let mut non_empty = false;
+    let mut i = start;
+    let mut text = val;
+
+    loop {
+        let mut in_string = false;
+        let mut quote = ' ';
+        let mut escaped = false;
+        for ch in text.chars() {
+            if escaped {
+                escaped = false;
+                continue;
+            }
+            if in_string {
+                if ch == '\\' && quote == '"' {
+                    escaped = true;
+                } else if ch == quote {
+                    in_string = false;
+                }
+                continue;
+            }
+            match ch {
+                '#' => break,
+                '"' | '\'' => {
+                    in_string = true;
+                    quote = ch;
+                    non_empty |= depth == 1;
+                }
+                '[' | '{' => {
+                    non_empty |= depth == 1;
+                    depth += 1;
+                }
+                ']' | '}' => {
+                    depth -= 1;
+                    if depth == 0 {
+                        return (i + 1, kind, commas + non_empty as usize);
+                    }
+                }
+                ',' if depth == 1 => {
+                    // A trailing comma before the closing bracket is not an element
+                    commas += 1;
+                    non_empty = false;
+                }
+                c if depth == 1 && !c.is_whitespace() => non_empty = true,
+                _ => {}
+            }
+        }
+        i += 1;
+        if i >= lines.len() {
+            return (i, kind, commas + non_empty as usize);
+        }
+        text = lines[i];
+    }
+}
+
 fn render_line(line: &str, theme: &Theme, out: &Output) {
     let trimmed = line.trim();
 
@@ -331,3 +545,31 @@ fn is_toml_datetime(val: &str) -> bool {
         && val.as_bytes()[4] == b'-'
         && val.chars().take(4).all(|c| c.is_ascii_digit())
 }
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_header_path() {
+        assert_eq!(header_path("[a.b]"), vec!["a", "b"]);
+        assert_eq!(header_path("[[bin]]"), vec!["bin"]);
+        assert_eq!(header_path("[a.\"b.c\"]"), vec!["a", "\"b.c\""]);
+    }
+
+    #[test]
+    fn test_scan_value_multi_line() {
+        let lines = vec!["deps = [", "  \"a\",", "  [\"b\", 1],", "]", "x = 1"];
+        assert_eq!(scan_value(&lines, 0, 5), (4, Fold::Array, 2));
+        let inline = vec!["t = { a = 1, b = \"}\" }"];
+        assert_eq!(scan_value(&inline, 0, 2), (1, Fold::Object, 2));
+    }
+
+    #[test]
+    fn test_count_table_includes_subtables() {
+        let lines = vec!["a = 1", "b.c = 2", "b.d = 3", "[pkg.sub]", "x = 1", "[other]"];
+        assert_eq!(count_table(&lines, 0, &["pkg"]), (5, 3));
+    }
+}
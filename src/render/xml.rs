@@ -0,0 +1,671 @@
+//! Streaming XML/HTML renderer
+//!
+//! A small pull parser reads markup from any `BufRead` one token at a time.
+//! The renderer re-indents the document and colors tag names by nesting
+//! depth with the same rainbow as JSON brackets; attributes use the JSON
+//! key/string colors. Only the open-element stack and the current token are
+//! held, so minified multi-gigabyte files render in O(depth) memory.
+
+use std::collections::{HashMap, VecDeque};
+use std::io::{self, BufRead};
+
+use crossterm::style::Color;
+
+use crate::output::Output;
+use crate::render::fold::group_thousands;
+use crate::render::json::rainbow_color;
+use crate::theme::Theme;
+
+/// Text up to this many characters stays on the line of its element
+const INLINE_TEXT: usize = 80;
+
+/// Distinct element paths kept by the outline
+const MAX_OUTLINE_PATHS: usize = 2_000;
+
+const HTML_VOID: &[&str] = &[
+    "area", "base", "br", "col", "embed", "hr", "img", "input", "link", "meta", "param", "source",
+    "track", "wbr",
+];
+
+/// Elements whose content is copied through untouched
+const HTML_RAW: &[&str] = &["script", "style", "pre", "textarea"];
+
+#[derive(Clone, Debug, PartialEq)]
+pub enum Event {
+    Open {
+        name: String,
+        attrs: String,
+        self_closing: bool,
+    },
+    Close(String),
+    Text(String),
+    /// Verbatim content of `<script>`, `<pre>` and friends (HTML only)
+    Raw(String),
+    Comment(String),
+    CData(String),
+    /// `<?xml …?>`, `<!DOCTYPE …>` and other declarations
+    Decl(String),
+}
+
+/// Pull parser over a byte stream. Malformed markup never fails: whatever
+/// cannot be classified is reported as text.
+pub struct Reader<R> {
+    inner: R,
+    html: bool,
+    line: usize,
+    event_line: usize,
+    raw_until: Option<String>,
+    pending: Option<Event>,
+}
+
+impl<R: BufRead> Reader<R> {
+    pub fn new(inner: R, html: bool) -> Self {
+        Reader {
+            inner,
+            html,
+            line: 1,
+            event_line: 1,
+            raw_until: None,
+            pending: None,
+        }
+    }
+
+    /// Line on which the most recently returned event started.
+    pub fn line(&self) -> usize {
+        self.event_line
+    }
+
+    pub fn next_event(&mut self) -> io::Result<Option<Event>> {
+        if let Some(ev) = self.pending.take() {
+            return Ok(Some(ev));
+        }
+        self.event_line = self.line;
+        if let Some(name) = self.raw_until.take() {
+            return self.read_raw(name).map(Some);
+        }
+
+        let mut buf = Vec::new();
+        let first = match self.inner.fill_buf()?.first() {
+            Some(&b) => b,
+            None => return Ok(None),
+        };
+        if first != b'<' {
+            self.take_until_lt(&mut buf)?;
+            return Ok(Some(Event::Text(lossy(buf))));
+        }
+
+        self.inner.consume(1);
+        // Quotes only delimit attribute values in element tags; comments
+        // and declarations may contain stray apostrophes.
+        let quote_aware = !matches!(self.inner.fill_buf()?.first(), Some(b'!') | Some(b'?'));
+        if !self.read_through_gt(&mut buf, quote_aware)? {
+            buf.insert(0, b'<');
+            return Ok(Some(Event::Text(lossy(buf))));
+        }
+        // `buf` holds everything between `<` and `>`; comments, CDATA and
+        // processing instructions may contain `>` and need extending.
+        if buf.starts_with(b"!--") {
+            while !(buf.len() >= 5 && buf.ends_with(b"--")) {
+                buf.push(b'>');
+                if !self.read_through_gt(&mut buf, false)? {
+                    break;
+                }
+            }
+            let inner = &buf[3..buf.len().saturating_sub(2).max(3)];
+            return Ok(Some(Event::Comment(lossy(inner.to_vec()))));
+        }
+        if buf.starts_with(b"![CDATA[") {
+            while !buf.ends_with(b"]]") {
+                buf.push(b'>');
+                if !self.read_through_gt(&mut buf, false)? {
+                    break;
+                }
+            }
+            let inner = &buf[8..buf.len().saturating_sub(2).max(8)];
+            return Ok(Some(Event::CData(lossy(inner.to_vec()))));
+        }
+        if buf.starts_with(b"?") {
+            while buf.len() < 2 || !buf.ends_with(b"?") {
+                buf.push(b'>');
+                if !self.read_through_gt(&mut buf, false)? {
+                    break;
+                }
+            }
+            return Ok(Some(Event::Decl(format!("<{}>", lossy(buf)))));
+        }
+        if buf.starts_with(b"!") {
+            return Ok(Some(Event::Decl(format!("<{}>", lossy(buf)))));
+        }
+        if let Some(rest) = buf.strip_prefix(b"/") {
+            return Ok(Some(Event::Close(lossy(rest.to_vec()).trim().to_string())));
+        }
+
+        let tag = lossy(buf);
+        let body = tag.trim_end();
+        let self_closing = body.ends_with('/');
+        let body = body.trim_end_matches('/');
+        let name_end = body.find(|c: char| c.is_whitespace()).unwrap_or(body.len());
+        let name = body[..name_end].to_string();
+        let attrs = body[name_end..].trim().to_string();
+
+        if self.html && !self_closing && HTML_RAW.iter().any(|r| name.eq_ignore_ascii_case(r)) {
+            self.raw_until = Some(name.to_ascii_lowercase());
+        }
+        let self_closing = self_closing || (self.html && is_void(&name));
+        Ok(Some(Event::Open {
+            name,
+            attrs,
+            self_closing,
+        }))
+    }
+
+    /// Append bytes up to (not including) the next `<`.
+    fn take_until_lt(&mut self, buf: &mut Vec<u8>) -> io::Result<()> {
+        loop {
+            let avail = self.inner.fill_buf()?;
+            if avail.is_empty() {
+                return Ok(());
+            }
+            let (n, found) = match avail.iter().position(|&b| b == b'<') {
+                Some(i) => (i, true),
+                None => (avail.len(), false),
+            };
+            buf.extend_from_slice(&avail[..n]);
+            self.line += count_newlines(&avail[..n]);
+            self.inner.consume(n);
+            if found {
+                return Ok(());
+            }
+        }
+    }
+
+    /// Append bytes through the next `>` (which is consumed but not kept),
+    /// ignoring any inside quoted attribute values when `quote_aware`.
+    /// Returns `false` at end of input.
+    fn read_through_gt(&mut self, buf: &mut Vec<u8>, quote_aware: bool) -> io::Result<bool> {
+        let mut quote: Option<u8> = None;
+        loop {
+            let avail = self.inner.fill_buf()?;
+            if avail.is_empty() {
+                return Ok(false);
+            }
+            let mut end = None;
+            for (i, &b) in avail.iter().enumerate() {
+                match quote {
+                    Some(q) if b == q => quote = None,
+                    Some(_) => {}
+                    None if quote_aware && (b == b'"' || b == b'\'') => quote = Some(b),
+                    None if b == b'>' => {
+                        end = Some(i);
+                        break;
+                    }
+                    None => {}
+                }
+            }
+            let n = end.unwrap_or(avail.len());
+            buf.extend_from_slice(&avail[..n]);
+            self.line += count_newlines(&avail[..n]);
+            match end {
+                Some(_) => {
+                    self.inner.consume(n + 1);
+                    return Ok(true);
+                }
+                None => self.inner.consume(n),
+            }
+        }
+    }
+
+    /// Content of a raw-text element up to its closing tag, which becomes
+    /// the pending event.
+    fn read_raw(&mut self, name: String) -> io::Result<Event> {
+        let mut buf = Vec::new();
+        loop {
+            self.take_until_lt(&mut buf)?;
+            if self.inner.fill_buf()?.is_empty() {
+                return Ok(Event::Raw(lossy(buf)));
+            }
+            let mark = buf.len();
+            self.inner.consume(1);
+            buf.push(b'<');
+            if !self.read_through_gt(&mut buf, false)? {
+                return Ok(Event::Raw(lossy(buf)));
+            }
+            let tag = String::from_utf8_lossy(&buf[mark + 1..]).to_string();
+            if let Some(close) = tag.strip_prefix('/') {
+                if close.trim().eq_ignore_ascii_case(&name) {
+                    buf.truncate(mark);
+                    self.pending = Some(Event::Close(close.trim().to_string()));
+                    return Ok(Event::Raw(lossy(buf)));
+                }
+            }
+            buf.push(b'>');
+        }
+    }
+}
+
+fn lossy(bytes: Vec<u8>) -> String {
+    String::from_utf8(bytes).unwrap_or_else(|e| String::from_utf8_lossy(e.as_bytes()).into_owned())
+}
+
+fn count_newlines(bytes: &[u8]) -> usize {
+    bytes.iter().filter(|&&b| b == b'\n').count()
+}
+
+fn is_void(name: &str) -> bool {
+    HTML_VOID.iter().any(|v| name.eq_ignore_ascii_case(v))
+}
+
+fn same_name(a: &str, b: &str, html: bool) -> bool {
+    if html {
+        a.eq_ignore_ascii_case(b)
+    } else {
+        a == b
+    }
+}
+
+/// For syntect language names handled here: whether to parse as HTML.
+pub fn is_markup(lang: &str) -> Option<bool> {
+    match lang {
+        "XML" => Some(false),
+        "HTML" => Some(true),
+        _ => None,
+    }
+}
+
+// ─── Pretty-printer ───
+
+pub fn render(content: &str, html: bool, theme: &Theme, out: &Output) {
+    // Reading from a slice cannot fail
+    let _ = render_reader(content.as_bytes(), html, theme, out);
+}
+
+pub fn render_reader<R: BufRead>(input: R, html: bool, theme: &Theme, out: &Output) -> io::Result<()> {
+    let mut reader = Reader::new(input, html);
+    let mut ahead: VecDeque<Event> = VecDeque::new();
+    let mut stack: Vec<String> = Vec::new();
+
+    loop {
+        let ev = match ahead.pop_front() {
+            Some(ev) => ev,
+            None => match reader.next_event()? {
+                Some(ev) => ev,
+                None => break,
+            },
+        };
+
+        match ev {
+            Event::Open {
+                name,
+                attrs,
+                self_closing,
+            } => {
+                let depth = stack.len();
+                indent(depth);
+                print_open(&name, &attrs, self_closing, depth, theme, out);
+                if self_closing {
+                    println!();
+                    continue;
+                }
+
+                while ahead.len() < 2 {
+                    match reader.next_event()? {
+                        Some(ev) => ahead.push_back(ev),
+                        None => break,
+                    }
+                }
+                // `<a></a>` and `<a>short text</a>` stay on one line
+                let inline = match (ahead.front(), ahead.get(1)) {
+                    (Some(Event::Close(c)), _) if same_name(c, &name, html) => Some(0),
+                    (Some(Event::Text(t)), Some(Event::Close(c)))
+                        if same_name(c, &name, html) && is_inline_text(t) =>
+                    {
+                        Some(1)
+                    }
+                    _ => None,
+                };
+                match inline {
+                    Some(consumed) => {
+                        if consumed == 1 {
+                            if let Some(Event::Text(t)) = ahead.pop_front() {
+                                out.colored(t.trim(), theme.text);
+                            }
+                        }
+                        ahead.pop_front();
+                        print_close(&name, depth, out);
+                        println!();
+                    }
+                    None => {
+                        println!();
+                        stack.push(name);
+                    }
+                }
+            }
+            Event::Close(name) => {
+                // Unmatched closers (sloppy HTML) leave the depth alone
+                if let Some(pos) = stack.iter().rposition(|n| same_name(n, &name, html)) {
+                    stack.truncate(pos);
+                }
+                let depth = stack.len();
+                indent(depth);
+                print_close(&name, depth, out);
+                println!();
+            }
+            Event::Text(text) => {
+                for line in text.lines().map(str::trim).filter(|l| !l.is_empty()) {
+                    indent(stack.len());
+                    out.colored(line, theme.text);
+                    println!();
+                }
+            }
+            Event::Raw(text) => {
+                let text = text.trim_matches(|c| c == '\n' || c == '\r');
+                // Relative indentation inside is kept; only shifted to depth
+                for line in text.lines() {
+                    indent(stack.len());
+                    out.colored(line, theme.code_block_fg);
+                    println!();
+                }
+            }
+            Event::Comment(text) => {
+                let depth = stack.len();
+                for (i, line) in format!("<!--{}-->", text).lines().enumerate() {
+                    indent(depth);
+                    out.dim(if i == 0 { line } else { line.trim() }, theme.line_number);
+                    println!();
+                }
+            }
+            Event::CData(text) => {
+                indent(stack.len());
+                out.dim("<![CDATA[", theme.line_number);
+                out.colored(&text, theme.json_string);
+                out.dim("]]>", theme.line_number);
+                println!();
+            }
+            Event::Decl(text) => {
+                indent(stack.len());
+                out.dim(&text, theme.line_number);
+                println!();
+            }
+        }
+    }
+    Ok(())
+}
+
+fn is_inline_text(text: &str) -> bool {
+    let t = text.trim();
+    !t.contains('\n') && t.chars().count() <= INLINE_TEXT
+}
+
+fn indent(depth: usize) {
+    print!("{}", "  ".repeat(depth));
+}
+
+fn tag_color(depth: usize) -> Color {
+    let (r, g, b) = rainbow_color(depth);
+    Color::Rgb { r, g, b }
+}
+
+fn print_open(name: &str, attrs: &str, self_closing: bool, depth: usize, theme: &Theme, out: &Output) {
+    let color = tag_color(depth);
+    out.colored("<", color);
+    out.bold_colored(name, color);
+    for (key, value) in split_attrs(attrs) {
+        out.colored(" ", theme.text);
+        out.colored(key, theme.json_key);
+        if let Some(v) = value {
+            out.dim("=", theme.line_number);
+            out.colored(v, theme.json_string);
+        }
+    }
+    out.colored(if self_closing { " />" } else { ">" }, color);
+}
+
+fn print_close(name: &str, depth: usize, out: &Output) {
+    let color = tag_color(depth);
+    out.colored("</", color);
+    out.bold_colored(name, color);
+    out.colored(">", color);
+}
+
+/// Split a raw attribute list into `(name, value)` pairs; values keep
+/// their quotes. Whitespace (including newlines) between attributes is
+/// normalized away.
+fn split_attrs(attrs: &str) -> Vec<(&str, Option<&str>)> {
+    let bytes = attrs.as_bytes();
+    let mut pairs = Vec::new();
+    let mut i = 0;
+    while i < bytes.len() {
+        while i < bytes.len() && bytes[i].is_ascii_whitespace() {
+            i += 1;
+        }
+        let start = i;
+        while i < bytes.len() && bytes[i] != b'=' && !bytes[i].is_ascii_whitespace() {
+            i += 1;
+        }
+        if start == i {
+            break;
+        }
+        let key = &attrs[start..i];
+        let mut j = i;
+        while j < bytes.len() && bytes[j].is_ascii_whitespace() {
+            j += 1;
+        }
+        if j >= bytes.len() || bytes[j] != b'=' {
+            pairs.push((key, None));
+            continue;
+        }
+        j += 1;
+        while j < bytes.len() && bytes[j].is_ascii_whitespace() {
+            j += 1;
+        }
+        let vstart = j;
+        match bytes.get(j) {
+            Some(&q) if q == b'"' || q == b'\'' => {
+                j += 1;
+                while j < bytes.len() && bytes[j] != q {
+                    j += 1;
+                }
+                j = (j + 1).min(bytes.len());
+            }
+            _ => {
+                while j < bytes.len() && !bytes[j].is_ascii_whitespace() {
+                    j += 1;
+                }
+            }
+        }
+        pairs.push((key, Some(&attrs[vstart..j])));
+        i = j;
+    }
+    pairs
+}
+
+// ─── Outline (brief mode) ───
+
+struct PathNode {
+    name: String,
+    depth: usize,
+    line: usize,
+    count: usize,
+    children: Vec<usize>,
+}
+
+/// Element-path outline: every distinct path from the root, shown as a
+/// tree with the line of its first occurrence and how often it repeats.
+/// Sibling elements with the same path collapse into one entry, so a
+/// 50,000-entry sitemap outlines as `urlset / url / loc …`.
+pub fn outline<R: BufRead>(input: R, html: bool, theme: &Theme, out: &Output) -> io::Result<()> {
+    let mut reader = Reader::new(input, html);
+    let mut nodes: Vec<PathNode> = Vec::new();
+    let mut roots: Vec<usize> = Vec::new();
+    let mut index: HashMap<(usize, String), usize> = HashMap::new();
+    // Open elements: their name and path node (None once past the cap)
+    let mut stack: Vec<(String, Option<usize>)> = Vec::new();
+    let mut dropped = 0usize;
+
+    while let Some(ev) = reader.next_event()? {
+        match ev {
+            Event::Open {
+                name, self_closing, ..
+            } => {
+                let parent = stack.last().map(|(_, node)| *node);
+                let node = match parent {
+                    Some(None) => None,
+                    _ => {
+                        let parent_id = parent.flatten().unwrap_or(usize::MAX);
+                        let key = (parent_id, name.clone());
+                        match index.get(&key) {
+                            Some(&id) => {
+                                nodes[id].count += 1;
+                                Some(id)
+                            }
+                            None if nodes.len() < MAX_OUTLINE_PATHS => {
+                                nodes.push(PathNode {
+                                    name: name.clone(),
+                                    depth: stack.len(),
+                                    line: reader.line(),
+                                    count: 1,
+                                    children: Vec::new(),
+                                });
+                                let id = nodes.len() - 1;
+                                match parent.flatten() {
+                                    Some(p) => nodes[p].children.push(id),
+                                    None => roots.push(id),
+                                }
+                                index.insert(key, id);
+                                Some(id)
+                            }
+                            None => {
+                                dropped += 1;
+                                None
+                            }
+                        }
+                    }
+                };
+                if !self_closing {
+                    stack.push((name, node));
+                }
+            }
+            Event::Close(name) => {
+                if let Some(pos) = stack.iter().rposition(|(n, _)| same_name(n, &name, html)) {
+                    stack.truncate(pos);
+                }
+            }
+            _ => {}
+        }
+    }
+
+    if nodes.is_empty() {
+        out.dim("  (no elements)\n", theme.line_number);
+        return Ok(());
+    }
+
+    let width = nodes.iter().map(|n| n.line).max().unwrap_or(1).to_string().len();
+    let mut todo: Vec<usize> = roots.into_iter().rev().collect();
+    while let Some(id) = todo.pop() {
+        let node = &nodes[id];
+        out.dim(&format!(" {:>w$} │ ", node.line, w = width), theme.line_number);
+        print!("{}", "  ".repeat(node.depth));
+        out.bold_colored(&node.name, tag_color(node.depth));
+        if node.count > 1 {
+            out.dim(&format!(" ×{}", group_thousands(node.count)), theme.line_number);
+        }
+        println!();
+        todo.extend(node.children.iter().rev());
+    }
+    if dropped > 0 {
+        out.dim(
+            &format!("  (+{} elements under paths beyond the first {})\n", group_thousands(dropped), MAX_OUTLINE_PATHS),
+            theme.line_number,
+        );
+    }
+    Ok(())
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn events(src: &str, html: bool) -> Vec<Event> {
+        let mut reader = Reader::new(src.as_bytes(), html);
+        let mut all = Vec::new();
+        while let Some(ev) = reader.next_event().unwrap() {
+            all.push(ev);
+        }
+        all
+    }
+
+    fn open(name: &str, attrs: &str, self_closing: bool) -> Event {
+        Event::Open {
+            name: name.into(),
+            attrs: attrs.into(),
+            self_closing,
+        }
+    }
+
+    #[test]
+    fn test_pull_parser_xml() {
+        let src = r#"<?xml version="1.0"?><a x="1>2"><!-- c's > d --><b/>t<![CDATA[<raw>]]></a>"#;
+        assert_eq!(
+            events(src, false),
+            vec![
+                Event::Decl(r#"<?xml version="1.0"?>"#.into()),
+                open("a", r#"x="1>2""#, false),
+                Event::Comment(" c's > d ".into()),
+                open("b", "", true),
+                Event::Text("t".into()),
+                Event::CData("<raw>".into()),
+                Event::Close("a".into()),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_pull_parser_html_void_and_raw() {
+        let src = "<p>a<br>b</p><script>if (a<b) x = '</p>';</SCRIPT>";
+        assert_eq!(
+            events(src, true),
+            vec![
+                open("p", "", false),
+                Event::Text("a".into()),
+                open("br", "", true),
+                Event::Text("b".into()),
+                Event::Close("p".into()),
+                open("script", "", false),
+                Event::Raw("if (a<b) x = '</p>';".into()),
+                Event::Close("SCRIPT".into()),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_line_tracking() {
+        let mut reader = Reader::new("<a>\n  <b>\n\n<c/>".as_bytes(), false);
+        let mut lines = Vec::new();
+        while let Some(ev) = reader.next_event().unwrap() {
+            if let Event::Open { .. } = ev {
+                lines.push(reader.line());
+            }
+        }
+        assert_eq!(lines, vec![1, 2, 4]);
+    }
+
+    #[test]
+    fn test_split_attrs() {
+        assert_eq!(
+            split_attrs(r#"id="x y" checked data-v='1'  k = v"#),
+            vec![
+                ("id", Some(r#""x y""#)),
+                ("checked", None),
+                ("data-v", Some("'1'")),
+                ("k", Some("v")),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_truncated_input() {
+        assert_eq!(events("<a><b", false), vec![open("a", "", false), Event::Text("<b".into())]);
+    }
+}
@@ -3,17 +3,165 @@
 //! Line-based parser that preserves original formatting.
 //! Keys get key color, values are colored by detected type
 //! (bool, null, number, string).
+//! With `--depth N`, deeper blocks fold into one-line summaries,
+//! found by indentation alone.
 
+use super::fold::{self, Fold};
 use crate::output::Output;
 use crate::theme::Theme;
 
-pub fn render(content: &str, theme: &Theme, out: &Output) {
+pub fn render(content: &str, depth: Option<usize>, theme: &Theme, out: &Output) {
+    if let Some(max_depth) = depth {
+        render_folded(content, max_depth, theme, out);
+        return;
+    }
+
     for line in content.lines() {
         render_line(line, theme, out);
         println!();
     }
 }
 
+/// Render only the first `max_depth` nesting levels. A line whose children
+/// would be deeper gets a summary instead; the children are skipped by
+/// comparing indentation, without being parsed or colored.
+fn render_folded(content: &str, max_depth: usize, theme: &Theme, out: &Output) {
+    let lines: Vec<&str> = content.lines().collect();
+
+    if max_depth == 0 {
+        let (kind, count) = count_children(&lines, true);
+        out.dim(&fold::summary(kind, count), theme.line_number);
+        println!();
+        return;
+    }
+
+    // Effective indents of the ancestors of the current line
+    let mut ancestors: Vec<usize> = Vec::new();
+    let mut i = 0;
+
+    while i < lines.len() {
+        let line = lines[i];
+        let trimmed = line.trim();
+
+        if trimmed.is_empty() || trimmed.starts_with('#') {
+            render_line(line, theme, out);
+            println!();
+            i += 1;
+            continue;
+        }
+        if trimmed == "---" || trimmed == "..." {
+            ancestors.clear();
+        }
+
+        let indent = effective_indent(line);
+        while ancestors.last().map_or(false, |&a| a >= indent) {
+            ancestors.pop();
+        }
+
+        render_line(line, theme, out);
+
+        let end = block_end(&lines, i);
+        if end > i + 1 {
+            if ancestors.len() + 1 >= max_depth {
+                let (kind, count) = count_children(&lines[i + 1..end], false);
+                let inline_value = !trimmed.ends_with(':') && trimmed != "-";
+                let note = if inline_value && kind != Fold::Lines {
+                    format!("… (+{})", fold::count_label(kind, count))
+                } else {
+                    fold::summary(kind, count)
+                };
+                print!(" ");
+                out.dim(&note, theme.line_number);
+                println!();
+                i = end;
+                continue;
+            }
+            ancestors.push(indent);
+        }
+
+        println!();
+        i += 1;
+    }
+}
+
+/// Indentation used for nesting: list items sit one half-step deeper than
+/// a key at the same column, so `key:\n- item` nests the item under `key`.
+fn effective_indent(line: &str) -> usize {
+    let rest = line.trim_start();
+    let indent = (line.len() - rest.len()) * 2;
+    if rest.starts_with("- ") || rest == "-" {
+        indent + 1
+    } else {
+        indent
+    }
+}
+
+/// Exclusive end of the block nested under line `start` (the line itself
+/// when it has no children). Trailing blank lines are left outside.
+fn block_end(lines: &[&str], start: usize) -> usize {
+    let parent = effective_indent(lines[start]);
+    let mut end = start + 1;
+    let mut j = start + 1;
+    while j < lines.len() {
+        let line = lines[j];
+        let trimmed = line.trim();
+        if trimmed.is_empty() || trimmed.starts_with('#') {
+            j += 1;
+            continue;
+        }
+        if effective_indent(line) <= parent {
+            break;
+        }
+        j += 1;
+        end = j;
+    }
+    end
+}
+
+/// Classify a folded block and count its direct children: list items,
+/// mapping keys, or (for block scalars) plain text lines. The document root
+/// always counts as a mapping unless it is a sequence.
+fn count_children(block: &[&str], root: bool) -> (Fold, usize) {
+    let first = block
+        .iter()
+        .find(|l| {
+            let t = l.trim();
+            !t.is_empty() && !t.starts_with('#') && t != "---" && t != "..." && !t.starts_with('%')
+        })
+        .copied();
+    let first = match first {
+        Some(l) => l,
+        None => return (Fold::Lines, 0),
+    };
+
+    let child_indent = effective_indent(first);
+    let first_rest = first.trim_start();
+    let kind = if first_rest.starts_with("- ") || first_rest == "-" {
+        Fold::Array
+    } else if root || find_colon(first_rest).is_some() {
+        Fold::Object
+    } else {
+        Fold::Lines
+    };
+
+    let count = match kind {
+        Fold::Lines => block.iter().filter(|l| !l.trim().is_empty()).count(),
+        _ => block
+            .iter()
+            .filter(|l| {
+                let t = l.trim();
+                !t.is_empty()
+                    && !t.starts_with('#')
+                    && !t.starts_with('%')
+                    && t != "---"
+                    && t != "..."
+                    && effective_indent(l) == child_indent
+            })
+            .count(),
+    };
+    (kind, count)
+}
+
 fn render_line(line: &str, theme: &Theme, out: &Output) {
     let trimmed = line.trim();
 
@@ -353,3 +501,31 @@ fn is_yaml_number(val: &str) -> bool {
         .all(|c| c.is_ascii_digit() || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-' || c == '_')
         && s.chars().next().map_or(false, |c| c.is_ascii_digit())
 }
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_effective_indent_nests_list_under_key() {
+        assert_eq!(effective_indent("items:"), 0);
+        assert_eq!(effective_indent("- a"), 1);
+        assert_eq!(effective_indent("  spec:"), 4);
+    }
+
+    #[test]
+    fn test_block_end_and_children() {
+        let lines = vec!["items:", "- a: 1", "  b: 2", "", "- c", "", "next: 1"];
+        assert_eq!(block_end(&lines, 0), 5);
+        assert_eq!(count_children(&lines[1..5], false), (Fold::Array, 2));
+        assert_eq!(block_end(&lines, 6), 7);
+    }
+
+    #[test]
+    fn test_count_children_block_scalar() {
+        let lines = vec!["  echo hi", "  echo bye"];
+        assert_eq!(count_children(&lines, false), (Fold::Lines, 2));
+    }
+}
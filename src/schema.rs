@@ -0,0 +1,320 @@
+//! Schema inference for JSON records (brief mode)
+//!
+//! Merges the shape of many values into one `Schema`: field names, the set
+//! of types seen, which fields are optional, nested object/array shapes and
+//! value ranges. Large arrays are sampled evenly up to `SAMPLE_BUDGET`
+//! records, and the sample is folded in parallel chunks whose partial
+//! schemas are merged at the end.
+
+use std::collections::HashMap;
+use std::thread;
+
+use crate::jsondoc::{Kind, Value};
+
+/// Maximum number of array elements inspected per inference
+pub const SAMPLE_BUDGET: usize = 10_000;
+
+/// Elements of a nested array inspected per occurrence
+const NESTED_ITEM_LIMIT: usize = 64;
+
+/// Nesting depth below which shapes are no longer tracked
+const MAX_DEPTH: usize = 6;
+
+/// Below this many samples, threads cost more than they save
+const PARALLEL_THRESHOLD: usize = 2_048;
+
+#[derive(Clone, Debug, Default)]
+pub struct Schema {
+    /// Values merged into this schema
+    pub seen: usize,
+    /// Per-kind counts: object, array, string, number, bool, null
+    pub kinds: [usize; 6],
+    /// Object fields in first-seen order
+    pub fields: Vec<(String, Schema)>,
+    field_index: HashMap<String, usize>,
+    /// Merged shape of array elements
+    pub items: Option<Box<Schema>>,
+    pub num_range: Option<(f64, f64)>,
+    pub all_integers: bool,
+    pub str_len: Option<(usize, usize)>,
+    pub array_len: Option<(usize, usize)>,
+}
+
+fn kind_slot(kind: Kind) -> usize {
+    match kind {
+        Kind::Object => 0,
+        Kind::Array => 1,
+        Kind::String => 2,
+        Kind::Number => 3,
+        Kind::Bool => 4,
+        Kind::Null => 5,
+    }
+}
+
+const KIND_NAMES: [&str; 6] = ["object", "array", "string", "number", "bool", "null"];
+
+/// Infer the merged schema of the elements of `array`, sampling at most
+/// `SAMPLE_BUDGET` of them. Returns the schema and the number sampled.
+pub fn infer_items(array: Value) -> (Schema, usize) {
+    let len = array.len();
+    let stride = ((len + SAMPLE_BUDGET - 1) / SAMPLE_BUDGET).max(1);
+    let sample: Vec<Value> = array.items().step_by(stride).take(SAMPLE_BUDGET).collect();
+
+    let workers = thread::available_parallelism().map_or(1, |n| n.get());
+    if sample.len() < PARALLEL_THRESHOLD || workers < 2 {
+        let mut schema = Schema::new();
+        for v in &sample {
+            schema.add(*v, 0);
+        }
+        return (schema, sample.len());
+    }
+
+    let chunk = (sample.len() + workers - 1) / workers;
+    let partials: Vec<Schema> = thread::scope(|scope| {
+        let handles: Vec<_> = sample
+            .chunks(chunk)
+            .map(|part| {
+                scope.spawn(move || {
+                    let mut schema = Schema::new();
+                    for v in part {
+                        schema.add(*v, 0);
+                    }
+                    schema
+                })
+            })
+            .collect();
+        handles.into_iter().map(|h| h.join().unwrap_or_default()).collect()
+    });
+
+    let mut schema = Schema::new();
+    for partial in partials {
+        schema.merge(partial);
+    }
+    (schema, sample.len())
+}
+
+impl Schema {
+    pub fn new() -> Self {
+        Schema {
+            all_integers: true,
+            ..Default::default()
+        }
+    }
+
+    pub fn add(&mut self, value: Value, depth: usize) {
+        self.seen += 1;
+        let kind = value.kind();
+        self.kinds[kind_slot(kind)] += 1;
+
+        match kind {
+            Kind::Object if depth < MAX_DEPTH => {
+                for (key, v) in value.entries() {
+                    self.field_mut(&key).add(v, depth + 1);
+                }
+            }
+            Kind::Array => {
+                let n = value.len();
+                self.array_len = Some(widen(self.array_len, n, n));
+                if depth < MAX_DEPTH {
+                    let items = self.items.get_or_insert_with(|| Box::new(Schema::new()));
+                    for v in value.items().take(NESTED_ITEM_LIMIT) {
+                        items.add(v, depth + 1);
+                    }
+                }
+            }
+            Kind::String => {
+                let n = value.as_str().map_or(0, |s| s.chars().count());
+                self.str_len = Some(widen(self.str_len, n, n));
+            }
+            Kind::Number => {
+                let raw = value.raw();
+                if let Ok(x) = raw.parse::<f64>() {
+                    self.num_range = Some(match self.num_range {
+                        Some((lo, hi)) => (lo.min(x), hi.max(x)),
+                        None => (x, x),
+                    });
+                }
+                self.all_integers &= !raw.contains(['.', 'e', 'E']);
+            }
+            _ => {}
+        }
+    }
+
+    /// Fold another partial schema (built over a disjoint sample) into this one.
+    pub fn merge(&mut self, other: Schema) {
+        self.seen += other.seen;
+        for (a, b) in self.kinds.iter_mut().zip(other.kinds.iter()) {
+            *a += b;
+        }
+        for (name, field) in other.fields {
+            self.field_mut(&name).merge(field);
+        }
+        if let Some(items) = other.items {
+            match self.items.as_mut() {
+                Some(mine) => mine.merge(*items),
+                None => self.items = Some(items),
+            }
+        }
+        if let Some((lo, hi)) = other.num_range {
+            self.num_range = Some(match self.num_range {
+                Some((a, b)) => (a.min(lo), b.max(hi)),
+                None => (lo, hi),
+            });
+        }
+        self.all_integers &= other.all_integers;
+        if let Some((lo, hi)) = other.str_len {
+            self.str_len = Some(widen(self.str_len, lo, hi));
+        }
+        if let Some((lo, hi)) = other.array_len {
+            self.array_len = Some(widen(self.array_len, lo, hi));
+        }
+    }
+
+    fn field_mut(&mut self, name: &str) -> &mut Schema {
+        let idx = match self.field_index.get(name) {
+            Some(&i) => i,
+            None => {
+                self.fields.push((name.to_string(), Schema::new()));
+                self.field_index.insert(name.to_string(), self.fields.len() - 1);
+                self.fields.len() - 1
+            }
+        };
+        &mut self.fields[idx].1
+    }
+
+    pub fn objects(&self) -> usize {
+        self.kinds[0]
+    }
+
+    /// Type union, e.g. `string | null`, with nested element types for
+    /// arrays: `[object]`, `[number | string]`.
+    pub fn type_label(&self) -> String {
+        let mut parts: Vec<String> = Vec::new();
+        for (slot, &count) in self.kinds.iter().enumerate() {
+            if count == 0 {
+                continue;
+            }
+            if slot == 1 {
+                match &self.items {
+                    Some(items) if items.seen > 0 => parts.push(format!("[{}]", items.type_label())),
+                    _ => parts.push("[]".to_string()),
+                }
+            } else {
+                parts.push(KIND_NAMES[slot].to_string());
+            }
+        }
+        if parts.is_empty() {
+            return "unknown".to_string();
+        }
+        parts.join(" | ")
+    }
+
+    /// Value ranges worth showing: numbers, string lengths, array lengths.
+    pub fn range_label(&self) -> Option<String> {
+        let mut parts = Vec::new();
+        if let Some((lo, hi)) = self.num_range {
+            let kind = if self.all_integers { "int" } else { "float" };
+            parts.push(if lo == hi {
+                format!("{} {}", kind, lo)
+            } else {
+                format!("{} {} … {}", kind, lo, hi)
+            });
+        }
+        if let Some((lo, hi)) = self.str_len {
+            parts.push(span_label("len", lo, hi));
+        }
+        if let Some((lo, hi)) = self.array_len {
+            parts.push(span_label("items", lo, hi));
+        }
+        if parts.is_empty() {
+            None
+        } else {
+            Some(parts.join(", "))
+        }
+    }
+}
+
+fn span_label(noun: &str, lo: usize, hi: usize) -> String {
+    if lo == hi {
+        format!("{} {}", noun, lo)
+    } else {
+        format!("{} {}–{}", noun, lo, hi)
+    }
+}
+
+fn widen(range: Option<(usize, usize)>, lo: usize, hi: usize) -> (usize, usize) {
+    match range {
+        Some((a, b)) => (a.min(lo), b.max(hi)),
+        None => (lo, hi),
+    }
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::jsondoc::Document;
+
+    const RECORDS: &str = r#"[
+        {"id": 1, "name": "ann", "tags": ["a"], "geo": {"lat": 1.5}},
+        {"id": 2, "name": "bob", "tags": [], "email": null},
+        {"id": 30, "name": "carol", "tags": ["b", "c"], "email": "c@x.io", "geo": {"lat": -2}}
+    ]"#;
+
+    fn field<'s>(schema: &'s Schema, name: &str) -> &'s Schema {
+        &schema.fields.iter().find(|(n, _)| n == name).unwrap().1
+    }
+
+    #[test]
+    fn test_infer_fields_and_optional() {
+        let doc = Document::parse(RECORDS).unwrap();
+        let (schema, sampled) = infer_items(doc.root());
+        assert_eq!(sampled, 3);
+        assert_eq!(schema.objects(), 3);
+        let names: Vec<&str> = schema.fields.iter().map(|(n, _)| n.as_str()).collect();
+        assert_eq!(names, vec!["id", "name", "tags", "geo", "email"]);
+
+        assert_eq!(field(&schema, "id").seen, 3);
+        assert_eq!(field(&schema, "geo").seen, 2);
+        assert_eq!(field(&schema, "email").type_label(), "string | null");
+        assert_eq!(field(&schema, "tags").type_label(), "[string]");
+        assert_eq!(field(&schema, "id").range_label().unwrap(), "int 1 … 30");
+        assert_eq!(field(&schema, "name").range_label().unwrap(), "len 3–5");
+        assert_eq!(field(&schema, "tags").range_label().unwrap(), "items 0–2");
+
+        let lat = field(field(&schema, "geo"), "lat");
+        assert_eq!(lat.range_label().unwrap(), "float -2 … 1.5");
+    }
+
+    #[test]
+    fn test_parallel_merge_matches_serial() {
+        let mut json = String::from("[");
+        for i in 0..5000 {
+            if i > 0 {
+                json.push(',');
+            }
+            if i % 2 == 0 {
+                json.push_str(&format!(r#"{{"n": {}, "even": true}}"#, i));
+            } else {
+                json.push_str(&format!(r#"{{"n": {}, "s": "x"}}"#, i));
+            }
+        }
+        json.push(']');
+        let doc = Document::parse(&json).unwrap();
+        let (schema, sampled) = infer_items(doc.root());
+        assert_eq!(sampled, 5000);
+        assert_eq!(field(&schema, "n").seen, 5000);
+        assert_eq!(field(&schema, "even").seen, 2500);
+        assert_eq!(field(&schema, "n").range_label().unwrap(), "int 0 … 4999");
+    }
+
+    #[test]
+    fn test_sampling_budget() {
+        let json = format!("[{}]", vec!["1"; SAMPLE_BUDGET * 3 + 1].join(","));
+        let doc = Document::parse(&json).unwrap();
+        let (schema, sampled) = infer_items(doc.root());
+        assert!(sampled <= SAMPLE_BUDGET);
+        assert_eq!(schema.type_label(), "number");
+    }
+}
@@ -0,0 +1,343 @@
+//! Definition spans for `--symbol NAME`
+//!
+//! Definitions are located with the same machinery as brief mode: syntect
+//! symbols where the language has them, otherwise structural lines that
+//! contain the name as a whole word. The extent of each definition then
+//! depends on the format: headings run to the next heading of the same or
+//! higher level, TOML tables to the next table, and code either to the
+//! matching closing brace or, for indentation-scoped languages (and code
+//! where no brace opens a body), to the end of the indented block.
+//! Doc comments and attributes directly above a definition are included
+//! (except for headings).
+
+use std::ops::Range;
+use std::path::Path;
+
+use crate::detect::FileFormat;
+use crate::lines;
+use crate::render::brief::structural_lines;
+use crate::symbols;
+
+/// Languages whose blocks are delimited by indentation
+const INDENT_LANGS: &[&str] = &["python", "cython", "nim", "coffeescript", "haml", "sass", "pug", "slim", "yaml"];
+
+/// A brace body must open within this many lines of the definition
+const SIGNATURE_LINES: usize = 32;
+
+/// 0-based line ranges of the definitions of `name` in `content`, in order.
+/// `path` is the file `content` was read from, if any, for caching.
+pub fn find(content: &str, format: &FileFormat, path: Option<&Path>, name: &str) -> Vec<Range<usize>> {
+    let lines: Vec<&str> = lines::lines(content).collect();
+    let starts = def_lines(content, format, path, name);
+
+    let mut spans: Vec<Range<usize>> = Vec::new();
+    for start in starts {
+        // A definition nested in the previous span is already shown
+        if spans.last().map_or(false, |s| s.contains(&start)) {
+            continue;
+        }
+        let end = match format {
+            FileFormat::Markdown => heading_end(&lines, start),
+            FileFormat::Toml => table_end(&lines, start),
+            FileFormat::Yaml => indent_end(&lines, start),
+            FileFormat::Code(lang) if INDENT_LANGS.contains(&lang.to_lowercase().as_str()) => indent_end(&lines, start),
+            _ => brace_end(&lines, start).unwrap_or_else(|| indent_end(&lines, start)),
+        };
+        let first = match format {
+            FileFormat::Markdown => start,
+            _ => leading_start(&lines, start),
+        };
+        spans.push(first..end);
+    }
+    spans
+}
+
+/// 0-based lines that define `name`.
+fn def_lines(content: &str, format: &FileFormat, path: Option<&Path>, name: &str) -> Vec<usize> {
+    if let FileFormat::Code(lang) = format {
+        if let Some(symbols) = symbols::extract(content, lang, path).filter(|s| !s.is_empty()) {
+            return symbols
+                .iter()
+                .filter(|s| s.name == name || s.name.rsplit(['.', ':']).next() == Some(name))
+                .map(|s| s.line - 1)
+                .collect();
+        }
+    }
+    structural_lines(content, format, path)
+        .into_iter()
+        .filter(|(_, text)| contains_word(text, name))
+        .map(|(n, _)| n - 1)
+        .collect()
+}
+
+fn is_ident(c: char) -> bool {
+    c.is_alphanumeric() || c == '_'
+}
+
+/// Whether `text` contains `word` not directly preceded or followed by an
+/// identifier character.
+pub fn contains_word(text: &str, word: &str) -> bool {
+    if word.is_empty() {
+        return false;
+    }
+    text.match_indices(word).any(|(i, _)| {
+        !text[..i].chars().next_back().map_or(false, is_ident)
+            && !text[i + word.len()..].chars().next().map_or(false, is_ident)
+    })
+}
+
+fn indent(line: &str) -> usize {
+    line.len() - line.trim_start().len()
+}
+
+/// First line of the doc comments and attributes directly above `start`.
+/// A blank line, a section rule such as `// ─── Tests ───`, or a line that
+/// closes an earlier construct (a docstring, `#endif`) ends the run.
+fn leading_start(lines: &[&str], start: usize) -> usize {
+    let mut first = start;
+    while first > 0 && attaches(lines[first - 1].trim_start()) {
+        first -= 1;
+    }
+    first
+}
+
+/// Comment markers, longest first
+const COMMENT_MARKERS: &[&str] = &["///", "//!", "//", "/**", "/*", "*/", "--", "#", "*"];
+
+/// Whether the trimmed `line` is a comment or attribute belonging to the
+/// definition below it.
+fn attaches(line: &str) -> bool {
+    let decoration = ["///", "//!", "//", "#[", "#!", "@", "/**", "/*", "* ", "*/", "--"]
+        .iter()
+        .any(|p| line.starts_with(p))
+        || line == "*"
+        // Python/shell comments, but not preprocessor lines like `#endif`
+        || (line.starts_with('#') && !line[1..].starts_with(|c: char| c.is_alphabetic()));
+    decoration && !is_rule(line)
+}
+
+/// A separator comment: its text opens or closes with a run of rule
+/// characters (`// ─── Tests ───`, `# ----- helpers`) or is nothing else.
+fn is_rule(line: &str) -> bool {
+    let text = COMMENT_MARKERS
+        .iter()
+        .find_map(|m| line.strip_prefix(m))
+        .unwrap_or(line)
+        .trim();
+    let text = text.strip_suffix("*/").unwrap_or(text).trim_end();
+    let rule = |c: char| "─━═-=*#~_".contains(c);
+    let run = |chars: &mut dyn Iterator<Item = char>| chars.take(3).filter(|&c| rule(c)).count() == 3;
+    run(&mut text.chars()) || run(&mut text.chars().rev()) || (!text.is_empty() && text.chars().all(rule))
+}
+
+/// End (exclusive) of a Markdown section: the next heading of the same or
+/// a higher level, outside fenced code.
+fn heading_end(lines: &[&str], start: usize) -> usize {
+    let level = |l: &str| {
+        let t = l.trim_start();
+        let n = t.len() - t.trim_start_matches('#').len();
+        (n > 0 && t[n..].starts_with(' ') || n == t.len()).then_some(n).filter(|&n| n > 0)
+    };
+    let Some(own) = level(lines[start]) else {
+        return start + 1;
+    };
+    let mut fenced = false;
+    for (i, line) in lines.iter().enumerate().skip(start + 1) {
+        let t = line.trim_start();
+        if t.starts_with("```") || t.starts_with("~~~") {
+            fenced = !fenced;
+        } else if !fenced && level(line).map_or(false, |n| n <= own) {
+            return trim_blank(lines, start, i);
+        }
+    }
+    trim_blank(lines, start, lines.len())
+}
+
+/// End (exclusive) of a TOML table: the next table header.
+fn table_end(lines: &[&str], start: usize) -> usize {
+    let next = lines
+        .iter()
+        .enumerate()
+        .skip(start + 1)
+        .find(|(_, l)| l.trim_start().starts_with('['))
+        .map_or(lines.len(), |(i, _)| i);
+    trim_blank(lines, start, next)
+}
+
+/// End (exclusive) of the block indented under `start`, plus a closing
+/// line at the same indent (`end`, `}`, `)`, `]`) if one follows.
+fn indent_end(lines: &[&str], start: usize) -> usize {
+    let own = indent(lines[start]);
+    let mut end = start + 1;
+    while end < lines.len() && (lines[end].trim().is_empty() || indent(lines[end]) > own) {
+        end += 1;
+    }
+    let end = trim_blank(lines, start, end);
+    if let Some(next) = lines.get(end) {
+        let t = next.trim_start();
+        let closes = t.starts_with('}') || t.starts_with(')') || t.starts_with(']') || t == "end" || t.starts_with("end ");
+        if indent(next) == own && closes {
+            return end + 1;
+        }
+    }
+    end
+}
+
+fn trim_blank(lines: &[&str], start: usize, mut end: usize) -> usize {
+    while end > start + 1 && lines[end - 1].trim().is_empty() {
+        end -= 1;
+    }
+    end
+}
+
+/// End (exclusive) of the brace-delimited body opened after `start`, or
+/// of the statement when a `;` comes first. `None` when no body opens
+/// within `SIGNATURE_LINES`. Strings, character literals and comments are
+/// skipped so braces inside them do not count.
+fn brace_end(lines: &[&str], start: usize) -> Option<usize> {
+    let mut depth = 0usize;
+    // () and [] nesting of the signature, where `;` does not end it
+    let mut nesting = 0usize;
+    let mut opened = false;
+    let mut block_comment = false;
+
+    for (i, line) in lines.iter().enumerate().skip(start) {
+        if !opened && i >= start + SIGNATURE_LINES {
+            return None;
+        }
+        let bytes = line.as_bytes();
+        let mut j = 0;
+        while j < bytes.len() {
+            let b = bytes[j];
+            if block_comment {
+                if bytes[j..].starts_with(b"*/") {
+                    block_comment = false;
+                    j += 1;
+                }
+                j += 1;
+                continue;
+            }
+            match b {
+                b'/' if bytes[j..].starts_with(b"//") => break,
+                b'/' if bytes[j..].starts_with(b"/*") => {
+                    block_comment = true;
+                    j += 1;
+                }
+                b'"' | b'`' => j = skip_quoted(bytes, j),
+                // A char literal, not a Rust lifetime or a generic `'a`
+                b'\'' if bytes.get(j + 2) == Some(&b'\'') || bytes.get(j + 1) == Some(&b'\\') => {
+                    j = skip_quoted(bytes, j);
+                }
+                b'(' | b'[' => nesting += 1,
+                b')' | b']' => nesting = nesting.saturating_sub(1),
+                b'{' => {
+                    depth += 1;
+                    opened = true;
+                }
+                b'}' => {
+                    depth = depth.saturating_sub(1);
+                    if opened && depth == 0 {
+                        return Some(i + 1);
+                    }
+                }
+                b';' if !opened && nesting == 0 => return Some(i + 1),
+                _ => {}
+            }
+            j += 1;
+        }
+    }
+    opened.then_some(lines.len())
+}
+
+/// Index of the closing quote of the literal opening at `open`.
+fn skip_quoted(bytes: &[u8], open: usize) -> usize {
+    let quote = bytes[open];
+    let mut j = open + 1;
+    while j < bytes.len() {
+        match bytes[j] {
+            b'\\' => j += 1,
+            b if b == quote => return j,
+            _ => {}
+        }
+        j += 1;
+    }
+    bytes.len()
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn lines(text: &str) -> Vec<&str> {
+        text.lines().collect()
+    }
+
+    #[test]
+    fn test_brace_end() {
+        let src = lines("fn a(x: [u8; 4]) -> u8 {\n    let s = \"}\";\n    // }\n    if x { 1 } else { '}' as u8 }\n}\nfn b() {}\n");
+        assert_eq!(brace_end(&src, 0), Some(5));
+        assert_eq!(brace_end(&src, 5), Some(6));
+
+        let decl = lines("int f(int a,\n      int b);\nint g() {\n}\n");
+        assert_eq!(brace_end(&decl, 0), Some(2));
+
+        let none = lines("def f(x):\n    return {1: 2}\n");
+        assert_eq!(brace_end(&none[..1], 0), None);
+    }
+
+    #[test]
+    fn test_indent_end() {
+        let py = lines("class A:\n    def f(self):\n        pass\n\n    x = 1\n\ndef g():\n    pass\n");
+        assert_eq!(indent_end(&py, 0), 5);
+        assert_eq!(indent_end(&py, 1), 3);
+
+        let rb = lines("def f\n  1\nend\ndef g\nend\n");
+        assert_eq!(indent_end(&rb, 0), 3);
+    }
+
+    #[test]
+    fn test_heading_end() {
+        let md = lines("# A\n## B\ntext\n```\n# not a heading\n```\n## C\n# D\n");
+        assert_eq!(heading_end(&md, 1), 6);
+        assert_eq!(heading_end(&md, 0), 7);
+        assert_eq!(heading_end(&md, 7), 8);
+    }
+
+    #[test]
+    fn test_leading_start() {
+        let src = lines("use x;\n\n/// Docs\n#[inline]\nfn f() {}\n");
+        assert_eq!(leading_start(&src, 4), 2);
+        assert_eq!(leading_start(&src, 0), 0);
+
+        // A section rule directly above the docs is not part of them
+        let rust = lines("}\n// ─── Tests ───\n/// Docs\nfn f() {}\n");
+        assert_eq!(leading_start(&rust, 3), 2);
+
+        // The previous function's closing docstring, then a decorator
+        let py = lines("def a():\n    \"\"\"Doc.\n    \"\"\"\n@cache\n# Why\ndef b():\n");
+        assert_eq!(leading_start(&py, 5), 3);
+
+        let c = lines("#ifdef X\n#endif\n/* Adds. */\nint add(int a, int b);\n");
+        assert_eq!(leading_start(&c, 3), 2);
+    }
+
+    #[test]
+    fn test_contains_word() {
+        assert!(contains_word("fn parse(x)", "parse"));
+        assert!(!contains_word("fn parse_all(x)", "parse"));
+        assert!(!contains_word("fn reparse(x)", "parse"));
+        assert!(!contains_word("anything", ""));
+    }
+
+    #[test]
+    fn test_find_markdown_and_toml() {
+        let md = "# Intro\ntext\n## Usage\nrun it\n\n## Other\n";
+        assert_eq!(find(md, &FileFormat::Markdown, None, "Usage"), vec![2..4]);
+
+        let toml = "[package]\nname = \"x\"\n\n[dependencies]\nserde = \"1\"\n";
+        assert_eq!(find(toml, &FileFormat::Toml, None, "package"), vec![0..2]);
+        assert_eq!(find(toml, &FileFormat::Toml, None, "dependencies"), vec![3..5]);
+    }
+}
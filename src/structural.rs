@@ -0,0 +1,235 @@
+//! SIMD structural-character scanning for JSON
+//!
+//! Classifies 64-byte blocks at a time into a bitmask of the bytes that
+//! matter for structure (`{}[]:,"\`), so whole subtrees can be skipped
+//! without visiting every byte in scalar code. Uses SSE2 on x86_64 and a
+//! portable scalar fallback elsewhere and for the tail of the input.
+
+const BLOCK: usize = 64;
+
+/// Bitmask with bit `i` set when `block[i]` is a structural byte.
+/// Blocks shorter than 64 bytes are allowed; missing bytes read as zero bits.
+#[inline]
+pub fn structural_mask(block: &[u8]) -> u64 {
+    #[cfg(target_arch = "x86_64")]
+    {
+        if block.len() == BLOCK {
+            // SAFETY: SSE2 is part of the x86_64 baseline and the block is 64 bytes long.
+            return unsafe { sse2::mask64(block) };
+        }
+    }
+    scalar_mask(block)
+}
+
+fn scalar_mask(block: &[u8]) -> u64 {
+    let mut mask = 0u64;
+    for (i, &b) in block.iter().take(BLOCK).enumerate() {
+        if is_structural(b) {
+            mask |= 1 << i;
+        }
+    }
+    mask
+}
+
+#[inline]
+fn is_structural(b: u8) -> bool {
+    matches!(b, b'{' | b'}' | b'[' | b']' | b':' | b',' | b'"' | b'\\')
+}
+
+#[cfg(target_arch = "x86_64")]
+mod sse2 {
+    use std::arch::x86_64::*;
+
+    const NEEDLES: [u8; 8] = [b'{', b'}', b'[', b']', b':', b',', b'"', b'\\'];
+
+    #[inline]
+    #[target_feature(enable = "sse2")]
+    pub unsafe fn mask64(block: &[u8]) -> u64 {
+        let mut mask = 0u64;
+        for lane in 0..4 {
+            let v = _mm_loadu_si128(block.as_ptr().add(lane * 16) as *const __m128i);
+            let mut hits = _mm_setzero_si128();
+            for &n in NEEDLES.iter() {
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8(n as i8)));
+            }
+            mask |= (_mm_movemask_epi8(hits) as u16 as u64) << (lane * 16);
+        }
+        mask
+    }
+}
+
+/// Calls `f(pos, byte)` for every structural byte outside string literals
+/// from `start` on, plus the quotes that open and close strings. Escaped
+/// characters inside strings are never reported. Stops when `f` returns
+/// `false` and yields that position, or `bytes.len()` at end of input.
+#[inline]
+pub fn scan<F: FnMut(usize, u8) -> bool>(bytes: &[u8], start: usize, mut f: F) -> usize {
+    let mut in_string = false;
+    // Positions below this are consumed by a backslash escape
+    let mut skip_to = start;
+    let mut base = start;
+
+    while base < bytes.len() {
+        let end = (base + BLOCK).min(bytes.len());
+        let mut mask = structural_mask(&bytes[base..end]);
+
+        while mask != 0 {
+            let pos = base + mask.trailing_zeros() as usize;
+            mask &= mask - 1;
+            if pos < skip_to {
+                continue;
+            }
+            let b = bytes[pos];
+            if in_string {
+                match b {
+                    b'\\' => skip_to = pos + 2,
+                    b'"' => {
+                        in_string = false;
+                        if !f(pos, b) {
+                            return pos;
+                        }
+                    }
+                    _ => {}
+                }
+                continue;
+            }
+            if b == b'"' {
+                in_string = true;
+            }
+            if !f(pos, b) {
+                return pos;
+            }
+        }
+        base = end;
+    }
+    bytes.len()
+}
+
+/// Index just past the closing quote of the string opening at `start`.
+pub fn skip_string(bytes: &[u8], start: usize) -> usize {
+    let mut opened = false;
+    let end = scan(bytes, start, |_, b| {
+        if b == b'"' && !opened {
+            opened = true;
+            return true;
+        }
+        b != b'"'
+    });
+    (end + 1).min(bytes.len())
+}
+
+/// Skip the container opening at `start`. Returns the index just past its
+/// closing bracket and the number of direct children (keys or items).
+pub fn skip_container(bytes: &[u8], start: usize) -> (usize, usize) {
+    let mut depth = 0usize;
+    let mut commas = 0usize;
+    let mut last = start;
+
+    let end = scan(bytes, start, |pos, b| {
+        match b {
+            b'{' | b'[' => depth += 1,
+            b'}' | b']' => {
+                depth -= 1;
+                if depth == 0 {
+                    return false;
+                }
+            }
+            b',' if depth == 1 => commas += 1,
+            _ => {}
+        }
+        last = pos;
+        true
+    });
+
+    // Empty unless something other than whitespace follows the opener
+    let inner_start = start + 1;
+    let inner_end = end.min(bytes.len());
+    let non_empty = commas > 0
+        || last > start
+        || bytes[inner_start.min(inner_end)..inner_end]
+            .iter()
+            .any(|b| !b.is_ascii_whitespace());
+    let count = if non_empty { commas + 1 } else { 0 };
+    ((end + 1).min(bytes.len()), count)
+}
+
+/// Index just past the JSON value starting at `start` (which must not be
+/// whitespace): a container, a string, or a bare scalar.
+pub fn skip_value(bytes: &[u8], start: usize) -> usize {
+    match bytes.get(start) {
+        Some(b'{') | Some(b'[') => skip_container(bytes, start).0,
+        Some(b'"') => skip_string(bytes, start),
+        Some(_) => {
+            let mut i = start;
+            while i < bytes.len() && !is_delimiter(bytes[i]) {
+                i += 1;
+            }
+            i
+        }
+        None => start,
+    }
+}
+
+/// Index of the first non-whitespace byte at or after `i`.
+#[inline]
+pub fn skip_whitespace(bytes: &[u8], mut i: usize) -> usize {
+    while i < bytes.len() && bytes[i].is_ascii_whitespace() {
+        i += 1;
+    }
+    i
+}
+
+/// Bytes that end a bare scalar (number, `true`, `null`, ...).
+#[inline]
+pub fn is_delimiter(b: u8) -> bool {
+    matches!(b, b'{' | b'}' | b'[' | b']' | b',' | b':' | b'"') || b.is_ascii_whitespace()
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_mask_matches_scalar() {
+        let mut block: Vec<u8> = br#"{"key": [1, 2, "a\"b"], "x": {}}"#.to_vec();
+        block.resize(64, b' ');
+        block[63] = b']';
+        assert_eq!(structural_mask(&block), scalar_mask(&block));
+        assert_eq!(structural_mask(b"{}"), 0b11);
+    }
+
+    #[test]
+    fn test_skip_string_with_escapes() {
+        let s = br#""a\"b\\" tail"#;
+        assert_eq!(skip_string(s, 0), 8);
+    }
+
+    #[test]
+    fn test_skip_container_across_blocks() {
+        let mut json = String::from("[");
+        for i in 0..100 {
+            json.push_str(&format!("{{\"k\": \"v{}\\\"]\"}},", i));
+        }
+        json.push_str("null]");
+        let (end, count) = skip_container(json.as_bytes(), 0);
+        assert_eq!(end, json.len());
+        assert_eq!(count, 101);
+    }
+
+    #[test]
+    fn test_skip_container_counts_children() {
+        let json = br#"{"a": [1, 2, {"x": ","}], "b": "}", "c": {}}"#;
+        assert_eq!(skip_container(json, 0), (json.len(), 3));
+        assert_eq!(skip_container(b"[ ]", 0), (3, 0));
+        assert_eq!(skip_container(b"[7]", 0), (3, 1));
+    }
+
+    #[test]
+    fn test_skip_value_scalars() {
+        assert_eq!(skip_value(b"123, 4", 0), 3);
+        assert_eq!(skip_value(b"true}", 0), 4);
+        assert_eq!(skip_value(br#""x" :"#, 0), 3);
+    }
+}
@@ -0,0 +1,282 @@
+//! Definition symbols from syntect scopes (brief mode)
+//!
+//! Runs the syntect parser alone, producing scope operations without any
+//! theme styling. Every `entity.name.*` definition (function, class,
+//! struct, …) is recorded with its line. This works the same across all
+//! bundled syntaxes and catches multi-line signatures that keyword prefixes
+//! miss, without flagging statements like `return foo(x)`.
+//!
+//! Results for files on disk are cached per path, together with the hash
+//! of the content they came from, so outlining an unchanged file again
+//! costs one hash and one small read. Stdin is never cached.
+
+use std::path::Path;
+use std::time::Duration;
+
+use syntect::parsing::{ParseState, Scope, ScopeStack, ScopeStackOp, SyntaxReference, SyntaxSet};
+use syntect::util::LinesWithEndings;
+
+use crate::cache;
+use crate::render::code::{find_syntax, syntax_set};
+
+/// Files larger than this are only outlined from cache; parsing them with
+/// syntect would cost far more than the keyword fallback.
+const PARSE_LIMIT: usize = 8 << 20;
+
+const CACHE_BUCKET: &str = "symbols";
+
+/// Entries not rewritten for this long are pruned
+const CACHE_MAX_AGE: Duration = Duration::from_secs(30 * 24 * 60 * 60);
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum SymbolKind {
+    Function,
+    Class,
+    Struct,
+    Enum,
+    Trait,
+    Impl,
+    Type,
+    Module,
+    Macro,
+    Constant,
+}
+
+/// Definition scopes, matched by prefix, and the symbol kind they yield.
+const DEFINITIONS: &[(&str, SymbolKind)] = &[
+    ("entity.name.function", SymbolKind::Function),
+    ("entity.name.method", SymbolKind::Function),
+    ("entity.name.class", SymbolKind::Class),
+    ("entity.name.struct", SymbolKind::Struct),
+    ("entity.name.union", SymbolKind::Struct),
+    ("entity.name.enum", SymbolKind::Enum),
+    ("entity.name.trait", SymbolKind::Trait),
+    ("entity.name.interface", SymbolKind::Trait),
+    ("entity.name.protocol", SymbolKind::Trait),
+    ("entity.name.impl", SymbolKind::Impl),
+    ("entity.name.type", SymbolKind::Type),
+    ("entity.name.namespace", SymbolKind::Module),
+    ("entity.name.module", SymbolKind::Module),
+    ("entity.name.package", SymbolKind::Module),
+    ("entity.name.macro", SymbolKind::Macro),
+    ("entity.name.constant", SymbolKind::Constant),
+];
+
+impl SymbolKind {
+    pub fn as_str(self) -> &'static str {
+        match self {
+            SymbolKind::Function => "function",
+            SymbolKind::Class => "class",
+            SymbolKind::Struct => "struct",
+            SymbolKind::Enum => "enum",
+            SymbolKind::Trait => "trait",
+            SymbolKind::Impl => "impl",
+            SymbolKind::Type => "type",
+            SymbolKind::Module => "module",
+            SymbolKind::Macro => "macro",
+            SymbolKind::Constant => "constant",
+        }
+    }
+
+    fn from_str(s: &str) -> Option<SymbolKind> {
+        DEFINITIONS.iter().map(|&(_, k)| k).find(|k| k.as_str() == s)
+    }
+}
+
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct Symbol {
+    /// 1-based line of the name
+    pub line: usize,
+    pub kind: SymbolKind,
+    pub name: String,
+}
+
+/// Definition symbols of `content` in line order, or `None` when syntect
+/// has no real syntax for `lang` (or the file is too large to parse and
+/// not cached yet), in which case callers fall back to keyword matching.
+/// `path` names the file `content` was read from; without one nothing is
+/// cached.
+pub fn extract(content: &str, lang: &str, path: Option<&Path>) -> Option<Vec<Symbol>> {
+    let entry = path.map(|path| {
+        let path = path.canonicalize().unwrap_or_else(|_| path.to_path_buf());
+        let name = cache::key(&[path.as_os_str().as_encoded_bytes(), lang.as_bytes()]);
+        (format!("{:016x}", name), cache::key(&[content.as_bytes()]))
+    });
+    if let Some((name, hash)) = &entry {
+        if let Some(cached) = cache::read(CACHE_BUCKET, name).and_then(|b| decode(&b, *hash)) {
+            return Some(cached);
+        }
+    }
+    if content.len() > PARSE_LIMIT {
+        return None;
+    }
+
+    let ss = syntax_set();
+    let syntax = find_syntax(ss, lang);
+    if syntax.name == "Plain Text" {
+        return None;
+    }
+    let symbols = parse(content, syntax, ss);
+    if let Some((name, hash)) = entry {
+        cache::write(CACHE_BUCKET, &name, encode(&symbols, hash).as_bytes());
+        cache::prune(CACHE_BUCKET, CACHE_MAX_AGE);
+    }
+    Some(symbols)
+}
+
+fn parse(content: &str, syntax: &SyntaxReference, ss: &SyntaxSet) -> Vec<Symbol> {
+    let definitions: Vec<(Scope, SymbolKind)> = DEFINITIONS
+        .iter()
+        .filter_map(|&(name, kind)| Scope::new(name).ok().map(|s| (s, kind)))
+        .collect();
+
+    let mut state = ParseState::new(syntax);
+    let mut stack = ScopeStack::new();
+    let mut symbols = Vec::new();
+
+    for (i, line) in LinesWithEndings::from(content).enumerate() {
+        let ops = match state.parse_line(line, ss) {
+            Ok(ops) => ops,
+            // A broken syntax definition: keep what was found so far
+            Err(_) => break,
+        };
+        // Open definition scope: stack depth it was pushed at, start offset, kind
+        let mut open: Option<(usize, usize, SymbolKind)> = None;
+
+        for (pos, op) in ops {
+            if stack.apply(&op).is_err() {
+                continue;
+            }
+            match op {
+                ScopeStackOp::Push(scope) if open.is_none() => {
+                    if let Some(&(_, kind)) = definitions.iter().find(|(d, _)| d.is_prefix_of(scope)) {
+                        open = Some((stack.len(), pos, kind));
+                    }
+                }
+                ScopeStackOp::Push(_) => {}
+                _ => {
+                    if let Some((depth, start, kind)) = open {
+                        if stack.len() < depth {
+                            push_symbol(&mut symbols, i + 1, kind, line.get(start..pos));
+                            open = None;
+                        }
+                    }
+                }
+            }
+        }
+        // Names never span lines; close anything still open at the end
+        if let Some((_, start, kind)) = open {
+            push_symbol(&mut symbols, i + 1, kind, line.get(start..));
+        }
+    }
+    symbols
+}
+
+fn push_symbol(symbols: &mut Vec<Symbol>, line: usize, kind: SymbolKind, name: Option<&str>) {
+    let name = name.unwrap_or("").trim();
+    if !name.is_empty() {
+        symbols.push(Symbol {
+            line,
+            kind,
+            name: name.to_string(),
+        });
+    }
+}
+
+/// Cache format: the content hash as 16 hex digits on the first line, then
+/// one `line<TAB>kind<TAB>name` record per line.
+fn encode(symbols: &[Symbol], hash: u64) -> String {
+    let mut text = format!("{:016x}\n", hash);
+    for s in symbols {
+        text.push_str(&format!("{}\t{}\t{}\n", s.line, s.kind.as_str(), s.name));
+    }
+    text
+}
+
+/// The symbols of an entry, if it was taken from content with `hash`.
+fn decode(bytes: &[u8], hash: u64) -> Option<Vec<Symbol>> {
+    let text = std::str::from_utf8(bytes).ok()?;
+    let mut lines = text.lines();
+    if u64::from_str_radix(lines.next()?, 16).ok()? != hash {
+        return None;
+    }
+    lines
+        .map(|record| {
+            let mut fields = record.splitn(3, '\t');
+            Some(Symbol {
+                line: fields.next()?.parse().ok()?,
+                kind: SymbolKind::from_str(fields.next()?)?,
+                name: fields.next()?.to_string(),
+            })
+        })
+        .collect()
+}
+
+// ─── Tests ───
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_cache_round_trip() {
+        let symbols = vec![
+            Symbol {
+                line: 3,
+                kind: SymbolKind::Function,
+                name: "parse_porcelain".into(),
+            },
+            Symbol {
+                line: 40,
+                kind: SymbolKind::Impl,
+                name: "Foo<T>".into(),
+            },
+        ];
+        let encoded = encode(&symbols, 0xfeed);
+        assert_eq!(decode(encoded.as_bytes(), 0xfeed), Some(symbols));
+        // Written for other content
+        assert_eq!(decode(encoded.as_bytes(), 0xbeef), None);
+        assert_eq!(decode(b"000000000000feed\n", 0xfeed), Some(Vec::new()));
+        assert_eq!(decode(b"", 0xfeed), None);
+        assert_eq!(decode(b"000000000000feed\nx\tfunction\tf\n", 0xfeed), None);
+        assert_eq!(decode(b"000000000000feed\n1\tbogus\tf\n", 0xfeed), None);
+    }
+
+    #[test]
+    fn test_kind_names_round_trip() {
+        for &(_, kind) in DEFINITIONS {
+            assert_eq!(SymbolKind::from_str(kind.as_str()), Some(kind));
+        }
+    }
+
+    fn outline(content: &str, lang: &str) -> Vec<(usize, SymbolKind, String)> {
+        let ss = syntax_set();
+        parse(content, find_syntax(ss, lang), ss)
+            .into_iter()
+            .map(|s| (s.line, s.kind, s.name))
+            .collect()
+    }
+
+    #[test]
+    fn test_extract_rust_and_python() {
+        let rust = "struct Point {\n    x: i32,\n}\n\nimpl Point {\n    fn new() -> Self {\n        Point { x: 0 }\n    }\n}\n\nenum Shape {\n    Dot,\n}\n";
+        assert_eq!(
+            outline(rust, "Rust"),
+            vec![
+                (1, SymbolKind::Struct, "Point".to_string()),
+                (5, SymbolKind::Impl, "Point".to_string()),
+                (6, SymbolKind::Function, "new".to_string()),
+                (11, SymbolKind::Enum, "Shape".to_string()),
+            ]
+        );
+
+        let python = "class Shape:\n    def area(self):\n        return compute(self)\n";
+        assert_eq!(
+            outline(python, "Python"),
+            vec![
+                (1, SymbolKind::Class, "Shape".to_string()),
+                (2, SymbolKind::Function, "area".to_string()),
+            ]
+        );
+    }
+}